@@ -0,0 +1,28 @@
+// Counts every heap allocation of the process through replacements of the global operator new. USAGE:
+/*
+#include "AllocationCounter.h"              // In exactly one translation unit of the executable
+const uint64_t before = globalAllocations.load();
+runTheCodeUnderTest();
+const uint64_t allocations = globalAllocations.load() - before;  // All threads
+*/
+// The replacements can't be inline: a second translation unit including this header breaks the link.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+std::atomic<uint64_t> globalAllocations{0};
+
+void* operator new(std::size_t size) {
+  globalAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,106 @@
+// HDR-style latency histogram with constant memory and ~1% relative precision. USAGE:
+/*
+#include "LatencyHistogram.h"
+LatencyHistogram histogram;               // One allocation here, none in record()
+histogram.record(latencyNs);              // O(1)
+histogram.merge(otherThreadHistogram);    // Histograms from different threads are merged after the run
+histogram.percentile(99.9);               // Value at the given percentile (upper bound of the bucket)
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class LatencyHistogram {
+ public:
+  // Values below subBucketCount are stored exactly. Every power-of-two range above is split into
+  // subBucketCount / 2 linear buckets, so the error of any recorded value is below 2 / subBucketCount.
+  static constexpr unsigned subBucketBits = 7;
+  static constexpr uint64_t subBucketCount = uint64_t{1} << subBucketBits;
+  static constexpr uint64_t subBucketHalf = subBucketCount / 2;
+  static constexpr std::size_t bucketCount = subBucketCount + (64 - subBucketBits) * subBucketHalf;
+
+  LatencyHistogram() : counts_(bucketCount, 0) {}
+
+  void record(uint64_t value) {
+    ++counts_[indexOf(value)];
+    ++total_;
+    sum_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  void merge(const LatencyHistogram& other) {
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+
+  void reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_ = 0;
+    sum_ = 0;
+    min_ = std::numeric_limits<uint64_t>::max();
+    max_ = 0;
+  }
+
+  uint64_t count() const { return total_; }
+
+  uint64_t min() const { return total_ ? min_ : 0; }
+
+  uint64_t max() const { return max_; }
+
+  double mean() const { return total_ ? static_cast<double>(sum_) / total_ : 0.0; }
+
+  // `p` is in percents: 50, 99, 99.9...
+  uint64_t percentile(double p) const {
+    if (total_ == 0) return 0;
+
+    auto rank = static_cast<uint64_t>(p / 100.0 * total_);
+    rank = std::clamp<uint64_t>(rank, 1, total_);
+
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        return std::clamp(valueOf(i + 1) - 1, min_, max_);  // Highest value equivalent to the bucket
+      }
+    }
+    return max_;
+  }
+
+ private:
+  static std::size_t indexOf(uint64_t value) {
+    if (value < subBucketCount) return static_cast<std::size_t>(value);
+
+    const unsigned msb = std::bit_width(value) - 1;  // >= subBucketBits
+    const unsigned shift = msb - (subBucketBits - 1);
+    const uint64_t sub = value >> shift;  // In [subBucketHalf, subBucketCount)
+    return static_cast<std::size_t>(subBucketCount + (shift - 1) * subBucketHalf + (sub - subBucketHalf));
+  }
+
+  // Lower bound of the values stored in the bucket
+  static uint64_t valueOf(std::size_t index) {
+    if (index < subBucketCount) return index;
+
+    const uint64_t offset = index - subBucketCount;
+    const unsigned shift = static_cast<unsigned>(offset / subBucketHalf) + 1;
+    const uint64_t sub = offset % subBucketHalf + subBucketHalf;
+    return sub << shift;
+  }
+
+  std::vector<uint64_t> counts_;
+  uint64_t total_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ = 0;
+};
@@ -0,0 +1,112 @@
+#include "MappedFile.h"
+
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+[[noreturn]] void throwLastError(const std::string& what) {
+  throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+}
+#else
+[[noreturn]] void throwLastError(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+#endif
+
+}  // namespace
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) {
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) throwLastError("Can't open " + path);
+
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    throwLastError("Can't get the size of " + path);
+  }
+  if (size.QuadPart == 0) {
+    CloseHandle(file);
+    return;
+  }
+
+  // The view keeps the mapping and the file alive, both handles can be closed right away
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (!mapping) throwLastError("Can't map " + path);
+  const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!view) throwLastError("Can't map " + path);
+
+  data_ = static_cast<const uint8_t*>(view);
+  size_ = static_cast<std::size_t>(size.QuadPart);
+}
+
+void MappedFile::unmap() {
+  if (data_) UnmapViewOfFile(data_);
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) throwLastError("Can't open " + path);
+
+  struct stat status {};
+  if (::fstat(fd, &status) != 0) {
+    ::close(fd);
+    throwLastError("Can't get the size of " + path);
+  }
+  if (status.st_size == 0) {
+    ::close(fd);
+    return;
+  }
+
+  // The mapping keeps the file alive, the descriptor can be closed right away
+  void* view = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (view == MAP_FAILED) throwLastError("Can't map " + path);
+
+  data_ = static_cast<const uint8_t*>(view);
+  size_ = static_cast<std::size_t>(status.st_size);
+}
+
+void MappedFile::unmap() {
+  if (data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    unmap();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() { unmap(); }
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file: mmap on POSIX, MapViewOfFile on Windows.
+// The file is mapped once, at construction. Bytes appended later are not visible, map the file again to see them.
+// An empty file has no mapping: data() is nullptr, size() is 0.
+// USAGE EXAMPLE:
+// MappedFile file("monsters.log");
+// auto monster = MyGame::Sample::GetMonster(file.data() + offset);  // Zero copy, pages are loaded on first touch
+class MappedFile {
+ public:
+  MappedFile() = default;
+
+  // Throws std::system_error if the file can't be opened or mapped.
+  explicit MappedFile(const std::string& path);
+
+  MappedFile(MappedFile&& other) noexcept;
+
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  MappedFile(const MappedFile&) = delete;
+
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile();
+
+  const uint8_t* data() const { return data_; }
+
+  std::size_t size() const { return size_; }
+
+ private:
+  void unmap();
+
+  const uint8_t* data_ = nullptr;
+  std::size_t size_ = 0;
+};
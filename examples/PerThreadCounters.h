@@ -0,0 +1,23 @@
+// Counters of one thread (one event loop), written by that thread only and read by any other. USAGE:
+/*
+#include "PerThreadCounters.h"
+struct alignas(cacheLineSize) LoopStats {  // One per loop
+  std::atomic<uint64_t> echoes{0};
+};
+add(stats.echoes, uint64_t{1});           // Only from the loop of `stats`
+stats.echoes.load(std::memory_order_relaxed);  // From any thread
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Per-thread counters aligned to it get one cache line each: the threads never write to the same line
+inline constexpr std::size_t cacheLineSize = 64;
+
+// Single writer: a plain load and store, no locked instruction on the hot path
+template <typename T>
+void add(std::atomic<T>& counter, T value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
@@ -0,0 +1,347 @@
+// Load generator for the sharded async chat server.
+//
+// For every requested shard count the server from `../server/ChatServer.h` is started in-process,
+// `clients` connections join the room and `senders` of them publish timestamped messages.
+// Every message is fanned out to all clients. The benchmark reports delivered messages per second,
+// fan-out latency percentiles (time between send and receive, measured on every client)
+// and heap allocations per broadcast (the client side is allocation free in steady state,
+// so the number shows the cost of the server's fan-out path).
+// Every shard count is measured with asio's default handler allocator and with HandlerSlab.
+//
+// Message format (one line per message): "<senderId> <sequence> <sendTimeNs> <padding>\n"
+
+#include <algorithm>
+#include <asio.hpp>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "cxxopts.hpp"
+
+#define DEBUG_LOG_DISABLE_DEBUG_LEVEL
+#include "../../../AllocationCounter.h"
+#include "../../../DebugLog.h"
+#include "../../../LatencyHistogram.h"
+#include "../../common/HandlerAllocator.h"
+#include "../server/ChatServer.h"
+
+using asio::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+  unsigned short port = 12345;
+  std::size_t clients = 64;
+  std::size_t senders = 4;
+  std::size_t messagesPerSender = 10000;
+  std::size_t window = 16;  // Messages in flight per sender
+  std::size_t payload = 64;
+  std::size_t clientThreads = 2;
+  std::chrono::seconds timeout{30};
+  OutboundQueue::Limits outboundLimits;
+};
+
+struct BenchResult {
+  double messagesPerSec = 0;
+  double allocationsPerBroadcast = 0;
+  double allocationsPerSec = 0;
+  uint64_t delivered = 0;
+  uint64_t expected = 0;
+  uint64_t malformed = 0;
+  double p50us = 0;
+  double p99us = 0;
+  double p999us = 0;
+};
+
+int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Shared between all clients of one run
+struct RunState {
+  std::atomic<uint64_t> delivered{0};
+  std::atomic<uint64_t> malformed{0};
+  uint64_t expected = 0;
+  std::atomic<int64_t> finishedAtNs{0};
+};
+
+class BenchClient {
+ public:
+  BenchClient(asio::io_context& io_context, std::size_t id, bool isSender, const BenchConfig& config, RunState& state,
+              LatencyHistogram& histogram)
+      : socket_(io_context), id_(id), isSender_(isSender), config_(config), state_(state), histogram_(histogram) {
+    if (isSender_) {
+      // At most `window` messages are in flight, so the slots are reused without allocations.
+      slots_.resize(config_.window);
+      for (auto& slot : slots_) slot.reserve(std::max<std::size_t>(config_.payload, 64));
+    }
+  }
+
+  void connect(const tcp::endpoint& endpoint) {
+    socket_.connect(endpoint);
+    socket_.set_option(tcp::no_delay(true));
+  }
+
+  // Must be called from the client's io_context thread (or before it runs)
+  void start() {
+    doRead();
+    if (isSender_) {
+      for (std::size_t i = 0; i < config_.window && sent_ < config_.messagesPerSender; ++i) {
+        sendNext();
+      }
+    }
+  }
+
+  void close() {
+    std::error_code ignored;
+    socket_.close(ignored);
+  }
+
+ private:
+  void fillSlot(std::string& slot) {
+    char header[64];
+    char* p = header;
+    char* end = header + sizeof(header);
+    p = std::to_chars(p, end, id_).ptr;
+    *p++ = ' ';
+    p = std::to_chars(p, end, sent_).ptr;
+    *p++ = ' ';
+    p = std::to_chars(p, end, nowNs()).ptr;
+    *p++ = ' ';
+
+    slot.assign(header, p);
+    if (slot.size() + 1 < config_.payload) {
+      slot.append(config_.payload - slot.size() - 1, 'x');
+    }
+    slot.push_back('\n');
+  }
+
+  void sendNext() {
+    fillSlot(slots_[sent_ % slots_.size()]);
+    ++sent_;
+
+    // Writes are serialized: the next one starts when the previous one completes
+    if (written_ + 1 == sent_) {
+      doWrite();
+    }
+  }
+
+  void doWrite() {
+    asio::async_write(socket_, asio::buffer(slots_[written_ % slots_.size()]),
+                      [this](std::error_code ec, std::size_t) {
+                        if (ec) return;
+                        if (++written_ < sent_) doWrite();
+                      });
+  }
+
+  void doRead() {
+    socket_.async_read_some(asio::buffer(readBuf_),
+                            [this](std::error_code ec, std::size_t length) {
+                              if (ec) return;
+                              onData(length);
+                              doRead();
+                            });
+  }
+
+  void onData(std::size_t length) {
+    pending_.append(readBuf_, length);
+
+    std::size_t start = 0;
+    for (auto pos = pending_.find('\n'); pos != std::string::npos; pos = pending_.find('\n', start)) {
+      onLine(std::string_view(pending_).substr(start, pos - start));
+      start = pos + 1;
+    }
+    pending_.erase(0, start);
+  }
+
+  void onLine(std::string_view line) {
+    uint64_t sender = 0;
+    uint64_t sequence = 0;
+    int64_t sendTimeNs = 0;
+
+    const char* end = line.data() + line.size();
+    auto r = std::from_chars(line.data(), end, sender);
+    if (r.ec == std::errc() && r.ptr != end) r = std::from_chars(r.ptr + 1, end, sequence);
+    if (r.ec == std::errc() && r.ptr != end) r = std::from_chars(r.ptr + 1, end, sendTimeNs);
+    if (r.ec != std::errc() || sendTimeNs == 0) {
+      state_.malformed.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    histogram_.record(static_cast<uint64_t>(nowNs() - sendTimeNs));
+
+    if (state_.delivered.fetch_add(1, std::memory_order_relaxed) + 1 == state_.expected) {
+      state_.finishedAtNs.store(nowNs(), std::memory_order_release);
+    }
+
+    // Own message came back: the window has a free slot
+    if (isSender_ && sender == id_ && sent_ < config_.messagesPerSender) {
+      sendNext();
+    }
+  }
+
+  tcp::socket socket_;
+  std::size_t id_;
+  bool isSender_;
+  const BenchConfig& config_;
+  RunState& state_;
+
+  LatencyHistogram& histogram_;  // Shared by all clients of one thread
+
+  std::size_t sent_ = 0;
+  std::size_t written_ = 0;
+  std::vector<std::string> slots_;
+  char readBuf_[64 * 1024];
+  std::string pending_;
+};
+
+BenchResult runOnce(std::size_t shardCount, const BenchConfig& config) {
+  ChatServer server(config.port, shardCount, config.outboundLimits);
+  server.runInBackground();
+
+  RunState state;
+  state.expected = config.clients * config.senders * config.messagesPerSender;
+
+  std::vector<std::unique_ptr<asio::io_context>> contexts;
+  std::vector<LatencyHistogram> histograms(std::max<std::size_t>(1, config.clientThreads));
+  for (std::size_t i = 0; i < histograms.size(); ++i) {
+    contexts.push_back(std::make_unique<asio::io_context>());
+  }
+
+  // Connect everybody before the first message is published, otherwise late joiners miss messages.
+  tcp::endpoint endpoint(asio::ip::make_address("127.0.0.1"), config.port);
+  std::vector<std::unique_ptr<BenchClient>> clients;
+  for (std::size_t i = 0; i < config.clients; ++i) {
+    auto& context = *contexts[i % contexts.size()];
+    auto& histogram = histograms[i % contexts.size()];
+    clients.push_back(std::make_unique<BenchClient>(context, i, i < config.senders, config, state, histogram));
+    clients.back()->connect(endpoint);
+  }
+  while (server.sessionCount() < config.clients) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  const uint64_t allocationsAtStart = globalAllocations.load();
+  const int64_t startNs = nowNs();
+  for (auto& client : clients) {
+    client->start();
+  }
+
+  std::vector<std::thread> threads;
+  for (auto& context : contexts) {
+    threads.emplace_back([&context]() { context->run(); });
+  }
+
+  const auto deadline = Clock::now() + config.timeout;
+  while (state.finishedAtNs.load(std::memory_order_acquire) == 0 && Clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  int64_t endNs = state.finishedAtNs.load(std::memory_order_acquire);
+  if (endNs == 0) endNs = nowNs();  // Timeout: some messages were lost or malformed
+  const uint64_t allocations = globalAllocations.load() - allocationsAtStart;
+
+  for (auto& context : contexts) {
+    context->stop();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  LatencyHistogram latencies;
+  for (auto& histogram : histograms) {
+    latencies.merge(histogram);
+  }
+  for (auto& client : clients) {
+    client->close();
+  }
+
+  BenchResult result;
+  result.delivered = state.delivered.load();
+  result.expected = state.expected;
+  result.malformed = state.malformed.load();
+  result.messagesPerSec = result.delivered / ((endNs - startNs) / 1e9);
+  result.allocationsPerBroadcast = static_cast<double>(allocations) / (config.senders * config.messagesPerSender);
+  result.allocationsPerSec = allocations / ((endNs - startNs) / 1e9);
+  result.p50us = latencies.percentile(50) / 1000.0;
+  result.p99us = latencies.percentile(99) / 1000.0;
+  result.p999us = latencies.percentile(99.9) / 1000.0;
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "Fan-out load generator for the sharded async chat server");
+  // clang-format off
+  options.add_options()
+      ("s,shards", "Shard counts to benchmark", cxxopts::value<std::vector<std::size_t>>()->default_value("1,2,4,8"))
+      ("a,handler-allocators", "Handler allocators to compare: default, slab", cxxopts::value<std::vector<std::string>>()->default_value("default,slab"))
+      ("c,clients", "Connected clients", cxxopts::value<std::size_t>()->default_value("64"))
+      ("p,publishers", "Clients that publish messages", cxxopts::value<std::size_t>()->default_value("4"))
+      ("m,messages", "Messages per publisher", cxxopts::value<std::size_t>()->default_value("10000"))
+      ("w,window", "Messages in flight per publisher", cxxopts::value<std::size_t>()->default_value("16"))
+      ("b,bytes", "Message size in bytes", cxxopts::value<std::size_t>()->default_value("64"))
+      ("t,client-threads", "Threads running the client connections", cxxopts::value<std::size_t>()->default_value("2"))
+      ("port", "Server port", cxxopts::value<unsigned short>()->default_value("12345"))
+      ("high-water-mark", "Outbound bytes queued per session before the slow consumer policy applies", cxxopts::value<std::size_t>()->default_value("4194304"))
+      ("drop", "Drop messages for slow consumers instead of disconnecting them")
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  BenchConfig config;
+  config.port = args["port"].as<unsigned short>();
+  config.clients = args["clients"].as<std::size_t>();
+  config.senders = std::min(args["publishers"].as<std::size_t>(), config.clients);
+  config.messagesPerSender = args["messages"].as<std::size_t>();
+  config.window = std::max<std::size_t>(1, args["window"].as<std::size_t>());
+  config.payload = args["bytes"].as<std::size_t>();
+  config.clientThreads = args["client-threads"].as<std::size_t>();
+  config.outboundLimits.highWaterMarkBytes = args["high-water-mark"].as<std::size_t>();
+  if (args.count("drop")) {
+    config.outboundLimits.overflowPolicy = OutboundQueue::OverflowPolicy::DropNewest;
+  }
+
+  struct Row {
+    std::size_t shards;
+    std::string allocator;
+    BenchResult result;
+  };
+  std::vector<Row> results;
+  try {
+    for (auto shards : args["shards"].as<std::vector<std::size_t>>()) {
+      for (auto& allocator : args["handler-allocators"].as<std::vector<std::string>>()) {
+        std::cout << "Running " << shards << " shard(s) with " << allocator << " handler allocator..." << std::endl;
+        // Safe to switch here: the previous server is destroyed, no handlers are alive
+        HandlerSlab::setEnabled(allocator == "slab");
+        results.push_back({shards, allocator, runOnce(shards, config)});
+      }
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "\nclients=" << config.clients << " publishers=" << config.senders
+            << " messages/publisher=" << config.messagesPerSender << " bytes=" << config.payload << "\n\n";
+  std::cout << std::left << std::setw(8) << "shards" << std::setw(10) << "handler" << std::setw(16) << "msgs/sec"
+            << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(12) << "p99.9 us" << std::setw(16) << "allocs/bcast"
+            << std::setw(16) << "allocs/sec" << "delivered/expected (malformed)" << std::endl;
+  for (auto& [shards, allocator, r] : results) {
+    std::cout << std::left << std::setw(8) << shards << std::setw(10) << allocator << std::setw(16) << std::fixed
+              << std::setprecision(0) << r.messagesPerSec << std::setw(12) << r.p50us << std::setw(12) << r.p99us
+              << std::setw(12) << r.p999us << std::setw(16) << std::setprecision(2) << r.allocationsPerBroadcast
+              << std::setw(16) << std::setprecision(0) << r.allocationsPerSec << r.delivered << "/" << r.expected << " (" << r.malformed << ")" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../../DebugLog.h"
+#include "../../common/FrameDecoder.h"
+#include "../../common/HandlerAllocator.h"
+#include "../../common/OutboundQueue.h"
+#include "../../common/SharedMessage.h"
+#include "../../common/SlotMap.h"
+#include "concurrentqueue.h"
+
+using asio::ip::tcp;
+
+// Forward declarations
+class ClientSession;
+class ChatShard;
+class ChatServer;
+
+// Represents a chat room for managing client sessions and broadcasting messages.
+// Every shard owns its own slice of the room: only sessions living on the shard's io_context are stored here,
+// so the room is never touched by more than one thread.
+class ChatRoom {
+ public:
+  using Handle = SlotMap<std::shared_ptr<ClientSession>>::Handle;
+
+  // O(1). The session keeps the handle and passes it to leave().
+  Handle join(std::shared_ptr<ClientSession> session) {
+    Handle handle = sessions_.insert(std::move(session));
+    size_.store(sessions_.size(), std::memory_order_relaxed);
+    std::cout << "Client joined. Total clients in shard: " << sessions_.size() << std::endl;
+    return handle;
+  }
+
+  // O(1). A stale handle (session already left) is ignored.
+  void leave(Handle handle) {
+    if (!sessions_.erase(handle)) return;
+    size_.store(sessions_.size(), std::memory_order_relaxed);
+    std::cout << "Client left. Total clients in shard: " << sessions_.size() << std::endl;
+  }
+
+  // The message is shared by all sessions: no per-session copies or allocations.
+  // Sessions are stored contiguously, so the broadcast is a linear scan.
+  // Sessions never leave synchronously from deliver(), so the iteration is not invalidated.
+  void deliver(const SharedMessage& msg) {
+    for (auto& session : sessions_) {
+      deliverMessage(session, msg);
+    }
+  }
+
+  // Thread safe. Number of sessions in this slice of the room.
+  std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+ private:
+  // Using a helper to trigger the write on the session
+  void deliverMessage(const std::shared_ptr<ClientSession>& session, const SharedMessage& msg);
+
+  SlotMap<std::shared_ptr<ClientSession>> sessions_;
+  std::atomic<std::size_t> size_{0};
+};
+
+// One io_context, one thread and one slice of the chat room.
+// Messages published by other shards arrive through the lock-free inbox and are delivered on this shard's thread.
+class ChatShard {
+ public:
+  ChatShard(ChatServer& server, std::size_t index, OutboundQueue::Limits outboundLimits, FrameDecoder::Options framing)
+      : server_(server), index_(index), outboundLimits_(outboundLimits), framing_(framing), workGuard_(asio::make_work_guard(io_context_)) {}
+
+  asio::io_context& context() { return io_context_; }
+
+  ChatRoom& room() { return room_; }
+
+  std::size_t index() const { return index_; }
+
+  const OutboundQueue::Limits& outboundLimits() const { return outboundLimits_; }
+
+  const FrameDecoder::Options& framing() const { return framing_; }
+
+  // Called on this shard's thread when one of its sessions received a message.
+  void publish(const SharedMessage& msg);
+
+  // Thread safe. Called by other shards to deliver a message to the local sessions.
+  // The message buffer itself is shared between shards, only the reference is queued.
+  void enqueue(SharedMessage msg) {
+    inbox_.enqueue(std::move(msg));
+
+    // Coalesce wake-ups: only one drain is scheduled no matter how many messages are queued meanwhile.
+    if (!drainScheduled_.exchange(true, std::memory_order_acq_rel)) {
+      asio::post(io_context_, withHandlerAllocator([this]() { drainInbox(); }));
+    }
+  }
+
+  void run() { io_context_.run(); }
+
+  void stop() {
+    workGuard_.reset();
+    io_context_.stop();
+  }
+
+ private:
+  void drainInbox() {
+    // Reset the flag BEFORE draining. A message enqueued after this point schedules a new drain.
+    drainScheduled_.store(false, std::memory_order_release);
+
+    SharedMessage msg;
+    while (inbox_.try_dequeue(msg)) {
+      room_.deliver(msg);
+    }
+  }
+
+  ChatServer& server_;
+  std::size_t index_;
+  OutboundQueue::Limits outboundLimits_;
+  FrameDecoder::Options framing_;
+  asio::io_context io_context_;
+  asio::executor_work_guard<asio::io_context::executor_type> workGuard_;
+  ChatRoom room_;
+  moodycamel::ConcurrentQueue<SharedMessage> inbox_;
+  std::atomic<bool> drainScheduled_{false};
+};
+
+// Represents a single client connection
+class ClientSession : public std::enable_shared_from_this<ClientSession> {
+ public:
+  ClientSession(tcp::socket socket, ChatShard& shard)
+      : socket_(std::move(socket)), shard_(shard), decoder_(shard.framing()), outbox_(shard.outboundLimits()) {}
+
+  void start() {
+    roomHandle_ = shard_.room().join(shared_from_this());
+    doRead();
+  }
+
+  void deliver(const SharedMessage& msg) {
+    if (closed_) return;
+
+    switch (outbox_.push(msg)) {
+      case OutboundQueue::PushResult::Queued:
+        if (!outbox_.writing()) doWrite();  // Otherwise the message is coalesced into the next write
+        break;
+      case OutboundQueue::PushResult::Dropped:
+        debugLog() << "Slow consumer: message dropped" << std::endl;
+        break;
+      case OutboundQueue::PushResult::Overflow:
+        std::cout << "Slow consumer: disconnecting, " << outbox_.stats().queuedBytes << " bytes queued" << std::endl;
+        close();  // The read loop fails and the session leaves the room
+        break;
+    }
+  }
+
+  // Queue depth, bytes in flight, coalescing and drop counters of this session
+  const OutboundQueue::Stats& outboundStats() const { return outbox_.stats(); }
+
+ private:
+  void doWrite() {
+    auto self(shared_from_this());
+
+    // All messages queued so far go out in one gather write (writev)
+    asio::async_write(socket_, outbox_.gatherBuffers(),
+                      withHandlerAllocator(
+                          [this, self]  // Extent lifetime for self. The queue keeps the buffers alive.
+                          (std::error_code ec, std::size_t /*length*/) {
+                            outbox_.completeWrite();
+                            // If error occurs, the session will eventually be dropped by the read loop
+                            if (!ec && outbox_.hasPending()) doWrite();
+                          }));
+  }
+
+  void close() {
+    closed_ = true;
+    std::error_code ignored;
+    socket_.close(ignored);
+  }
+
+  void doRead() {
+    auto self(shared_from_this());
+    socket_.async_read_some(decoder_.prepare(),
+                            withHandlerAllocator(
+                                [this, self]  // Extent lifetime for self
+                                (std::error_code ec, std::size_t length) {
+                                  if (!ec) {
+                                    decoder_.commit(length);
+                                    if (publishFrames()) {
+                                      doRead();  // Wait for next message
+                                      return;
+                                    }
+                                    std::cout << "Frame above " << decoder_.options().maxFrameSize << " bytes: disconnecting" << std::endl;
+                                    close();
+                                  }
+                                  shard_.room().leave(roomHandle_);
+                                }));
+  }
+
+  // Sends every complete frame received so far to everyone (all shards). A partial frame stays in the decoder.
+  // Returns false if the client sent a frame above the limit.
+  bool publishFrames() {
+    FrameDecoder::Frame frame;
+    FrameDecoder::Status status;
+    const char* batchBegin = nullptr;
+    std::size_t batchSize = 0;
+    while ((status = decoder_.next(frame)) == FrameDecoder::Status::Frame) {
+      debugLog() << "Broadcasting: " << frame.payload << std::endl;
+      if (!batchBegin) batchBegin = frame.wire.data();
+      batchSize += frame.wire.size();
+    }
+
+    if (batchSize > 0) {
+      // Frames are adjacent in the decoder's buffer: all frames of this read go out as one message, framing included.
+      SharedMessage msg(std::string_view(batchBegin, batchSize));  // The only allocation per broadcast
+      shard_.publish(msg);
+    }
+    return status != FrameDecoder::Status::TooLarge;
+  }
+
+  tcp::socket socket_;
+  ChatShard& shard_;
+  FrameDecoder decoder_;
+  OutboundQueue outbox_;
+  ChatRoom::Handle roomHandle_;
+  bool closed_ = false;
+};
+
+inline void ChatRoom::deliverMessage(const std::shared_ptr<ClientSession>& session, const SharedMessage& msg) {
+  session->deliver(msg);
+}
+
+// Owns one shard per thread and distributes new connections between them in round-robin order.
+// The acceptor lives on the first shard. Accepted sockets are created directly on the target shard's io_context,
+// so after the handoff the whole session runs on a single thread without any locking.
+class ChatServer {
+ public:
+  ChatServer(short port, std::size_t shardCount, OutboundQueue::Limits outboundLimits = {}, FrameDecoder::Options framing = {}) {
+    if (shardCount == 0) shardCount = 1;
+
+    for (std::size_t i = 0; i < shardCount; ++i) {
+      shards_.push_back(std::make_unique<ChatShard>(*this, i, outboundLimits, framing));
+    }
+
+    acceptor_ = std::make_unique<tcp::acceptor>(shards_.front()->context(), tcp::endpoint(tcp::v4(), port));
+    doAccept();
+  }
+
+  ~ChatServer() { stop(); }
+
+  std::size_t shardCount() const { return shards_.size(); }
+
+  // Thread safe. Total number of joined sessions in all shards.
+  std::size_t sessionCount() const {
+    std::size_t count = 0;
+    for (auto& shard : shards_) {
+      count += shard->room().size();
+    }
+    return count;
+  }
+
+  // Runs the first shard in the calling thread and every other shard in its own background thread.
+  // Blocks until the server is stopped.
+  void run() {
+    startThreads(1);
+    shards_.front()->run();
+    joinThreads();
+  }
+
+  // Runs every shard in a background thread and returns immediately. Used by benchmarks.
+  void runInBackground() { startThreads(0); }
+
+  // Must not be called from a shard thread.
+  void stop() {
+    for (auto& shard : shards_) {
+      shard->stop();
+    }
+    joinThreads();
+  }
+
+  // Forwards a message published on shard `origin` to every other shard.
+  void forward(std::size_t origin, const SharedMessage& msg) {
+    for (auto& shard : shards_) {
+      if (shard->index() != origin) {
+        shard->enqueue(msg);
+      }
+    }
+  }
+
+ private:
+  void startThreads(std::size_t firstShard) {
+    for (std::size_t i = firstShard; i < shards_.size(); ++i) {
+      threads_.emplace_back([shard = shards_[i].get()]() {
+        debugLog() << "Shard " << shard->index() << " running" << std::endl;
+        shard->run();
+      });
+    }
+  }
+
+  void joinThreads() {
+    for (auto& thread : threads_) {
+      if (thread.joinable()) thread.join();
+    }
+    threads_.clear();
+  }
+
+  void doAccept() {
+    ChatShard& target = *shards_[nextShard_];
+    nextShard_ = (nextShard_ + 1) % shards_.size();
+
+    acceptor_->async_accept(
+        target.context(),
+        [this, &target](std::error_code ec, tcp::socket socket) {
+          if (!ec) {
+            std::cout << "Accepted new connection " << socket.remote_endpoint() << " -> shard " << target.index() << std::endl;
+            // Hand the session over to the shard's thread
+            asio::post(target.context(), [&target, socket = std::move(socket)]() mutable {
+              std::make_shared<ClientSession>(std::move(socket), target)->start();
+            });
+          }
+          if (ec != asio::error::operation_aborted) {
+            doAccept();
+          }
+        });
+  }
+
+  std::vector<std::unique_ptr<ChatShard>> shards_;
+  std::unique_ptr<tcp::acceptor> acceptor_;
+  std::size_t nextShard_ = 0;
+  std::vector<std::thread> threads_;
+};
+
+inline void ChatShard::publish(const SharedMessage& msg) {
+  room_.deliver(msg);
+  server_.forward(index_, msg);
+}
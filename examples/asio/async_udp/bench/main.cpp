@@ -0,0 +1,271 @@
+// Packets-per-second benchmark of the UDP chat server on loopback.
+//
+// For every requested I/O mode and worker count the server from `../server/AsyncUdpServer.h` is started in-process:
+// `workers` SO_REUSEPORT sockets on one port, each with its own thread.
+// `participants` sockets join the room (one datagram each) and only count what they receive,
+// `senders` threads flood the server with datagrams for `duration` seconds. Every received datagram is fanned out
+// to all participants (the senders are participants too, like every source address).
+// The kernel steers each flow (source address and port) to one socket, so every sender thread rotates over `flows`
+// sockets to spread its load across the workers.
+//
+// Reported per mode and worker count:
+// - tx pps:        datagrams sent by the flood threads
+// - rx pps:        datagrams received by the server, rx drop = datagrams lost before the server read them
+// - per worker:    rx pps of every worker, shows how evenly the kernel spread the flows
+// - fan-out pps:   datagrams sent by the server
+// - dgrams/recv and dgrams/send: datagrams per receive / send syscall (1 in the per-datagram mode)
+// - sink pps:      datagrams received by the participants (the sink thread may be the bottleneck itself)
+
+#include <algorithm>
+#include <array>
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cxxopts.hpp"
+
+#define DEBUG_LOG_DISABLE_DEBUG_LEVEL
+#include "../../../DebugLog.h"
+#include "../server/AsyncUdpServer.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    std::size_t participants = 16;
+    std::size_t senders = 2;
+    std::size_t flowsPerSender = 8;
+    std::size_t payload = 64;
+    std::chrono::milliseconds duration{3000};
+    uint64_t ratePerSender = 0;  // Datagrams per second, 0 - as fast as possible
+    std::size_t batchSize = 64;
+};
+
+struct BenchResult {
+    double txPps = 0;
+    double rxPps = 0;
+    double rxDropPercent = 0;
+    double fanOutPps = 0;
+    double datagramsPerReceive = 0;
+    double datagramsPerSend = 0;
+    double sinkPps = 0;
+    uint64_t sendDropped = 0;
+    std::vector<double> workerRxPps;
+};
+
+// Participants which only receive. All sockets are served by one thread.
+class Sink {
+public:
+    Sink(std::size_t count, const udp::endpoint& server) {
+        for (std::size_t i = 0; i < count; ++i) {
+            auto& socket = sockets_.emplace_back(std::make_unique<udp::socket>(io_context_, udp::endpoint(udp::v4(), 0)));
+            socket->set_option(asio::socket_base::receive_buffer_size(4 * 1024 * 1024));
+            socket->send_to(asio::buffer("join", 4), server);  // The server adds every source to the room
+        }
+        buffers_.resize(sockets_.size());
+        for (std::size_t i = 0; i < sockets_.size(); ++i) {
+            doReceive(i);
+        }
+        thread_ = std::thread([this]() { io_context_.run(); });
+    }
+
+    ~Sink() {
+        io_context_.stop();
+        thread_.join();
+    }
+
+    uint64_t received() const { return received_.load(std::memory_order_relaxed); }
+
+private:
+    void doReceive(std::size_t i) {
+        sockets_[i]->async_receive(asio::buffer(buffers_[i]), [this, i](std::error_code ec, std::size_t) {
+            if (ec == asio::error::operation_aborted) return;
+            received_.fetch_add(1, std::memory_order_relaxed);
+            doReceive(i);
+        });
+    }
+
+    asio::io_context io_context_;
+    std::vector<std::unique_ptr<udp::socket>> sockets_;
+    std::vector<std::array<char, 2048>> buffers_;
+    std::atomic<uint64_t> received_{0};
+    std::thread thread_;
+};
+
+uint64_t flood(const udp::endpoint& server, const BenchConfig& config, Clock::time_point deadline) {
+    asio::io_context io_context;
+    std::vector<std::unique_ptr<udp::socket>> sockets;
+    for (std::size_t i = 0; i < config.flowsPerSender; ++i) {
+        sockets.push_back(std::make_unique<udp::socket>(io_context, udp::endpoint(udp::v4(), 0)));
+    }
+    const std::string payload(config.payload, 'x');
+
+    uint64_t sent = 0;
+    std::size_t flow = 0;
+    const auto start = Clock::now();
+    while (Clock::now() < deadline) {
+        for (int i = 0; i < 64; ++i) {
+            std::error_code ec;
+            sockets[flow]->send_to(asio::buffer(payload), server, 0, ec);
+            flow = (flow + 1) % sockets.size();
+            if (!ec) ++sent;
+        }
+        if (config.ratePerSender > 0) {
+            // Sleep until the schedule of the sent datagrams catches up
+            const auto due = start + std::chrono::nanoseconds(sent * 1'000'000'000 / config.ratePerSender);
+            std::this_thread::sleep_until(std::min(due, deadline));
+        }
+    }
+    return sent;
+}
+
+// Sums a counter over all workers
+template <typename Counter>
+uint64_t total(const MultiSocketUdpServer& server, Counter counter) {
+    uint64_t sum = 0;
+    for (std::size_t i = 0; i < server.workerCount(); ++i) sum += counter(server.worker(i).stats()).load();
+    return sum;
+}
+
+BenchResult runOnce(AsyncUdpServer::Options options, std::size_t workers, const BenchConfig& config) {
+    MultiSocketUdpServer server(0, workers, options);
+    server.runInBackground();
+    const udp::endpoint serverEndpoint(asio::ip::address_v4::loopback(), server.port());
+
+    using Stats = AsyncUdpServer::Stats;
+    const auto received = [](const Stats& stats) -> auto& { return stats.datagramsReceived; };
+    const auto sent = [](const Stats& stats) -> auto& { return stats.datagramsSent; };
+    const auto receiveCalls = [](const Stats& stats) -> auto& { return stats.receiveCalls; };
+    const auto sendCalls = [](const Stats& stats) -> auto& { return stats.sendCalls; };
+    const auto sendDropped = [](const Stats& stats) -> auto& { return stats.sendDropped; };
+
+    BenchResult result;
+    {
+        Sink sink(config.participants, serverEndpoint);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));  // Joins are processed
+
+        std::vector<uint64_t> workerReceived0;
+        for (std::size_t i = 0; i < server.workerCount(); ++i) {
+            workerReceived0.push_back(server.worker(i).stats().datagramsReceived.load());
+        }
+        const uint64_t received0 = total(server, received);
+        const uint64_t sent0 = total(server, sent);
+        const uint64_t receiveCalls0 = total(server, receiveCalls);
+        const uint64_t sendCalls0 = total(server, sendCalls);
+        const uint64_t sendDropped0 = total(server, sendDropped);
+        const uint64_t sink0 = sink.received();
+
+        const auto start = Clock::now();
+        const auto deadline = start + config.duration;
+        std::vector<std::thread> senders;
+        std::atomic<uint64_t> txTotal{0};
+        for (std::size_t i = 0; i < config.senders; ++i) {
+            senders.emplace_back([&]() { txTotal += flood(serverEndpoint, config, deadline); });
+        }
+        for (auto& thread : senders) thread.join();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));  // Let the server drain its sockets
+
+        const double seconds = std::chrono::duration<double>(deadline - start).count();
+        const uint64_t rx = total(server, received) - received0;
+        const uint64_t tx = total(server, sent) - sent0;
+        const uint64_t rxCalls = total(server, receiveCalls) - receiveCalls0;
+        const uint64_t txCalls = total(server, sendCalls) - sendCalls0;
+
+        result.txPps = txTotal / seconds;
+        result.rxPps = rx / seconds;
+        result.rxDropPercent = txTotal ? 100.0 * (1.0 - static_cast<double>(std::min<uint64_t>(rx, txTotal)) / txTotal) : 0;
+        result.fanOutPps = tx / seconds;
+        result.datagramsPerReceive = rxCalls ? static_cast<double>(rx) / rxCalls : 0;
+        result.datagramsPerSend = txCalls ? static_cast<double>(tx) / txCalls : 0;
+        result.sinkPps = (sink.received() - sink0) / seconds;
+        result.sendDropped = total(server, sendDropped) - sendDropped0;
+        for (std::size_t i = 0; i < server.workerCount(); ++i) {
+            result.workerRxPps.push_back((server.worker(i).stats().datagramsReceived.load() - workerReceived0[i]) / seconds);
+        }
+    }
+
+    server.stop();
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    cxxopts::Options options(argv[0], "Packets-per-second benchmark of the UDP chat server on loopback");
+    // clang-format off
+    options.add_options()
+        ("m,modes", "I/O modes to compare: single, batched, gso", cxxopts::value<std::vector<std::string>>()->default_value("single,batched,gso"))
+        ("p,participants", "Receiving participants", cxxopts::value<std::size_t>()->default_value("16"))
+        ("w,workers", "Worker counts to compare: SO_REUSEPORT sockets, one thread each", cxxopts::value<std::vector<std::size_t>>()->default_value("1,2,4"))
+        ("s,senders", "Flood threads", cxxopts::value<std::size_t>()->default_value("2"))
+        ("f,flows", "Sockets per flood thread (each one is a participant too)", cxxopts::value<std::size_t>()->default_value("8"))
+        ("b,bytes", "Datagram size in bytes", cxxopts::value<std::size_t>()->default_value("64"))
+        ("d,duration", "Flood duration in milliseconds", cxxopts::value<std::size_t>()->default_value("3000"))
+        ("r,rate", "Datagrams per second per sender, 0 - unlimited", cxxopts::value<uint64_t>()->default_value("0"))
+        ("batch", "Datagrams per recvmmsg / sendmmsg", cxxopts::value<std::size_t>()->default_value("64"))
+        ("h,help", "Print usage");
+    // clang-format on
+
+    auto args = options.parse(argc, argv);
+    if (args.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    BenchConfig config;
+    config.participants = args["participants"].as<std::size_t>();
+    config.senders = std::max<std::size_t>(1, args["senders"].as<std::size_t>());
+    config.flowsPerSender = std::max<std::size_t>(1, args["flows"].as<std::size_t>());
+    config.payload = std::clamp<std::size_t>(args["bytes"].as<std::size_t>(), 1, 1024);  // The server reads up to 1024 bytes
+    config.duration = std::chrono::milliseconds(args["duration"].as<std::size_t>());
+    config.ratePerSender = args["rate"].as<uint64_t>();
+    config.batchSize = args["batch"].as<std::size_t>();
+
+    struct Row {
+        std::string mode;
+        std::size_t workers;
+        BenchResult result;
+    };
+    std::vector<Row> results;
+    try {
+        for (auto& mode : args["modes"].as<std::vector<std::string>>()) {
+            for (auto workers : args["workers"].as<std::vector<std::size_t>>()) {
+                AsyncUdpServer::Options serverOptions;
+                serverOptions.batchSize = config.batchSize;
+                if (mode == "batched" || mode == "gso") {
+                    serverOptions.ioMode = AsyncUdpServer::IoMode::Batched;
+                    serverOptions.gso = mode == "gso";
+                }
+                workers = std::max<std::size_t>(1, workers);
+                std::cout << "Running " << mode << " I/O, " << workers << " workers..." << std::endl;
+                results.push_back({mode, workers, runOnce(serverOptions, workers, config)});
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "\nparticipants=" << config.participants << " senders=" << config.senders << " flows/sender=" << config.flowsPerSender
+              << " bytes=" << config.payload << " batch=" << config.batchSize << " cores=" << std::thread::hardware_concurrency() << "\n\n";
+    std::cout << std::left << std::setw(10) << "mode" << std::setw(9) << "workers" << std::setw(12) << "tx pps" << std::setw(12) << "rx pps" << std::setw(10)
+              << "rx drop%" << std::setw(14) << "fan-out pps" << std::setw(13) << "dgrams/recv" << std::setw(13) << "dgrams/send"
+              << std::setw(12) << "sink pps" << std::setw(12) << "send drops" << "rx pps per worker" << std::endl;
+    for (auto& [mode, workers, r] : results) {
+        std::ostringstream perWorker;
+        perWorker << std::fixed << std::setprecision(0);
+        for (std::size_t i = 0; i < r.workerRxPps.size(); ++i) perWorker << (i ? " / " : "") << r.workerRxPps[i];
+        std::cout << std::left << std::setw(10) << mode << std::setw(9) << workers << std::fixed << std::setprecision(0) << std::setw(12) << r.txPps
+                  << std::setw(12) << r.rxPps << std::setprecision(1) << std::setw(10) << r.rxDropPercent << std::setprecision(0)
+                  << std::setw(14) << r.fanOutPps << std::setprecision(2) << std::setw(13) << r.datagramsPerReceive
+                  << std::setw(13) << r.datagramsPerSend << std::setprecision(0) << std::setw(12) << r.sinkPps << std::setw(12) << r.sendDropped
+                  << perWorker.str() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,404 @@
+#pragma once
+
+#include <algorithm>
+#include <asio.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../../../DebugLog.h"
+#include "../../common/EndpointTable.h"
+#include "../../common/HandlerAllocator.h"
+#include "../../common/SharedMessage.h"
+#include "UdpBatch.h"
+#include "concurrentqueue.h"
+
+using asio::ip::udp;
+
+class MultiSocketUdpServer;
+
+// Represents a chat room for managing client sessions and broadcasting messages.
+// This application has only one room. With several workers every worker owns the participants whose datagrams
+// the kernel steers to its socket, so the room is the union of the workers' rooms.
+// Participants are removed after `ttl` without datagrams, so the room stays bounded under churn.
+class ChatRoom {
+public:
+    explicit ChatRoom(EndpointTable::Options options) : participants_(options) {}
+
+    // O(1). Called for every received datagram.
+    void add_participant(const udp::endpoint& endpoint) {
+        switch (participants_.touch(endpoint)) {
+            case EndpointTable::TouchResult::Existing:
+                break;
+            case EndpointTable::TouchResult::Inserted:
+                std::cout << "New participant: " << endpoint << ". Total: " << participants_.size() << std::endl;
+                break;
+            case EndpointTable::TouchResult::Full:
+                debugLog() << "Room is full, " << endpoint << " does not receive messages" << std::endl;
+                break;
+        }
+    }
+
+    // Must be called every tick of the participant table
+    void expire_participants(EndpointTable::Clock::time_point now) {
+        const auto removed = participants_.expire(now, [](const udp::endpoint& endpoint) {
+            debugLog() << "Participant expired: " << endpoint << std::endl;
+        });
+        if (removed > 0) {
+            std::cout << "Expired " << removed << " participants. Total: " << participants_.size() << std::endl;
+        }
+    }
+
+    // One async_send_to per participant
+    void deliver(const SharedMessage& msg, udp::socket& socket) {
+        for (const auto& participant : participants_) {
+            socket.async_send_to(msg.buffer(), participant,
+                withHandlerAllocator([msg](std::error_code /*ec*/, std::size_t /*bytes*/) {
+                    debugLog() << "Sent message to participant: size=" << msg.size() << ". Package may be lost." << std::endl;
+                }));
+        }
+    }
+
+    const EndpointTable& participants() const { return participants_; }
+
+private:
+    EndpointTable participants_;
+};
+
+class AsyncUdpServer {
+public:
+    enum class IoMode {
+        PerDatagram,  // One async_receive_from per datagram, one async_send_to per participant
+        Batched,      // Linux: recvmmsg drains up to batchSize datagrams per wake-up, sendmmsg flushes the fan-out
+    };
+
+    struct Options {
+        IoMode ioMode = IoMode::PerDatagram;
+        std::size_t batchSize = 64;  // Datagrams per recvmmsg and messages per sendmmsg (at most 1024)
+        bool gso = false;            // Batched mode: send all datagrams of one wake-up to a participant as one UDP GSO buffer
+        bool reusePort = false;      // SO_REUSEPORT: several sockets share the port, the kernel spreads flows between them
+        EndpointTable::Options participants;  // Participant TTL, expiry tick and maximum room size
+    };
+
+    // Updated by the server thread, may be read from any thread
+    struct Stats {
+        std::atomic<uint64_t> datagramsReceived{0};
+        std::atomic<uint64_t> datagramsSent{0};
+        std::atomic<uint64_t> receiveCalls{0};        // Completed receive operations or recvmmsg calls
+        std::atomic<uint64_t> sendCalls{0};           // async_send_to or sendmmsg calls
+        std::atomic<uint64_t> sendDropped{0};         // Batched mode: datagrams not accepted by the socket (buffer full)
+        std::atomic<uint64_t> datagramsForwarded{0};  // Received by other workers and sent to the local participants
+    };
+
+    AsyncUdpServer(asio::io_context& io_context, unsigned short port) : AsyncUdpServer(io_context, port, Options{}) {}
+
+    AsyncUdpServer(asio::io_context& io_context, unsigned short port, Options options)
+        : AsyncUdpServer(io_context, port, options, nullptr, 0) {}
+
+    // One worker of a MultiSocketUdpServer. Datagrams received here are forwarded to the other workers of the group.
+    AsyncUdpServer(asio::io_context& io_context, unsigned short port, Options options, MultiSocketUdpServer* group, std::size_t index)
+        : io_context_(io_context),
+          socket_(io_context),
+          options_(options),
+          group_(group),
+          index_(index),
+          room_(options.participants),
+          expiryTimer_(io_context) {
+        open(port);
+        scheduleExpiry();
+#ifdef __linux__
+        if (options_.ioMode == IoMode::Batched) {
+            options_.batchSize = std::clamp<std::size_t>(options_.batchSize, 1, UdpBatch::maxBatchSize);
+            batch_.init(socket_.native_handle(), options_.batchSize);
+            socket_.non_blocking(true);
+            waitReadable();
+            return;
+        }
+#else
+        if (options_.ioMode == IoMode::Batched) {
+            std::cout << "Batched UDP I/O requires Linux, using one operation per datagram" << std::endl;
+            options_.ioMode = IoMode::PerDatagram;
+        }
+#endif
+        doReceive();
+    }
+
+    // Thread safe. Called by other workers to send a datagram to the local participants.
+    // The message buffer itself is shared between workers, only the reference is queued.
+    void enqueue(SharedMessage msg) {
+        inbox_.enqueue(std::move(msg));
+
+        // Coalesce wake-ups: only one drain is scheduled no matter how many messages are queued meanwhile.
+        if (!drainScheduled_.exchange(true, std::memory_order_acq_rel)) {
+            asio::post(io_context_, withHandlerAllocator([this]() { drainInbox(); }));
+        }
+    }
+
+    const Stats& stats() const { return stats_; }
+
+    const Options& options() const { return options_; }
+
+    std::size_t index() const { return index_; }
+
+    unsigned short port() const { return socket_.local_endpoint().port(); }
+
+private:
+    void open(unsigned short port) {
+        socket_.open(udp::v4());
+        if (options_.reusePort) {
+#ifdef SO_REUSEPORT
+            socket_.set_option(asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#else
+            std::cout << "SO_REUSEPORT is not supported here, the port can't be shared" << std::endl;
+#endif
+        }
+        socket_.bind(udp::endpoint(udp::v4(), port));
+    }
+
+    void scheduleExpiry() {
+        expiryTimer_.expires_after(room_.participants().options().tick);
+        expiryTimer_.async_wait([this](std::error_code ec) {
+            if (ec) return;
+            room_.expire_participants(EndpointTable::Clock::now());
+            scheduleExpiry();
+        });
+    }
+
+    void doReceive() {
+        // Wait data from any source
+        socket_.async_receive_from(
+            asio::buffer(data_, max_length), remote_endpoint_,
+            withHandlerAllocator([this](std::error_code ec, std::size_t bytes_recvd) {
+                if (ec == asio::error::operation_aborted) return;
+                stats_.receiveCalls.fetch_add(1, std::memory_order_relaxed);
+
+                if (!ec && bytes_recvd > 0) {
+                    stats_.datagramsReceived.fetch_add(1, std::memory_order_relaxed);
+
+                    // 1. Add a new participant to the room
+                    room_.add_participant(remote_endpoint_);
+
+                    // 2. Broadcast received a message to all participants
+                    SharedMessage msg(std::string_view(data_, bytes_recvd));
+                    debugLog() << "Received " << bytes_recvd << " bytes from " << remote_endpoint_ << std::endl;
+
+                    deliver(msg);
+                    forward(msg);
+                } else {
+                    std::cerr << "Receive error: " << ec.message() << std::endl;
+                }
+
+                // 3. Wait for the next message
+                doReceive();
+            }));
+    }
+
+    void deliver(const SharedMessage& msg) {
+        room_.deliver(msg, socket_);
+        const auto fanOut = room_.participants().size();
+        stats_.sendCalls.fetch_add(fanOut, std::memory_order_relaxed);
+        stats_.datagramsSent.fetch_add(fanOut, std::memory_order_relaxed);
+    }
+
+    // Participants of the other workers
+    void forward(const SharedMessage& msg);
+
+    void drainInbox() {
+        // Reset the flag BEFORE draining. A message enqueued after this point schedules a new drain.
+        drainScheduled_.store(false, std::memory_order_release);
+
+        SharedMessage msg;
+#ifdef __linux__
+        if (options_.ioMode == IoMode::Batched) {
+            // Same fan-out as for the local datagrams: up to batchSize messages per participant per sendmmsg round
+            while (inbox_.try_dequeue(msg)) {
+                forwarded_.push_back(std::move(msg));
+                if (forwarded_.size() == options_.batchSize) sendForwarded();
+            }
+            sendForwarded();
+            return;
+        }
+#endif
+        while (inbox_.try_dequeue(msg)) {
+            stats_.datagramsForwarded.fetch_add(1, std::memory_order_relaxed);
+            deliver(msg);
+        }
+    }
+
+#ifdef __linux__
+    // Batched mode. The socket is non-blocking, asio only reports readiness and the I/O is done with raw syscalls.
+    void waitReadable() {
+        socket_.async_wait(udp::socket::wait_read, withHandlerAllocator([this](std::error_code ec) {
+            if (ec) {
+                if (ec != asio::error::operation_aborted) std::cerr << "Wait error: " << ec.message() << std::endl;
+                return;
+            }
+            drainReceive();
+            waitReadable();
+        }));
+    }
+
+    void drainReceive() {
+        // A few full batches per wake-up, then yield to other handlers of the io_context
+        for (int round = 0; round < maxBatchesPerWakeup; ++round) {
+            const int received = batch_.receive();
+            stats_.receiveCalls.fetch_add(1, std::memory_order_relaxed);
+            if (received <= 0) break;  // EAGAIN: drained
+            stats_.datagramsReceived.fetch_add(received, std::memory_order_relaxed);
+
+            for (int i = 0; i < received; ++i) {
+                room_.add_participant(batch_.sender(i));
+            }
+
+            // Datagrams are sent straight from the receive buffers: sendmmsg completes synchronously
+            for (const auto& participant : room_.participants()) {
+                batch_.queueFanOut(participant, batch_.received(), options_.gso);
+            }
+            flushSends();
+
+            // The other workers need their own copy: the receive buffers are reused by the next recvmmsg
+            if (group_) {
+                for (auto datagram : batch_.received()) forward(SharedMessage(datagram));
+            }
+
+            if (static_cast<std::size_t>(received) < options_.batchSize) break;
+        }
+    }
+
+    void sendForwarded() {
+        if (forwarded_.empty()) return;
+        forwardedViews_.clear();
+        for (auto& msg : forwarded_) forwardedViews_.push_back(msg.view());
+        for (const auto& participant : room_.participants()) {
+            batch_.queueFanOut(participant, forwardedViews_, options_.gso);
+        }
+        flushSends();
+        stats_.datagramsForwarded.fetch_add(forwarded_.size(), std::memory_order_relaxed);
+        forwarded_.clear();
+    }
+
+    void flushSends() {
+        const auto result = batch_.flush();
+        stats_.sendCalls.fetch_add(result.calls, std::memory_order_relaxed);
+        stats_.datagramsSent.fetch_add(result.sent, std::memory_order_relaxed);
+        stats_.sendDropped.fetch_add(result.dropped, std::memory_order_relaxed);
+        if (result.gsoUnsupported && options_.gso) {
+            std::cout << "UDP GSO is not supported here, sending one datagram per message" << std::endl;
+            options_.gso = false;
+        }
+    }
+
+    static constexpr int maxBatchesPerWakeup = 4;
+
+    UdpBatch batch_;
+    std::vector<SharedMessage> forwarded_;  // Keeps the forwarded datagrams alive until sendmmsg
+    std::vector<std::string_view> forwardedViews_;
+#endif
+
+    asio::io_context& io_context_;
+    udp::socket socket_;
+    Options options_;
+    MultiSocketUdpServer* group_;
+    std::size_t index_;
+    Stats stats_;
+    udp::endpoint remote_endpoint_;
+    ChatRoom room_;
+    asio::steady_timer expiryTimer_;
+    moodycamel::ConcurrentQueue<SharedMessage> inbox_;
+    std::atomic<bool> drainScheduled_{false};
+    enum { max_length = 1024 };
+    char data_[max_length];
+};
+
+// Several AsyncUdpServer workers, each one with its own io_context, thread and SO_REUSEPORT socket bound to the same port.
+// The kernel hashes every flow (source and destination address and port) to one of the sockets, so one client is
+// always served by the same worker and its participant entry lives in that worker's room only: the registry is
+// sharded by the kernel and no lock is taken per datagram. A received datagram is sent to the local participants
+// directly and to the participants of the other workers through their lock-free inboxes.
+class MultiSocketUdpServer {
+public:
+    MultiSocketUdpServer(unsigned short port, std::size_t workerCount, AsyncUdpServer::Options options) {
+        if (workerCount == 0) workerCount = 1;
+        options.reusePort = true;
+
+        // Port 0: the first worker picks an ephemeral port and the others join it
+        for (std::size_t i = 0; i < workerCount; ++i) {
+            auto worker = std::make_unique<Worker>();
+            worker->server = std::make_unique<AsyncUdpServer>(worker->io_context, port, options, this, i);
+            port = worker->server->port();
+            workers_.push_back(std::move(worker));
+        }
+    }
+
+    ~MultiSocketUdpServer() { stop(); }
+
+    std::size_t workerCount() const { return workers_.size(); }
+
+    const AsyncUdpServer& worker(std::size_t index) const { return *workers_[index]->server; }
+
+    unsigned short port() const { return workers_.front()->server->port(); }
+
+    // Runs the first worker in the calling thread and every other worker in its own background thread.
+    // Blocks until the server is stopped.
+    void run() {
+        startThreads(1);
+        workers_.front()->io_context.run();
+        joinThreads();
+    }
+
+    // Runs every worker in a background thread and returns immediately. Used by benchmarks.
+    void runInBackground() { startThreads(0); }
+
+    // Must not be called from a worker thread.
+    void stop() {
+        for (auto& worker : workers_) {
+            worker->io_context.stop();
+        }
+        joinThreads();
+    }
+
+    // Forwards a datagram received by worker `origin` to every other worker.
+    void forward(std::size_t origin, const SharedMessage& msg) {
+        for (auto& worker : workers_) {
+            if (worker->server->index() != origin) {
+                worker->server->enqueue(msg);
+            }
+        }
+    }
+
+private:
+    struct Worker {
+        asio::io_context io_context;
+        std::unique_ptr<AsyncUdpServer> server;  // Destroyed before its io_context
+    };
+
+    void startThreads(std::size_t firstWorker) {
+        for (std::size_t i = firstWorker; i < workers_.size(); ++i) {
+            threads_.emplace_back([worker = workers_[i].get()]() {
+                debugLog() << "Worker " << worker->server->index() << " running" << std::endl;
+                worker->io_context.run();
+            });
+        }
+    }
+
+    void joinThreads() {
+        for (auto& thread : threads_) {
+            if (thread.joinable()) thread.join();
+        }
+        threads_.clear();
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+};
+
+inline void AsyncUdpServer::forward(const SharedMessage& msg) {
+    if (group_) group_->forward(index_, msg);
+}
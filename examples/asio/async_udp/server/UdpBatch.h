@@ -0,0 +1,184 @@
+#pragma once
+
+// Linux only: recvmmsg / sendmmsg / UDP GSO
+#ifdef __linux__
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <asio.hpp>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Pre-allocated recvmmsg / sendmmsg state of one non-blocking UDP socket. Nothing is allocated per datagram.
+//
+// receive() reads up to batchSize datagrams with one syscall. queueFanOut() queues datagrams to one destination,
+// flush() sends everything queued with as few sendmmsg calls as possible. The queued datagrams are not copied:
+// they must stay alive until flush() (sendmmsg completes synchronously).
+class UdpBatch {
+public:
+    using udp = asio::ip::udp;
+
+    static constexpr std::size_t maxBatchSize = 1024;  // UIO_MAXIOV, the kernel limit of one recvmmsg/sendmmsg
+    static constexpr std::size_t maxDatagramSize = 1024;
+
+    struct FlushResult {
+        uint64_t calls = 0;
+        uint64_t sent = 0;
+        uint64_t dropped = 0;
+        bool gsoUnsupported = false;
+    };
+
+    void init(int fd, std::size_t batchSize) {
+        fd_ = fd;
+        batchSize_ = batchSize;
+        storage_.resize(batchSize_ * maxDatagramSize);
+        senders_.resize(batchSize_);
+        recvIov_.resize(batchSize_);
+        recvHeaders_.resize(batchSize_);
+        datagrams_.resize(batchSize_);
+        for (std::size_t i = 0; i < batchSize_; ++i) {
+            recvIov_[i] = {storage_.data() + i * maxDatagramSize, maxDatagramSize};
+        }
+        sendHeaders_.resize(maxBatchSize);
+        sendIov_.resize(maxBatchSize);
+        sendControl_.resize(maxBatchSize);
+    }
+
+    // Receives up to batchSize datagrams without blocking. Returns 0 if there is nothing to read, -1 on error.
+    int receive() {
+        for (std::size_t i = 0; i < batchSize_; ++i) {
+            auto& hdr = recvHeaders_[i].msg_hdr;
+            hdr = {};
+            hdr.msg_name = senders_[i].data();
+            hdr.msg_namelen = static_cast<socklen_t>(senders_[i].capacity());
+            hdr.msg_iov = &recvIov_[i];
+            hdr.msg_iovlen = 1;
+        }
+        const int received = ::recvmmsg(fd_, recvHeaders_.data(), static_cast<unsigned>(batchSize_), MSG_DONTWAIT, nullptr);
+        if (received < 0) {
+            received_ = 0;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        received_ = static_cast<std::size_t>(received);
+        for (std::size_t i = 0; i < received_; ++i) {
+            senders_[i].resize(recvHeaders_[i].msg_hdr.msg_namelen);
+            datagrams_[i] = {static_cast<const char*>(recvIov_[i].iov_base), recvHeaders_[i].msg_len};
+        }
+        return received;
+    }
+
+    const udp::endpoint& sender(std::size_t i) const { return senders_[i]; }
+
+    // Datagrams of the last receive(). Valid until the next receive().
+    std::span<const std::string_view> received() const { return {datagrams_.data(), received_}; }
+
+    // Queues the datagrams to one destination. Sends the queue when it is full.
+    // GSO: runs of equal-size datagrams (only the last one may be shorter) go out as one buffer segmented by the kernel.
+    void queueFanOut(const udp::endpoint& destination, std::span<const std::string_view> datagrams, bool gso) {
+        std::size_t first = 0;
+        while (first < datagrams.size()) {
+            if (headerCount_ == sendHeaders_.size() || iovCount_ == sendIov_.size()) sendQueued();
+
+            std::size_t segments = 1;
+            if (gso) {
+                const std::size_t segmentSize = datagrams[first].size();
+                std::size_t total = segmentSize;
+                while (first + segments < datagrams.size() && segments < maxGsoSegments && iovCount_ + segments < sendIov_.size()) {
+                    const std::size_t next = datagrams[first + segments].size();
+                    if (next > segmentSize || total + next > maxGsoBytes) break;
+                    total += next;
+                    ++segments;
+                    if (next < segmentSize) break;  // A shorter segment must be the last one
+                }
+            }
+
+            auto& hdr = sendHeaders_[headerCount_].msg_hdr;
+            hdr = {};
+            hdr.msg_name = const_cast<void*>(static_cast<const void*>(destination.data()));
+            hdr.msg_namelen = static_cast<socklen_t>(destination.size());
+            hdr.msg_iov = &sendIov_[iovCount_];
+            hdr.msg_iovlen = segments;
+            for (std::size_t s = 0; s < segments; ++s) {
+                const auto view = datagrams[first + s];
+                sendIov_[iovCount_++] = {const_cast<char*>(view.data()), view.size()};
+            }
+
+            if (segments > 1) {
+                auto& control = sendControl_[headerCount_];
+                hdr.msg_control = control.data;
+                hdr.msg_controllen = sizeof(control.data);
+                cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                const auto segmentSize = static_cast<uint16_t>(datagrams[first].size());
+                std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(segmentSize));
+            }
+            datagramsPerHeader_[headerCount_] = static_cast<uint32_t>(segments);
+            ++headerCount_;
+            first += segments;
+        }
+    }
+
+    // Sends the queue. Returns the totals since the previous flush().
+    FlushResult flush() {
+        sendQueued();
+        return std::exchange(result_, {});
+    }
+
+private:
+    static constexpr std::size_t maxGsoSegments = 64;  // UDP_MAX_SEGMENTS on older kernels
+    static constexpr std::size_t maxGsoBytes = 65507;  // One UDP datagram before segmentation
+
+    struct Control {
+        alignas(cmsghdr) char data[CMSG_SPACE(sizeof(uint16_t))];
+    };
+
+    void sendQueued() {
+        std::size_t done = 0;
+        while (done < headerCount_) {
+            const int sent = ::sendmmsg(fd_, sendHeaders_.data() + done, static_cast<unsigned>(headerCount_ - done), MSG_DONTWAIT);
+            ++result_.calls;
+            if (sent < 0) {
+                // EAGAIN: the send buffer is full. UDP is lossy anyway, drop the rest instead of queueing it.
+                // EIO / EINVAL on a GSO message: the kernel or the NIC can't segment it.
+                if (sendHeaders_[done].msg_hdr.msg_controllen != 0 && (errno == EIO || errno == EINVAL)) {
+                    result_.gsoUnsupported = true;
+                }
+                for (; done < headerCount_; ++done) result_.dropped += datagramsPerHeader_[done];
+                break;
+            }
+            for (int i = 0; i < sent; ++i, ++done) result_.sent += datagramsPerHeader_[done];
+        }
+        headerCount_ = 0;
+        iovCount_ = 0;
+    }
+
+    int fd_ = -1;
+    std::size_t batchSize_ = 0;
+    std::vector<char> storage_;
+    std::vector<udp::endpoint> senders_;
+    std::vector<iovec> recvIov_;
+    std::vector<mmsghdr> recvHeaders_;
+    std::vector<std::string_view> datagrams_;
+    std::size_t received_ = 0;
+
+    std::vector<mmsghdr> sendHeaders_;
+    std::vector<iovec> sendIov_;
+    std::vector<Control> sendControl_;
+    std::array<uint32_t, maxBatchSize> datagramsPerHeader_{};
+    std::size_t headerCount_ = 0;
+    std::size_t iovCount_ = 0;
+    FlushResult result_;
+};
+
+#endif  // __linux__
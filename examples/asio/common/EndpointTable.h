@@ -0,0 +1,257 @@
+#pragma once
+
+#include <asio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Set of UDP endpoints with last-seen times and expiry. Built for the participant list of a UDP server.
+//
+// - Lookup / insert / erase are O(1): open addressing with linear probing and backward-shift deletion,
+//   keyed by address and port. Every slot keeps the full hash, so most probes never touch the endpoint itself.
+// - Endpoints are stored in one dense array, so a broadcast iterates over contiguous memory.
+// - Expiry uses a hashed timer wheel with lazy rescheduling: touch() only updates the last-seen tick, an entry is
+//   checked when the wheel reaches its bucket and is either evicted or moved to the bucket of its new deadline.
+//   The clock is read by the owner once per tick (expire()), never per packet.
+// - The table never holds more than maxEntries endpoints, so the memory stays bounded under churn.
+//
+// USAGE:
+// EndpointTable participants({.ttl = std::chrono::seconds(60)});
+// participants.touch(senderEndpoint);                      // On every datagram
+// participants.expire(EndpointTable::Clock::now());       // Every `tick` (e.g. from a steady_timer)
+// for (auto& endpoint : participants) socket.send_to(...); // Contiguous
+class EndpointTable {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Endpoint = asio::ip::udp::endpoint;
+
+  struct Options {
+    std::chrono::milliseconds ttl{60000};  // An endpoint is removed after this time without touch()
+    std::chrono::milliseconds tick{1000};  // Expiry resolution
+    std::size_t maxEntries = 1 << 20;
+  };
+
+  enum class TouchResult {
+    Existing,
+    Inserted,
+    Full,  // New endpoint, but the table holds maxEntries already
+  };
+
+  EndpointTable() : EndpointTable(Options{}) {}
+
+  explicit EndpointTable(Options options, Clock::time_point now = Clock::now()) : options_(options), epoch_(now) {
+    options_.tick = std::max(options_.tick, std::chrono::milliseconds(1));
+    ttlTicks_ = std::max<uint64_t>(1, (options_.ttl + options_.tick - std::chrono::milliseconds(1)) / options_.tick);
+    wheel_.resize(std::clamp<uint64_t>(ttlTicks_ + 1, 2, maxWheelSize));
+    slots_.resize(minCapacity);
+    mask_ = minCapacity - 1;
+  }
+
+  // Inserts the endpoint or refreshes its last-seen time. O(1).
+  TouchResult touch(const Endpoint& endpoint) {
+    const uint32_t hash = hashOf(endpoint);
+    const std::size_t slot = find(endpoint, hash);
+    if (slots_[slot].used()) {
+      meta_[slots_[slot].index - 1].lastSeen = currentTick_;
+      return TouchResult::Existing;
+    }
+
+    if (endpoints_.size() >= options_.maxEntries) return TouchResult::Full;
+
+    const auto index = static_cast<uint32_t>(endpoints_.size());
+    endpoints_.push_back(endpoint);
+    meta_.push_back({currentTick_, hash, 0, 0});
+    slots_[slot] = {index + 1, hash};
+    schedule(index, currentTick_ + ttlTicks_);
+
+    if (endpoints_.size() * 4 > slots_.size() * 3) rehash(slots_.size() * 2);  // Load factor <= 0.75
+    return TouchResult::Inserted;
+  }
+
+  bool contains(const Endpoint& endpoint) const { return slots_[find(endpoint, hashOf(endpoint))].used(); }
+
+  bool erase(const Endpoint& endpoint) {
+    const std::size_t slot = find(endpoint, hashOf(endpoint));
+    if (!slots_[slot].used()) return false;
+    removeAt(slot);
+    return true;
+  }
+
+  // Advances the wheel to `now` and removes every endpoint not touched during the TTL.
+  // `onExpired(const Endpoint&)` is called for every removed endpoint. Returns the number of removed endpoints.
+  template <typename OnExpired>
+  std::size_t expire(Clock::time_point now, OnExpired&& onExpired) {
+    const auto target = static_cast<uint64_t>(std::max<Clock::duration>(now - epoch_, Clock::duration::zero()) / options_.tick);
+    std::size_t removed = 0;
+
+    // After a long pause every bucket is visited once. Entries due later are rescheduled, none is missed.
+    const uint64_t steps = std::min<uint64_t>(target - std::min(target, currentTick_), wheel_.size());
+    const uint64_t first = target - steps;
+    for (uint64_t step = 1; step <= steps; ++step) {
+      currentTick_ = first + step;
+      auto& bucket = wheel_[currentTick_ % wheel_.size()];
+
+      // Every visited entry leaves the bucket, either rescheduled or removed. Rescheduled entries never land in
+      // this bucket again: schedule() targets (currentTick_, currentTick_ + size).
+      while (!bucket.empty()) {
+        const uint32_t index = bucket.front();
+        const uint64_t deadline = meta_[index].lastSeen + ttlTicks_;
+        if (deadline > currentTick_) {
+          unschedule(index);
+          schedule(index, deadline);
+          continue;
+        }
+
+        onExpired(std::as_const(endpoints_[index]));
+        removeAt(find(endpoints_[index], meta_[index].hash));
+        ++removed;
+      }
+    }
+    currentTick_ = std::max(currentTick_, target);
+    return removed;
+  }
+
+  std::size_t expire(Clock::time_point now) {
+    return expire(now, [](const Endpoint&) {});
+  }
+
+  std::size_t size() const { return endpoints_.size(); }
+
+  bool empty() const { return endpoints_.empty(); }
+
+  const Options& options() const { return options_; }
+
+  auto begin() const { return endpoints_.cbegin(); }
+
+  auto end() const { return endpoints_.cend(); }
+
+ private:
+  static constexpr std::size_t minCapacity = 16;
+  static constexpr uint64_t maxWheelSize = 4096;
+
+  struct Slot {
+    uint32_t index = 0;  // Position in endpoints_ + 1, 0 - empty
+    uint32_t hash = 0;
+
+    bool used() const { return index != 0; }
+  };
+
+  struct Meta {
+    uint64_t lastSeen;   // Tick
+    uint32_t hash;
+    uint32_t bucket;     // Timer wheel bucket
+    uint32_t bucketPos;  // Position in the bucket
+  };
+
+  static uint32_t hashOf(const Endpoint& endpoint) {
+    uint64_t h = endpoint.port();
+    const auto address = endpoint.address();
+    if (address.is_v4()) {
+      h |= uint64_t{address.to_v4().to_uint()} << 16;
+    } else {
+      const auto bytes = address.to_v6().to_bytes();
+      for (std::size_t i = 0; i < bytes.size(); i += 8) {
+        uint64_t word = 0;
+        for (std::size_t j = 0; j < 8; ++j) word = (word << 8) | bytes[i + j];
+        h = mix(h ^ word);
+      }
+    }
+    return static_cast<uint32_t>(mix(h));
+  }
+
+  static uint64_t mix(uint64_t x) {
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+
+  // Slot holding the endpoint or the empty slot where it would be inserted
+  std::size_t find(const Endpoint& endpoint, uint32_t hash) const {
+    std::size_t slot = hash & mask_;
+    while (slots_[slot].used()) {
+      if (slots_[slot].hash == hash && endpoints_[slots_[slot].index - 1] == endpoint) return slot;
+      slot = (slot + 1) & mask_;
+    }
+    return slot;
+  }
+
+  void schedule(uint32_t index, uint64_t deadline) {
+    // Deadlines beyond the wheel go to the farthest bucket and are rescheduled when it is reached
+    const uint64_t tick = std::min(deadline, currentTick_ + wheel_.size() - 1);
+    auto& bucket = wheel_[tick % wheel_.size()];
+    meta_[index].bucket = static_cast<uint32_t>(tick % wheel_.size());
+    meta_[index].bucketPos = static_cast<uint32_t>(bucket.size());
+    bucket.push_back(index);
+  }
+
+  void removeAt(std::size_t slot) {
+    const uint32_t index = slots_[slot].index - 1;
+    const uint32_t last = static_cast<uint32_t>(endpoints_.size() - 1);
+
+    unschedule(index);
+    eraseSlot(slot);
+
+    if (index != last) {
+      // Move the last entry into the hole and repoint its slot and its wheel bucket entry
+      endpoints_[index] = endpoints_[last];
+      meta_[index] = meta_[last];
+      slots_[find(endpoints_[index], meta_[index].hash)].index = index + 1;
+      wheel_[meta_[index].bucket][meta_[index].bucketPos] = index;
+    }
+    endpoints_.pop_back();
+    meta_.pop_back();
+  }
+
+  void unschedule(uint32_t index) {
+    const Meta& meta = meta_[index];
+    auto& bucket = wheel_[meta.bucket];
+    const uint32_t moved = bucket.back();
+    bucket[meta.bucketPos] = moved;
+    meta_[moved].bucketPos = meta.bucketPos;
+    bucket.pop_back();
+  }
+
+  void eraseSlot(std::size_t hole) {
+    // Backward-shift deletion: no tombstones, probe sequences stay short under churn
+    slots_[hole] = {};
+    for (std::size_t next = (hole + 1) & mask_; slots_[next].used(); next = (next + 1) & mask_) {
+      const std::size_t home = slots_[next].hash & mask_;
+      // Move `next` into the hole if its home position is not in (hole, next]
+      const bool movable = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+      if (movable) {
+        slots_[hole] = slots_[next];
+        slots_[next] = {};
+        hole = next;
+      }
+    }
+  }
+
+  void rehash(std::size_t capacity) {
+    slots_.assign(capacity, {});
+    mask_ = capacity - 1;
+    for (uint32_t i = 0; i < endpoints_.size(); ++i) {
+      std::size_t slot = meta_[i].hash & mask_;
+      while (slots_[slot].used()) slot = (slot + 1) & mask_;
+      slots_[slot] = {i + 1, meta_[i].hash};
+    }
+  }
+
+  Options options_;
+  Clock::time_point epoch_;
+  uint64_t ttlTicks_ = 1;
+  uint64_t currentTick_ = 0;
+
+  std::vector<Endpoint> endpoints_;  // Dense, iterated by broadcasts
+  std::vector<Meta> meta_;           // Parallel to endpoints_
+  std::vector<Slot> slots_;          // Open addressing index
+  std::size_t mask_ = 0;
+
+  std::vector<std::vector<uint32_t>> wheel_;  // Bucket = tick % size, holds indices into endpoints_
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <asio.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Streaming frame decoder for TCP (or TLS) byte streams.
+//
+// A read may contain several frames, a part of a frame or both. The decoder owns the receive buffer: the socket reads
+// straight into `prepare()`, and `next()` returns every complete frame as a view into that buffer (no copies).
+// The unparsed tail is moved to the front of the buffer only when the free space runs out, so frames are always
+// contiguous. The buffer grows up to the largest frame and then stays at that size.
+//
+// Modes:
+// - Newline:      "<payload>\n" (a "\r\n" terminator is accepted too, the '\r' is not part of the payload)
+// - LengthPrefix: "<4-byte big-endian payload size><payload>"
+//
+// Views returned by next() stay valid until the next prepare(). Frames returned one after another are adjacent in
+// memory, so all frames of one read may be forwarded as one block: [first.wire.data(), last.wire.data() + size).
+//
+// USAGE:
+// socket_.async_read_some(decoder_.prepare(), [this](std::error_code ec, std::size_t length) {
+//   decoder_.commit(length);
+//   FrameDecoder::Frame frame;
+//   FrameDecoder::Status status;
+//   while ((status = decoder_.next(frame)) == FrameDecoder::Status::Frame) handle(frame.payload);
+//   if (status == FrameDecoder::Status::TooLarge) close();
+// });
+class FrameDecoder {
+ public:
+  enum class Mode {
+    Newline,
+    LengthPrefix,
+  };
+
+  enum class Status {
+    Frame,     // A complete frame is returned
+    NeedMore,  // Read more bytes
+    TooLarge,  // The peer sent a frame above maxFrameSize. The stream can't be resynchronized, close it.
+  };
+
+  struct Options {
+    Mode mode = Mode::Newline;
+    std::size_t maxFrameSize = 64 * 1024;  // Payload bytes
+    std::size_t readSize = 4096;           // Minimum free space offered to every read
+  };
+
+  struct Frame {
+    std::string_view payload;  // Without the delimiter or the length prefix
+    std::string_view wire;     // Exactly as received, including the delimiter or the length prefix
+  };
+
+  static constexpr std::size_t lengthPrefixSize = 4;
+
+  FrameDecoder() : FrameDecoder(Options{}) {}
+
+  explicit FrameDecoder(Options options) : options_(options) {
+    options_.readSize = std::max<std::size_t>(options_.readSize, 1);
+    buffer_.resize(options_.readSize);
+  }
+
+  // Free space at the end of the buffer for the next read. Invalidates views returned by next().
+  asio::mutable_buffer prepare() {
+    if (readPos_ == writePos_) {
+      readPos_ = writePos_ = scanPos_ = 0;
+    }
+
+    if (buffer_.size() - writePos_ < options_.readSize && readPos_ > 0) {
+      // Move the partial frame to the front. It is smaller than one frame, so this is cheap and rare.
+      const std::size_t unparsed = writePos_ - readPos_;
+      std::memmove(buffer_.data(), buffer_.data() + readPos_, unparsed);
+      scanPos_ -= readPos_;
+      readPos_ = 0;
+      writePos_ = unparsed;
+    }
+
+    if (buffer_.size() - writePos_ < options_.readSize) {
+      buffer_.resize(std::max(buffer_.size() * 2, writePos_ + options_.readSize));
+    }
+
+    return asio::buffer(buffer_.data() + writePos_, buffer_.size() - writePos_);
+  }
+
+  // Must be called after the read into prepare() completes, with the number of bytes read.
+  void commit(std::size_t length) { writePos_ += length; }
+
+  Status next(Frame& frame) {
+    return options_.mode == Mode::Newline ? nextLine(frame) : nextLengthPrefixed(frame);
+  }
+
+  // Received bytes which are not returned as frames yet
+  std::size_t buffered() const { return writePos_ - readPos_; }
+
+  const Options& options() const { return options_; }
+
+  // Appends the payload framed for the given mode
+  static void encode(Mode mode, std::string_view payload, std::string& out) {
+    if (mode == Mode::Newline) {
+      out.append(payload);
+      out.push_back('\n');
+      return;
+    }
+
+    const auto size = static_cast<uint32_t>(payload.size());
+    const char prefix[lengthPrefixSize] = {static_cast<char>(size >> 24), static_cast<char>(size >> 16),
+                                           static_cast<char>(size >> 8), static_cast<char>(size)};
+    out.append(prefix, lengthPrefixSize);
+    out.append(payload);
+  }
+
+ private:
+  Status nextLine(Frame& frame) {
+    // Bytes before scanPos_ are already known to contain no delimiter
+    const char* begin = buffer_.data() + readPos_;
+    const char* scanFrom = buffer_.data() + scanPos_;
+    const auto* delimiter = static_cast<const char*>(std::memchr(scanFrom, '\n', writePos_ - scanPos_));
+
+    if (!delimiter) {
+      scanPos_ = writePos_;
+      return buffered() > options_.maxFrameSize ? Status::TooLarge : Status::NeedMore;
+    }
+
+    std::size_t payloadSize = delimiter - begin;
+    const std::size_t wireSize = payloadSize + 1;
+    if (payloadSize > 0 && begin[payloadSize - 1] == '\r') --payloadSize;
+    if (payloadSize > options_.maxFrameSize) return Status::TooLarge;
+
+    frame.payload = std::string_view(begin, payloadSize);
+    frame.wire = std::string_view(begin, wireSize);
+    readPos_ += wireSize;
+    scanPos_ = readPos_;
+    return Status::Frame;
+  }
+
+  Status nextLengthPrefixed(Frame& frame) {
+    if (buffered() < lengthPrefixSize) return Status::NeedMore;
+
+    const auto* begin = reinterpret_cast<const unsigned char*>(buffer_.data() + readPos_);
+    const std::size_t payloadSize = (std::size_t{begin[0]} << 24) | (std::size_t{begin[1]} << 16) |
+                                    (std::size_t{begin[2]} << 8) | std::size_t{begin[3]};
+    if (payloadSize > options_.maxFrameSize) return Status::TooLarge;
+
+    const std::size_t wireSize = lengthPrefixSize + payloadSize;
+    if (buffered() < wireSize) return Status::NeedMore;
+
+    const char* wire = buffer_.data() + readPos_;
+    frame.payload = std::string_view(wire + lengthPrefixSize, payloadSize);
+    frame.wire = std::string_view(wire, wireSize);
+    readPos_ += wireSize;
+    scanPos_ = readPos_;
+    return Status::Frame;
+  }
+
+  Options options_;
+  std::vector<char> buffer_;
+  std::size_t readPos_ = 0;   // First byte not returned as a frame yet
+  std::size_t scanPos_ = 0;   // Newline mode: first byte not searched for the delimiter yet
+  std::size_t writePos_ = 0;  // End of received bytes
+};
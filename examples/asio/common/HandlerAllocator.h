@@ -0,0 +1,207 @@
+#pragma once
+
+#include <asio.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+
+// Recycling allocator for asio completion handlers backed by per-thread slabs.
+//
+// Every async operation stores its handler (and the operation state) in memory obtained from the handler's
+// associated allocator. With many sessions, most operations miss asio's small per-thread cache and go to malloc.
+// HandlerSlab keeps per-thread free lists of fixed-size blocks carved from bigger slabs, so in steady state an
+// async operation never touches the global heap and never contends on the malloc lock.
+//
+// - Blocks freed on another thread go to that thread's free list. A thread keeps at most maxCachedBlocks free blocks
+//   per size class: above it a batch of blocksPerSlab goes to a global depot, where the allocating threads pick them
+//   up. Cross-thread frees (posts between shards) therefore don't pile memory up on the freeing thread.
+//   Slabs are never returned to the heap.
+// - When a thread exits, its free blocks are moved to a global depot and reused by other threads.
+// - Requests bigger than the largest size class fall back to ::operator new.
+//
+// USAGE:
+// socket_.async_read_some(buffer, withHandlerAllocator([this, self](std::error_code ec, std::size_t n) { ... }));
+//
+// HandlerSlab::setEnabled(false) switches to asio's default recycling allocator (used by benchmarks to compare).
+// The mode must not be changed while any handler allocated by HandlerAllocator is alive.
+class HandlerSlab {
+ public:
+  static constexpr std::array<std::size_t, 5> sizeClasses = {64, 128, 256, 512, 1024};
+  static constexpr std::size_t blocksPerSlab = 64;
+  static constexpr std::size_t maxCachedBlocks = 4 * blocksPerSlab;  // Per thread and size class
+
+  static void setEnabled(bool enabled) { enabledFlag().store(enabled, std::memory_order_relaxed); }
+
+  static bool enabled() { return enabledFlag().load(std::memory_order_relaxed); }
+
+  // Number of slabs allocated by all threads (each one is a single ::operator new call)
+  static std::size_t slabCount() { return slabCounter().load(std::memory_order_relaxed); }
+
+  static void* allocate(std::size_t size) {
+    const std::size_t sizeClass = classOf(size);
+    if (sizeClass == sizeClasses.size()) return ::operator new(size);
+
+    ThreadCache& cache = threadCache();
+    FreeBlock* block = cache.free[sizeClass];
+    if (!block) {
+      block = refill(sizeClass);
+    }
+    cache.free[sizeClass] = block->next;
+    --cache.count[sizeClass];
+    return block;
+  }
+
+  static void deallocate(void* p, std::size_t size) {
+    const std::size_t sizeClass = classOf(size);
+    if (sizeClass == sizeClasses.size()) {
+      ::operator delete(p);
+      return;
+    }
+
+    ThreadCache& cache = threadCache();
+    auto* block = static_cast<FreeBlock*>(p);
+    block->next = cache.free[sizeClass];
+    cache.free[sizeClass] = block;
+    if (++cache.count[sizeClass] > maxCachedBlocks) release(cache, sizeClass);
+  }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct Depot {
+    std::mutex mutex;
+    std::array<FreeBlock*, sizeClasses.size()> free{};
+  };
+
+  struct ThreadCache {
+    std::array<FreeBlock*, sizeClasses.size()> free{};
+    std::array<std::size_t, sizeClasses.size()> count{};  // Blocks in `free`
+
+    ~ThreadCache() {
+      // Give the free blocks to other threads. Blocks still in use are returned to the thread which frees them.
+      Depot& d = depot();
+      std::lock_guard lock(d.mutex);
+      for (std::size_t i = 0; i < free.size(); ++i) {
+        while (FreeBlock* block = free[i]) {
+          free[i] = block->next;
+          block->next = d.free[i];
+          d.free[i] = block;
+        }
+      }
+    }
+  };
+
+  static std::size_t classOf(std::size_t size) {
+    std::size_t i = 0;
+    while (i < sizeClasses.size() && size > sizeClasses[i]) ++i;
+    return i;
+  }
+
+  static FreeBlock* refill(std::size_t sizeClass) {
+    ThreadCache& cache = threadCache();
+
+    {
+      Depot& d = depot();
+      std::lock_guard lock(d.mutex);
+      if (FreeBlock* first = d.free[sizeClass]) {  // At most a batch: the depot serves every thread
+        FreeBlock* last = first;
+        std::size_t count = 1;
+        for (; count < blocksPerSlab && last->next; ++count) last = last->next;
+        d.free[sizeClass] = last->next;
+        last->next = nullptr;
+        cache.free[sizeClass] = first;
+        cache.count[sizeClass] = count;
+        return first;
+      }
+    }
+
+    // Carve a new slab into blocks. The memory is owned by the process for its lifetime.
+    const std::size_t blockSize = sizeClasses[sizeClass];
+    auto* slab = static_cast<char*>(::operator new(blockSize * blocksPerSlab));
+    slabCounter().fetch_add(1, std::memory_order_relaxed);
+
+    FreeBlock* head = nullptr;
+    for (std::size_t i = blocksPerSlab; i-- > 0;) {
+      auto* block = reinterpret_cast<FreeBlock*>(slab + i * blockSize);
+      block->next = head;
+      head = block;
+    }
+    cache.free[sizeClass] = head;
+    cache.count[sizeClass] = blocksPerSlab;
+    return head;
+  }
+
+  // Moves the first blocksPerSlab free blocks of the thread to the depot: one lock per batch, not per free
+  static void release(ThreadCache& cache, std::size_t sizeClass) {
+    FreeBlock* first = cache.free[sizeClass];
+    FreeBlock* last = first;
+    for (std::size_t i = 1; i < blocksPerSlab; ++i) last = last->next;
+    cache.free[sizeClass] = last->next;
+    cache.count[sizeClass] -= blocksPerSlab;
+
+    Depot& d = depot();
+    std::lock_guard lock(d.mutex);
+    last->next = d.free[sizeClass];
+    d.free[sizeClass] = first;
+  }
+
+  static ThreadCache& threadCache() {
+    thread_local ThreadCache cache;
+    return cache;
+  }
+
+  static Depot& depot() {
+    static Depot* d = new Depot();  // Never destroyed: thread caches may be flushed during static destruction
+    return *d;
+  }
+
+  static std::atomic<bool>& enabledFlag() {
+    static std::atomic<bool> flag{true};
+    return flag;
+  }
+
+  static std::atomic<std::size_t>& slabCounter() {
+    static std::atomic<std::size_t> counter{0};
+    return counter;
+  }
+};
+
+// Standard allocator interface over HandlerSlab. Use it as the associated allocator of completion handlers.
+template <typename T>
+class HandlerAllocator {
+ public:
+  using value_type = T;
+
+  HandlerAllocator() noexcept = default;
+
+  template <typename U>
+  HandlerAllocator(const HandlerAllocator<U>&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Slab blocks are aligned to max_align_t only");
+    if (!HandlerSlab::enabled()) return asio::recycling_allocator<T>().allocate(n);
+    return static_cast<T*>(HandlerSlab::allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) {
+    if (!HandlerSlab::enabled()) return asio::recycling_allocator<T>().deallocate(p, n);
+    HandlerSlab::deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const HandlerAllocator<U>&) const noexcept { return true; }
+
+  template <typename U>
+  bool operator!=(const HandlerAllocator<U>&) const noexcept { return false; }
+};
+
+// Attaches HandlerAllocator to a completion handler
+template <typename Handler>
+auto withHandlerAllocator(Handler&& handler) {
+  return asio::bind_allocator(HandlerAllocator<void>(), std::forward<Handler>(handler));
+}
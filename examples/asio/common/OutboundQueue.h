@@ -0,0 +1,130 @@
+#pragma once
+
+#include <asio.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+#include "SharedMessage.h"
+
+// Outbound message queue of one session. Not thread safe: it is owned by the session's io_context thread.
+//
+// - Only one write is in flight at a time, so frames of different messages are never interleaved on the socket.
+// - Messages queued while a write is in flight are coalesced into the next write:
+//   `gatherBuffers()` returns them as one scatter-gather (writev) sequence without copying the bytes,
+//   `linearize()` copies them into one reusable contiguous buffer (preferred for TLS streams, which encrypt one
+//   buffer per record, so one big buffer gives one big record).
+// - The amount of queued bytes is bounded by the high-water mark. A slow consumer either loses new messages
+//   (`DropNewest`) or is disconnected (`Disconnect`) instead of growing the memory without limit.
+//
+// USAGE:
+// void deliver(const SharedMessage& msg) {
+//   if (outbox_.push(msg) == OutboundQueue::PushResult::Queued && !outbox_.writing()) doWrite();
+// }
+// void doWrite() {
+//   asio::async_write(socket_, outbox_.gatherBuffers(), [this, self](std::error_code ec, std::size_t) {
+//     outbox_.completeWrite();
+//     if (!ec && outbox_.hasPending()) doWrite();
+//   });
+// }
+class OutboundQueue {
+ public:
+  enum class OverflowPolicy {
+    DropNewest,  // Drop the message which does not fit. The connection stays alive.
+    Disconnect,  // The caller must close the connection.
+  };
+
+  struct Limits {
+    std::size_t highWaterMarkBytes = 4 * 1024 * 1024;  // Queued + in flight
+    OverflowPolicy overflowPolicy = OverflowPolicy::Disconnect;
+    std::size_t maxMessagesPerWrite = 64;  // Maximum buffers in one gather write (IOV_MAX is usually 1024)
+  };
+
+  enum class PushResult {
+    Queued,    // Start a write if none is in flight
+    Dropped,   // High-water mark reached, message dropped
+    Overflow,  // High-water mark reached, disconnect the slow consumer
+  };
+
+  struct Stats {
+    std::size_t queueDepth = 0;      // Messages waiting for the next write
+    std::size_t queuedBytes = 0;     // Bytes waiting for the next write
+    std::size_t bytesInFlight = 0;   // Bytes of the write in progress
+    uint64_t writes = 0;             // Completed writes
+    uint64_t messagesWritten = 0;    // Messages in completed writes (messagesWritten / writes = coalescing factor)
+    uint64_t droppedMessages = 0;
+  };
+
+  OutboundQueue() = default;
+
+  explicit OutboundQueue(Limits limits) : limits_(limits) {}
+
+  PushResult push(const SharedMessage& msg) {
+    if (stats_.queuedBytes + stats_.bytesInFlight + msg.size() > limits_.highWaterMarkBytes) {
+      ++stats_.droppedMessages;
+      return limits_.overflowPolicy == OverflowPolicy::DropNewest ? PushResult::Dropped : PushResult::Overflow;
+    }
+
+    pending_.push_back(msg);
+    stats_.queuedBytes += msg.size();
+    stats_.queueDepth = pending_.size();
+    return PushResult::Queued;
+  }
+
+  bool writing() const { return !inFlight_.empty(); }
+
+  bool hasPending() const { return !pending_.empty(); }
+
+  // Moves pending messages to the in-flight batch and returns them as a gather sequence.
+  // The span stays valid until completeWrite(). It is cheap to copy into asio's write operation (no allocations).
+  std::span<const asio::const_buffer> gatherBuffers() {
+    takeBatch();
+    buffers_.clear();
+    for (auto& msg : inFlight_) {
+      buffers_.push_back(msg.buffer());
+    }
+    return buffers_;
+  }
+
+  // Same as gatherBuffers() but the batch is copied into one contiguous buffer.
+  asio::const_buffer linearize() {
+    takeBatch();
+    linear_.clear();
+    for (auto& msg : inFlight_) {
+      linear_.insert(linear_.end(), msg.data(), msg.data() + msg.size());
+    }
+    return asio::buffer(linear_);
+  }
+
+  // Must be called when the write started by gatherBuffers() / linearize() completes (successfully or not).
+  void completeWrite() {
+    ++stats_.writes;
+    stats_.messagesWritten += inFlight_.size();
+    stats_.bytesInFlight = 0;
+    inFlight_.clear();  // Capacity is kept for the next batch
+  }
+
+  const Stats& stats() const { return stats_; }
+
+  const Limits& limits() const { return limits_; }
+
+ private:
+  void takeBatch() {
+    while (!pending_.empty() && inFlight_.size() < limits_.maxMessagesPerWrite) {
+      stats_.bytesInFlight += pending_.front().size();
+      stats_.queuedBytes -= pending_.front().size();
+      inFlight_.push_back(std::move(pending_.front()));
+      pending_.pop_front();
+    }
+    stats_.queueDepth = pending_.size();
+  }
+
+  Limits limits_;
+  Stats stats_;
+  std::deque<SharedMessage> pending_;
+  std::vector<SharedMessage> inFlight_;
+  std::vector<asio::const_buffer> buffers_;
+  std::vector<char> linear_;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <utility>
+
+// Immutable reference counted message buffer.
+// The header (reference counter and size) and the payload live in one heap block, so creating a message costs exactly
+// one allocation. Copies only increment the atomic counter, so the same bytes may be shared by every pending
+// async_write of a broadcast, even across threads (shards).
+// USAGE:
+// SharedMessage msg(std::string_view(data, length));  // One allocation per broadcast
+// for (auto& session : sessions) session->deliver(msg);  // No allocations, no copies
+// asio::async_write(socket, msg.buffer(), [msg](std::error_code, std::size_t) {});  // Keep msg alive in handler
+class SharedMessage {
+ public:
+  SharedMessage() = default;
+
+  explicit SharedMessage(std::string_view data) {
+    void* memory = ::operator new(sizeof(Block) + data.size());
+    block_ = new (memory) Block{{1}, data.size()};
+    std::memcpy(block_->payload(), data.data(), data.size());
+  }
+
+  SharedMessage(const SharedMessage& other) noexcept : block_(other.block_) {
+    if (block_) block_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  SharedMessage(SharedMessage&& other) noexcept : block_(std::exchange(other.block_, nullptr)) {}
+
+  SharedMessage& operator=(SharedMessage other) noexcept {
+    std::swap(block_, other.block_);
+    return *this;
+  }
+
+  ~SharedMessage() {
+    if (block_ && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      block_->~Block();
+      ::operator delete(block_);
+    }
+  }
+
+  const char* data() const { return block_ ? block_->payload() : nullptr; }
+
+  std::size_t size() const { return block_ ? block_->size : 0; }
+
+  bool empty() const { return size() == 0; }
+
+  std::string_view view() const { return {data(), size()}; }
+
+  asio::const_buffer buffer() const { return asio::buffer(data(), size()); }
+
+ private:
+  struct Block {
+    std::atomic<std::size_t> refs;
+    std::size_t size;
+
+    char* payload() { return reinterpret_cast<char*>(this + 1); }
+  };
+
+  Block* block_ = nullptr;
+};
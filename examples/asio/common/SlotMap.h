@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Dense slot map: O(1) insert and erase, contiguous iteration, generation-checked handles.
+//
+// Values are stored in one contiguous vector (iteration is a linear scan, no pointer chasing).
+// Handles point to slots; a slot points to the value's current position in the dense vector.
+// Erase moves the last value into the hole, so the order of values is not stable.
+// The slot's generation is incremented on erase, so a stale handle never reaches a newer value.
+//
+// USAGE:
+// SlotMap<std::shared_ptr<ClientSession>> sessions;
+// auto handle = sessions.insert(session);  // Keep the handle in the session
+// sessions.erase(handle);                  // O(1), stale handles are ignored
+// for (auto& session : sessions) {}        // Contiguous
+template <typename T>
+class SlotMap {
+ public:
+  struct Handle {
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+    uint32_t generation = 0;
+
+    bool valid() const { return index != std::numeric_limits<uint32_t>::max(); }
+  };
+
+  void reserve(std::size_t n) {
+    values_.reserve(n);
+    denseToSlot_.reserve(n);
+    slots_.reserve(n);
+  }
+
+  Handle insert(T value) {
+    uint32_t slotIndex;
+    if (freeHead_ != npos) {
+      slotIndex = freeHead_;
+      freeHead_ = slots_[slotIndex].denseIndex;  // Free slots store the next free slot here
+    } else {
+      slotIndex = static_cast<uint32_t>(slots_.size());
+      slots_.push_back({});
+    }
+
+    Slot& slot = slots_[slotIndex];
+    slot.denseIndex = static_cast<uint32_t>(values_.size());
+    values_.push_back(std::move(value));
+    denseToSlot_.push_back(slotIndex);
+    return {slotIndex, slot.generation};
+  }
+
+  // Returns false if the handle is stale (already erased)
+  bool erase(Handle handle) {
+    if (!contains(handle)) return false;
+
+    Slot& slot = slots_[handle.index];
+    const uint32_t hole = slot.denseIndex;
+    const uint32_t last = static_cast<uint32_t>(values_.size() - 1);
+
+    if (hole != last) {
+      values_[hole] = std::move(values_[last]);
+      denseToSlot_[hole] = denseToSlot_[last];
+      slots_[denseToSlot_[hole]].denseIndex = hole;
+    }
+    values_.pop_back();
+    denseToSlot_.pop_back();
+
+    ++slot.generation;
+    slot.denseIndex = freeHead_;
+    freeHead_ = handle.index;
+    return true;
+  }
+
+  bool contains(Handle handle) const {
+    return handle.index < slots_.size() && slots_[handle.index].generation == handle.generation;
+  }
+
+  T* get(Handle handle) { return contains(handle) ? &values_[slots_[handle.index].denseIndex] : nullptr; }
+
+  const T* get(Handle handle) const { return contains(handle) ? &values_[slots_[handle.index].denseIndex] : nullptr; }
+
+  std::size_t size() const { return values_.size(); }
+
+  bool empty() const { return values_.empty(); }
+
+  auto begin() { return values_.begin(); }
+
+  auto end() { return values_.end(); }
+
+  auto begin() const { return values_.begin(); }
+
+  auto end() const { return values_.end(); }
+
+ private:
+  static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+  struct Slot {
+    uint32_t denseIndex = 0;  // Position in values_ or, for a free slot, the next free slot
+    uint32_t generation = 0;
+  };
+
+  std::vector<T> values_;
+  std::vector<uint32_t> denseToSlot_;
+  std::vector<Slot> slots_;
+  uint32_t freeHead_ = npos;
+};
@@ -0,0 +1,172 @@
+// Participant registry of the UDP chat server: std::set<udp::endpoint> vs EndpointTable, 1M distinct endpoints.
+//
+// - insert:  every endpoint sends its first datagram, ns per new endpoint.
+// - lookup:  random datagrams from known endpoints, ns per datagram.
+// - churn:   simulated time. Every tick `arrivals` new endpoints appear and the active ones keep sending for `lifetime`
+//            ticks, then go silent. std::set (the old registry) keeps every endpoint ever seen, EndpointTable expires
+//            silent ones after the TTL, so its size stays bounded by arrivals * (lifetime + ttl).
+// - iterate: one broadcast over the final registry, ns per participant.
+
+#include <algorithm>
+#include <asio.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../EndpointTable.h"
+#include "cxxopts.hpp"
+
+using asio::ip::udp;
+using Clock = std::chrono::steady_clock;
+
+struct ChurnConfig {
+  std::size_t ticks = 200;
+  std::size_t arrivals = 5000;  // New endpoints per tick
+  std::size_t lifetime = 10;    // Ticks an endpoint keeps sending
+  std::size_t ttlTicks = 5;
+};
+
+struct Result {
+  double insertNs = 0;
+  double lookupNs = 0;
+  double churnNs = 0;  // Per datagram, expiry included
+  double iterateNs = 0;
+  std::size_t finalSize = 0;
+  uint64_t checksum = 0;
+};
+
+std::vector<udp::endpoint> makeEndpoints(std::size_t count, uint64_t seed) {
+  // Distinct (address, port) pairs from 10.0.0.0/8 with random ports
+  std::mt19937_64 rng(seed);
+  std::set<std::pair<uint32_t, uint16_t>> seen;
+  std::vector<udp::endpoint> endpoints;
+  endpoints.reserve(count);
+  while (endpoints.size() < count) {
+    const uint32_t address = 0x0A000000u | static_cast<uint32_t>(rng() & 0x00FFFFFFu);
+    const auto port = static_cast<uint16_t>(1024 + rng() % 64000);
+    if (seen.emplace(address, port).second) {
+      endpoints.emplace_back(asio::ip::address_v4(address), port);
+    }
+  }
+  return endpoints;
+}
+
+double nsSince(Clock::time_point start, std::size_t operations) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(std::max<std::size_t>(1, operations));
+}
+
+// Minimal interface over both registries
+struct SetRegistry {
+  std::set<udp::endpoint> participants;
+
+  void touch(const udp::endpoint& endpoint) { participants.insert(endpoint); }
+  void advance(Clock::time_point) {}  // No expiry
+  std::size_t size() const { return participants.size(); }
+  auto begin() const { return participants.begin(); }
+  auto end() const { return participants.end(); }
+};
+
+struct TableRegistry {
+  explicit TableRegistry(EndpointTable::Options options, Clock::time_point epoch) : participants(options, epoch) {}
+
+  EndpointTable participants;
+
+  void touch(const udp::endpoint& endpoint) { participants.touch(endpoint); }
+  void advance(Clock::time_point now) { participants.expire(now); }
+  std::size_t size() const { return participants.size(); }
+  auto begin() const { return participants.begin(); }
+  auto end() const { return participants.end(); }
+};
+
+template <typename Registry, typename MakeRegistry>
+Result run(const std::vector<udp::endpoint>& endpoints, std::size_t lookups, const ChurnConfig& churn, MakeRegistry makeRegistry) {
+  Result result;
+  std::mt19937_64 rng(7);
+  const auto epoch = Clock::time_point();
+  const auto tick = std::chrono::milliseconds(1000);
+
+  {
+    Registry registry = makeRegistry(epoch);
+    auto start = Clock::now();
+    for (auto& endpoint : endpoints) registry.touch(endpoint);
+    result.insertNs = nsSince(start, endpoints.size());
+
+    start = Clock::now();
+    for (std::size_t i = 0; i < lookups; ++i) registry.touch(endpoints[rng() % endpoints.size()]);
+    result.lookupNs = nsSince(start, lookups);
+  }
+
+  // Every active endpoint sends one datagram per tick
+  Registry registry = makeRegistry(epoch);
+  std::size_t datagrams = 0;
+  auto start = Clock::now();
+  for (std::size_t t = 0; t < churn.ticks; ++t) {
+    registry.advance(epoch + tick * t);
+    const std::size_t end = std::min(endpoints.size(), (t + 1) * churn.arrivals);
+    const std::size_t begin = t >= churn.lifetime ? (t - churn.lifetime) * churn.arrivals : 0;
+    for (std::size_t i = begin; i < end; ++i) registry.touch(endpoints[i]);
+    datagrams += end - std::min(begin, end);
+  }
+  result.churnNs = nsSince(start, datagrams);
+  result.finalSize = registry.size();
+
+  start = Clock::now();
+  for (auto& endpoint : registry) result.checksum += endpoint.port();
+  result.iterateNs = nsSince(start, registry.size());
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "UDP participant registry: std::set vs EndpointTable");
+  // clang-format off
+  options.add_options()
+      ("n,endpoints", "Distinct source endpoints", cxxopts::value<std::size_t>()->default_value("1000000"))
+      ("l,lookups", "Datagrams from known endpoints", cxxopts::value<std::size_t>()->default_value("10000000"))
+      ("a,arrivals", "Churn: new endpoints per tick", cxxopts::value<std::size_t>()->default_value("5000"))
+      ("lifetime", "Churn: ticks an endpoint keeps sending", cxxopts::value<std::size_t>()->default_value("10"))
+      ("ttl", "Churn: ticks of silence before expiry", cxxopts::value<std::size_t>()->default_value("5"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  const std::size_t count = std::max<std::size_t>(1, args["endpoints"].as<std::size_t>());
+  const std::size_t lookups = args["lookups"].as<std::size_t>();
+  ChurnConfig churn;
+  churn.arrivals = std::max<std::size_t>(1, args["arrivals"].as<std::size_t>());
+  churn.lifetime = args["lifetime"].as<std::size_t>();
+  churn.ttlTicks = std::max<std::size_t>(1, args["ttl"].as<std::size_t>());
+  churn.ticks = (count + churn.arrivals - 1) / churn.arrivals;  // Every endpoint appears once
+
+  std::cout << "Generating " << count << " endpoints..." << std::endl;
+  const auto endpoints = makeEndpoints(count, 42);
+
+  EndpointTable::Options tableOptions;
+  tableOptions.ttl = std::chrono::milliseconds(1000 * churn.ttlTicks);
+  tableOptions.tick = std::chrono::milliseconds(1000);
+  tableOptions.maxEntries = count;
+
+  Result set = run<SetRegistry>(endpoints, lookups, churn, [](Clock::time_point) { return SetRegistry(); });
+  Result table = run<TableRegistry>(endpoints, lookups, churn, [&](Clock::time_point epoch) { return TableRegistry(tableOptions, epoch); });
+
+  std::cout << "\nendpoints=" << count << " lookups=" << lookups << " churn: arrivals/tick=" << churn.arrivals
+            << " lifetime=" << churn.lifetime << " ttl=" << churn.ttlTicks << " ticks=" << churn.ticks << "\n\n";
+  std::cout << std::left << std::setw(16) << "registry" << std::setw(12) << "insert ns" << std::setw(12) << "lookup ns"
+            << std::setw(16) << "churn ns/dgram" << std::setw(14) << "final size" << std::setw(14) << "iterate ns" << "checksum" << std::endl;
+  for (auto& [name, r] : {std::pair<std::string, Result>{"std::set", set}, {"EndpointTable", table}}) {
+    std::cout << std::left << std::setw(16) << name << std::fixed << std::setprecision(1) << std::setw(12) << r.insertNs
+              << std::setw(12) << r.lookupNs << std::setw(16) << r.churnNs << std::setw(14) << r.finalSize << std::setw(14)
+              << std::setprecision(2) << r.iterateNs << r.checksum << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+// Throughput of FrameDecoder on small and large frames, in both modes.
+//
+// A pre-encoded stream is fed to the decoder in chunks of `read` bytes, as a socket would deliver it
+// (one memcpy per chunk stands in for read_some). Every frame payload is touched (checksum), so the numbers include
+// the cost of handing the frame to the application.
+// The `copying` row is the common naive decoder: append every read to a std::string, copy each frame out into its own
+// std::string and erase it from the front of the buffer.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../FrameDecoder.h"
+#include "cxxopts.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  uint64_t frames = 0;
+  uint64_t checksum = 0;
+  double seconds = 0;
+};
+
+std::string makeStream(FrameDecoder::Mode mode, std::size_t frameSize, std::size_t totalBytes) {
+  std::string payload(frameSize, 'x');
+  std::string stream;
+  stream.reserve(totalBytes + frameSize + FrameDecoder::lengthPrefixSize);
+  for (uint64_t i = 0; stream.size() < totalBytes; ++i) {
+    payload[0] = static_cast<char>('a' + i % 26);  // Never '\n'
+    FrameDecoder::encode(mode, payload, stream);
+  }
+  return stream;
+}
+
+Result runDecoder(const std::string& stream, FrameDecoder::Mode mode, std::size_t frameSize, std::size_t readSize) {
+  Result result;
+  FrameDecoder decoder({mode, frameSize, readSize});
+  FrameDecoder::Frame frame;
+
+  auto start = Clock::now();
+  for (std::size_t offset = 0; offset < stream.size();) {
+    auto buffer = decoder.prepare();
+    const std::size_t length = std::min({buffer.size(), readSize, stream.size() - offset});
+    std::memcpy(buffer.data(), stream.data() + offset, length);
+    offset += length;
+    decoder.commit(length);
+
+    while (decoder.next(frame) == FrameDecoder::Status::Frame) {
+      ++result.frames;
+      result.checksum += static_cast<unsigned char>(frame.payload.front()) + frame.payload.size();
+    }
+  }
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return result;
+}
+
+Result runCopying(const std::string& stream, FrameDecoder::Mode mode, std::size_t readSize) {
+  Result result;
+  std::string buffer;
+  std::string payload;
+
+  auto start = Clock::now();
+  for (std::size_t offset = 0; offset < stream.size();) {
+    const std::size_t length = std::min(readSize, stream.size() - offset);
+    buffer.append(stream, offset, length);
+    offset += length;
+
+    for (;;) {
+      std::size_t payloadOffset = 0, payloadSize = 0, wireSize = 0;
+      if (mode == FrameDecoder::Mode::Newline) {
+        const std::size_t delimiter = buffer.find('\n');
+        if (delimiter == std::string::npos) break;
+        payloadSize = delimiter;
+        wireSize = delimiter + 1;
+      } else {
+        if (buffer.size() < FrameDecoder::lengthPrefixSize) break;
+        const auto* p = reinterpret_cast<const unsigned char*>(buffer.data());
+        payloadSize = (std::size_t{p[0]} << 24) | (std::size_t{p[1]} << 16) | (std::size_t{p[2]} << 8) | std::size_t{p[3]};
+        payloadOffset = FrameDecoder::lengthPrefixSize;
+        wireSize = payloadOffset + payloadSize;
+        if (buffer.size() < wireSize) break;
+      }
+
+      payload.assign(buffer, payloadOffset, payloadSize);
+      buffer.erase(0, wireSize);
+      ++result.frames;
+      result.checksum += static_cast<unsigned char>(payload.front()) + payload.size();
+    }
+  }
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "FrameDecoder throughput on small and large frames");
+  // clang-format off
+  options.add_options()
+      ("s,sizes", "Frame payload sizes in bytes", cxxopts::value<std::vector<std::size_t>>()->default_value("16,64,512,4096,65536"))
+      ("r,read", "Bytes delivered by one read", cxxopts::value<std::size_t>()->default_value("16384"))
+      ("m,megabytes", "Stream size per run", cxxopts::value<std::size_t>()->default_value("256"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  const std::size_t readSize = std::max<std::size_t>(1, args["read"].as<std::size_t>());
+  const std::size_t totalBytes = args["megabytes"].as<std::size_t>() * 1024 * 1024;
+
+  std::cout << "read=" << readSize << " stream=" << totalBytes / (1024 * 1024) << " MiB\n\n";
+  std::cout << std::left << std::setw(14) << "mode" << std::setw(10) << "decoder" << std::setw(10) << "frame B"
+            << std::setw(14) << "frames/sec" << std::setw(10) << "GB/s" << std::setw(12) << "frames" << "checksum" << std::endl;
+
+  for (auto mode : {FrameDecoder::Mode::Newline, FrameDecoder::Mode::LengthPrefix}) {
+    const char* modeName = mode == FrameDecoder::Mode::Newline ? "newline" : "length-prefix";
+    for (auto frameSize : args["sizes"].as<std::vector<std::size_t>>()) {
+      frameSize = std::max<std::size_t>(1, frameSize);
+      const std::string stream = makeStream(mode, frameSize, totalBytes);
+
+      for (bool copying : {false, true}) {
+        Result r = copying ? runCopying(stream, mode, readSize) : runDecoder(stream, mode, frameSize, readSize);
+        std::cout << std::left << std::setw(14) << modeName << std::setw(10) << (copying ? "copying" : "zero-copy")
+                  << std::setw(10) << frameSize << std::setw(14) << std::fixed << std::setprecision(0) << r.frames / r.seconds
+                  << std::setw(10) << std::setprecision(2) << stream.size() / r.seconds / 1e9 << std::setw(12) << r.frames << r.checksum << std::endl;
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,151 @@
+// Microbenchmark of the chat room session registry: std::set<std::shared_ptr<Session>> vs SlotMap.
+//
+// - churn: a random session leaves and a new one joins (the room size stays constant), ns per join+leave pair.
+// - iterate: visit every session of the room and touch it, like ChatRoom::deliver() does, ns per session.
+//
+// Sessions are allocated in random order, so their addresses are scattered over the heap as in a long running server.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../SlotMap.h"
+#include "cxxopts.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// Roughly the size of a real ClientSession (socket, outbound queue, read buffer pointer...)
+struct Session {
+  uint64_t delivered = 0;
+  char state[184] = {};
+};
+
+struct Result {
+  double churnNs = 0;    // Per join + leave
+  double iterateNs = 0;  // Per session per broadcast
+  uint64_t checksum = 0;
+};
+
+std::vector<std::shared_ptr<Session>> makeSessions(std::size_t count, std::mt19937_64& rng) {
+  // Interleave with garbage allocations to scatter the sessions in memory
+  std::vector<std::shared_ptr<Session>> sessions;
+  std::vector<std::unique_ptr<char[]>> garbage;
+  sessions.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    sessions.push_back(std::make_shared<Session>());
+    garbage.push_back(std::make_unique<char[]>(rng() % 512 + 1));
+  }
+  std::shuffle(sessions.begin(), sessions.end(), rng);
+  return sessions;
+}
+
+double nsSince(Clock::time_point start, std::size_t operations) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(operations);
+}
+
+Result benchSet(const std::vector<std::shared_ptr<Session>>& pool, std::size_t roomSize, std::size_t churnOps,
+                std::size_t broadcasts, uint64_t seed) {
+  Result result;
+  std::mt19937_64 rng(seed);
+  std::set<std::shared_ptr<Session>> room;
+  std::vector<std::shared_ptr<Session>> members(pool.begin(), pool.begin() + roomSize);
+  std::vector<std::shared_ptr<Session>> spare(pool.begin() + roomSize, pool.end());
+  for (auto& session : members) room.insert(session);
+
+  auto start = Clock::now();
+  for (std::size_t i = 0; i < churnOps; ++i) {
+    std::size_t victim = rng() % members.size();
+    std::size_t joiner = rng() % spare.size();
+    room.erase(members[victim]);
+    room.insert(spare[joiner]);
+    std::swap(members[victim], spare[joiner]);
+  }
+  result.churnNs = nsSince(start, churnOps);
+
+  start = Clock::now();
+  for (std::size_t b = 0; b < broadcasts; ++b) {
+    for (auto& session : room) {
+      result.checksum += ++session->delivered;
+    }
+  }
+  result.iterateNs = nsSince(start, broadcasts * room.size());
+  return result;
+}
+
+Result benchSlotMap(const std::vector<std::shared_ptr<Session>>& pool, std::size_t roomSize, std::size_t churnOps,
+                    std::size_t broadcasts, uint64_t seed) {
+  using Handle = SlotMap<std::shared_ptr<Session>>::Handle;
+
+  Result result;
+  std::mt19937_64 rng(seed);
+  SlotMap<std::shared_ptr<Session>> room;
+  room.reserve(roomSize);
+  std::vector<Handle> members;  // What the sessions themselves would keep
+  std::vector<std::shared_ptr<Session>> spare(pool.begin() + roomSize, pool.end());
+  for (std::size_t i = 0; i < roomSize; ++i) members.push_back(room.insert(pool[i]));
+
+  auto start = Clock::now();
+  for (std::size_t i = 0; i < churnOps; ++i) {
+    std::size_t victim = rng() % members.size();
+    std::size_t joiner = rng() % spare.size();
+    std::shared_ptr<Session> leaving = std::move(*room.get(members[victim]));
+    room.erase(members[victim]);
+    members[victim] = room.insert(std::move(spare[joiner]));
+    spare[joiner] = std::move(leaving);
+  }
+  result.churnNs = nsSince(start, churnOps);
+
+  start = Clock::now();
+  for (std::size_t b = 0; b < broadcasts; ++b) {
+    for (auto& session : room) {
+      result.checksum += ++session->delivered;
+    }
+  }
+  result.iterateNs = nsSince(start, broadcasts * room.size());
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "Chat room session registry: std::set vs SlotMap");
+  // clang-format off
+  options.add_options()
+      ("n,sessions", "Sessions in the room", cxxopts::value<std::size_t>()->default_value("100000"))
+      ("o,churn", "Join + leave pairs", cxxopts::value<std::size_t>()->default_value("1000000"))
+      ("b,broadcasts", "Full room iterations", cxxopts::value<std::size_t>()->default_value("100"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  const std::size_t roomSize = std::max<std::size_t>(1, args["sessions"].as<std::size_t>());
+  const std::size_t churnOps = args["churn"].as<std::size_t>();
+  const std::size_t broadcasts = std::max<std::size_t>(1, args["broadcasts"].as<std::size_t>());
+  const uint64_t seed = 42;
+
+  std::mt19937_64 rng(seed);
+  auto pool = makeSessions(roomSize + roomSize / 4 + 1, rng);  // 25% of the sessions are outside the room
+
+  Result set = benchSet(pool, roomSize, churnOps, broadcasts, seed);
+  Result slotMap = benchSlotMap(pool, roomSize, churnOps, broadcasts, seed);
+
+  std::cout << "sessions=" << roomSize << " churn=" << churnOps << " broadcasts=" << broadcasts << "\n\n";
+  std::cout << std::left << std::setw(12) << "registry" << std::setw(20) << "join+leave ns" << std::setw(20) << "iterate ns/session"
+            << "checksum" << std::endl;
+  for (auto& [name, r] : {std::pair<std::string, Result>{"std::set", set}, {"SlotMap", slotMap}}) {
+    std::cout << std::left << std::setw(12) << name << std::setw(20) << std::fixed << std::setprecision(1) << r.churnNs
+              << std::setw(20) << std::setprecision(2) << r.iterateNs << r.checksum << std::endl;
+  }
+  return 0;
+}
@@ -2,6 +2,8 @@
 #include <iostream>
 #include <thread>
 
+#include "../../common/FrameDecoder.h"
+
 using asio::ip::tcp;
 
 int main() {
@@ -15,20 +17,30 @@ int main() {
 
     std::thread reader([&socket]() {
       try {
-        char reply[1024];
+        FrameDecoder decoder;  // Newline-delimited messages
         for (;;) {
           std::error_code ec;
-          size_t length = socket.read_some(asio::buffer(reply), ec);
+          size_t length = socket.read_some(decoder.prepare(), ec);
           if (ec) break;
-          std::cout << "Server: " << std::string(reply, length) << std::endl;
+          decoder.commit(length);
+
+          FrameDecoder::Frame frame;
+          FrameDecoder::Status status;
+          while ((status = decoder.next(frame)) == FrameDecoder::Status::Frame) {
+            std::cout << "Server: " << frame.payload << std::endl;
+          }
+          if (status == FrameDecoder::Status::TooLarge) break;
         }
       } catch (...) {
       }
     });
 
     std::string line;
+    std::string frame;
     while (std::getline(std::cin, line)) {
-      asio::write(socket, asio::buffer(line));
+      frame.clear();
+      FrameDecoder::encode(FrameDecoder::Mode::Newline, line, frame);
+      asio::write(socket, asio::buffer(frame));
     }
 
     reader.join();
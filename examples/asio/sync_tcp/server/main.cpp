@@ -1,21 +1,38 @@
 #include <asio.hpp>
 #include <iostream>
 #include <memory>
+#include <string_view>
+
+#include "../../common/FrameDecoder.h"
 
 using asio::ip::tcp;
 
 void session(std::shared_ptr<tcp::socket> clientSocketPrt) {
   try {
-    char data[1024];
+    FrameDecoder decoder;  // Newline-delimited messages
     for (;;) {
       std::error_code ec;
-      size_t length = clientSocketPrt->read_some(asio::buffer(data), ec);
+      size_t length = clientSocketPrt->read_some(decoder.prepare(), ec);
       if (ec == asio::error::eof)
         break;
       else if (ec)
         throw asio::system_error(ec);
+      decoder.commit(length);
+
+      // Echo complete messages only. They are adjacent in the decoder's buffer, so one write sends all of them.
+      FrameDecoder::Frame frame;
+      FrameDecoder::Status status;
+      std::string_view batch;
+      while ((status = decoder.next(frame)) == FrameDecoder::Status::Frame) {
+        batch = batch.empty() ? frame.wire : std::string_view(batch.data(), batch.size() + frame.wire.size());
+      }
+      // The messages before a too large one are echoed before the disconnect
+      if (!batch.empty()) asio::write(*clientSocketPrt, asio::buffer(batch));
 
-      asio::write(*clientSocketPrt, asio::buffer(data, length));
+      if (status == FrameDecoder::Status::TooLarge) {
+        std::cerr << "Session error: message is too large" << std::endl;
+        break;
+      }
     }
   } catch (std::exception& e) {
     std::cerr << "Session error: " << e.what() << std::endl;
@@ -0,0 +1,80 @@
+#include "NetworkMethodsAsync.h"
+
+#include <algorithm>
+#include <cstring>
+
+using asio::ip::tcp;
+
+FrameReader::FrameReader(Options options) : options_(options) {
+  options_.readSize = std::max<std::size_t>(options_.readSize, headerSize);
+  buffer_.resize(options_.readSize);
+}
+
+std::size_t FrameReader::frameSize() const {
+  uint32_t size = 0;
+  std::memcpy(&size, buffer_.data() + begin_, headerSize);
+  if (size > options_.maxFrameSize) {
+    throw asio::system_error(asio::error::message_size);  // Don't trust the peer with our memory
+  }
+  return size;
+}
+
+asio::awaitable<bool> FrameReader::fill(tcp::socket& socket) {
+  // Room for at least one read of readSize bytes, or for the rest of a frame whose size is already known
+  std::size_t needed = options_.readSize;
+  if (buffered() >= headerSize) {
+    const std::size_t frameBytes = headerSize + frameSize();
+    if (frameBytes > buffered()) needed = std::max(needed, frameBytes - buffered());
+  }
+
+  if (buffer_.size() - end_ < needed) {
+    // Move the unread bytes to the front. The buffer only grows for frames larger than readSize.
+    const std::size_t unread = buffered();
+    if (unread > 0) std::memmove(buffer_.data(), buffer_.data() + begin_, unread);
+    begin_ = 0;
+    end_ = unread;
+    if (buffer_.size() - end_ < needed) buffer_.resize(end_ + needed);
+  }
+
+  std::error_code ec;
+  const std::size_t length = co_await socket.async_read_some(asio::buffer(buffer_.data() + end_, buffer_.size() - end_),
+                                                             asio::redirect_error(asio::use_awaitable, ec));
+  if (ec == asio::error::eof) co_return false;
+  if (ec) throw asio::system_error(ec);
+
+  end_ += length;
+  co_return true;
+}
+
+bool FrameReader::next(std::span<const uint8_t>& frame) {
+  if (buffered() < headerSize) return false;
+  const std::size_t size = frameSize();
+  if (buffered() - headerSize < size) return false;
+
+  frame = {buffer_.data() + begin_ + headerSize, size};
+  begin_ += headerSize + size;
+  if (begin_ == end_) begin_ = end_ = 0;  // The next read starts at the front, no compaction needed
+  return true;
+}
+
+asio::awaitable<std::span<const uint8_t>> FrameReader::read(tcp::socket& socket) {
+  std::span<const uint8_t> frame;
+  while (!next(frame)) {
+    if (!co_await fill(socket)) co_return std::span<const uint8_t>{};
+  }
+  co_return frame;
+}
+
+void FrameWriter::append(asio::const_buffer payload) {
+  const auto size = static_cast<uint32_t>(payload.size());
+  const auto* sizeBytes = reinterpret_cast<const uint8_t*>(&size);
+  const auto* payloadBytes = static_cast<const uint8_t*>(payload.data());
+  pending_.insert(pending_.end(), sizeBytes, sizeBytes + sizeof(size));  // 1. size first
+  pending_.insert(pending_.end(), payloadBytes, payloadBytes + payload.size());  // 2. payload
+}
+
+asio::awaitable<void> FrameWriter::flush(tcp::socket& socket) {
+  if (pending_.empty()) co_return;
+  co_await asio::async_write(socket, asio::buffer(pending_), asio::use_awaitable);
+  pending_.clear();  // Keeps the capacity for the next batch
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <asio.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Coroutine versions of readSizeAndData / sendSizeAndData. The wire format is the same:
+// uint32_t size (host byte order) followed by `size` bytes of payload.
+//
+// - One receive buffer per connection, reused for every frame. A single read may bring many frames,
+//   so a peer can pipeline requests without waiting for the replies.
+// - Frames above maxFrameSize are rejected before anything is allocated for them.
+//
+// USAGE EXAMPLE:
+// FrameReader reader;
+// FrameWriter writer;
+// while (co_await reader.fill(socket)) {
+//   std::span<const uint8_t> frame;
+//   while (reader.next(frame)) {
+//     auto monster = MyGame::Sample::GetMonster(frame.data());  // Zero copy
+//     writer.append(asio::buffer(reply));
+//   }
+//   co_await writer.flush(socket);  // All replies of one read in one write
+// }
+class FrameReader {
+ public:
+  struct Options {
+    std::size_t maxFrameSize = 1024 * 1024;  // Larger frames throw asio::error::message_size
+    std::size_t readSize = 64 * 1024;        // Minimum free space offered to one read
+  };
+
+  FrameReader() : FrameReader(Options{}) {}
+
+  explicit FrameReader(Options options);
+
+  // Reads more bytes from the socket. Returns false on EOF. Throws asio::system_error on errors.
+  // Invalidates the frames returned by next().
+  asio::awaitable<bool> fill(asio::ip::tcp::socket& socket);
+
+  // Takes the next complete frame from the buffered bytes. Returns false if more bytes are needed.
+  // The frame is valid until the next call of next() or fill(). Throws asio::system_error on oversized frames.
+  bool next(std::span<const uint8_t>& frame);
+
+  // Waits for the next frame. Returns an empty span on EOF.
+  asio::awaitable<std::span<const uint8_t>> read(asio::ip::tcp::socket& socket);
+
+  // Bytes received but not returned as frames yet
+  std::size_t buffered() const { return end_ - begin_; }
+
+  const Options& options() const { return options_; }
+
+ private:
+  static constexpr std::size_t headerSize = sizeof(uint32_t);
+
+  // Size of the frame at begin_. Requires buffered() >= headerSize.
+  std::size_t frameSize() const;
+
+  Options options_;
+  std::vector<uint8_t> buffer_;
+  std::size_t begin_ = 0;  // Unread bytes are [begin_, end_)
+  std::size_t end_ = 0;
+};
+
+// Collects outgoing frames in one reusable buffer and writes them with a single async_write.
+class FrameWriter {
+ public:
+  // Copies the size and the payload into the pending buffer.
+  void append(asio::const_buffer payload);
+
+  std::size_t pending() const { return pending_.size(); }
+
+  // Writes every appended frame. Throws asio::system_error on errors.
+  asio::awaitable<void> flush(asio::ip::tcp::socket& socket);
+
+ private:
+  std::vector<uint8_t> pending_;
+};
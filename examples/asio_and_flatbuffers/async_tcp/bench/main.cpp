@@ -0,0 +1,268 @@
+// Request / reply benchmark of the Monster servers: thread per connection vs coroutines.
+//
+// For every requested server and in-flight depth the server is started in-process on an ephemeral port,
+// `clients` connections (1000 by default) are opened from a few client threads and every connection keeps `inflight`
+// requests outstanding: each reply immediately triggers the next request. A request is one Monster (batch 1) or a
+// MonsterBatch of `batch` monsters confirmed with one reply, serialized by the client for every send.
+// Both servers speak the same protocol (readSizeAndData / sendSizeAndData frames), the client side is the same
+// coroutine code for both.
+//
+// Servers:
+// - thread: ThreadPerConnectionServer, `../../sync_tcp/server/ThreadPerConnectionServer.h`. One blocking thread
+//           per connection, one std::vector per request, one write per reply.
+// - async:  AsyncMonsterServer, `../server/AsyncMonsterServer.h`. `threads` io_context threads, one coroutine and one
+//           reusable receive buffer per connection, all replies of one read in one write.
+//
+// Reported: replies and monsters per second and request latency percentiles, measured after a warm-up.
+
+#include <algorithm>
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cxxopts.hpp"
+
+#include "../../../LatencyHistogram.h"
+#include "../../sync_tcp/MonsterBatchBuilder.h"
+#include "../../sync_tcp/Serialization.h"
+#include "../../sync_tcp/server/ThreadPerConnectionServer.h"
+#include "../NetworkMethodsAsync.h"
+#include "../server/AsyncMonsterServer.h"
+
+using asio::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+  std::size_t clients = 1000;
+  std::size_t clientThreads = 2;
+  std::size_t serverThreads = 0;  // Async server, 0 - hardware concurrency
+  VerifyOptions verify;
+  std::chrono::milliseconds warmUp{1000};
+  std::chrono::milliseconds duration{3000};
+};
+
+struct BenchResult {
+  std::size_t serverThreads = 0;
+  double repliesPerSec = 0;
+  double monstersPerSec = 0;
+  double p50us = 0;
+  double p99us = 0;
+  double p999us = 0;
+  uint64_t errors = 0;
+};
+
+// State of the connections served by one client thread. Only touched by that thread.
+struct ClientThreadState {
+  LatencyHistogram latencies;
+  uint64_t replies = 0;  // Inside the measurement window
+  uint64_t errors = 0;
+};
+
+// Serializes the requests of one connection. The builders are reused, like in a real client.
+class RequestFactory {
+ public:
+  explicit RequestFactory(std::size_t batch) : batchSize_(batch), batch_({batch, std::chrono::microseconds(0)}) {}
+
+  std::span<const uint8_t> next() {
+    if (batchSize_ <= 1) {
+      createMonster(single_, "Orc");
+      return {single_.GetBufferPointer(), single_.GetSize()};
+    }
+    for (std::size_t i = 0; i < batchSize_; ++i) batch_.add("Orc");
+    return batch_.finish();
+  }
+
+ private:
+  std::size_t batchSize_;
+  flatbuffers::FlatBufferBuilder single_;
+  MonsterBatchBuilder batch_;
+};
+
+// One connection: keeps `inflight` requests outstanding until the deadline, then waits for the outstanding replies
+// and closes the connection gracefully.
+asio::awaitable<void> runClient(tcp::endpoint server, std::size_t batch, std::size_t inflight,
+                                Clock::time_point measureFrom, Clock::time_point deadline, ClientThreadState& state) {
+  try {
+    RequestFactory requests(batch);
+    tcp::socket socket(co_await asio::this_coro::executor);
+    co_await socket.async_connect(server, asio::use_awaitable);
+    socket.set_option(tcp::no_delay(true));
+
+    FrameReader reader;
+    FrameWriter writer;
+    std::vector<Clock::time_point> sendTimes(inflight);  // Replies come in request order
+    uint64_t sent = 0;
+    uint64_t received = 0;
+
+    for (; sent < inflight; ++sent) {
+      sendTimes[sent % inflight] = Clock::now();
+      const auto request = requests.next();
+      writer.append(asio::buffer(request.data(), request.size()));
+    }
+    co_await writer.flush(socket);
+
+    while (received < sent) {
+      if (!co_await reader.fill(socket)) break;
+
+      std::span<const uint8_t> reply;
+      while (reader.next(reply)) {
+        const auto now = Clock::now();
+        const auto sendTime = sendTimes[received % inflight];
+        if (now >= measureFrom && now < deadline) {
+          ++state.replies;
+          // Requests sent during the warm-up may have waited for the connection setup
+          if (sendTime >= measureFrom) state.latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - sendTime).count());
+        }
+        ++received;
+
+        if (now < deadline) {
+          sendTimes[sent % inflight] = now;
+          const auto request = requests.next();
+          writer.append(asio::buffer(request.data(), request.size()));
+          ++sent;
+        }
+      }
+      co_await writer.flush(socket);
+    }
+
+    std::error_code ignored;
+    socket.shutdown(tcp::socket::shutdown_both, ignored);
+  } catch (std::exception&) {
+    ++state.errors;
+  }
+}
+
+BenchResult measure(unsigned short port, std::size_t batch, std::size_t inflight, const BenchConfig& config) {
+  const tcp::endpoint server(asio::ip::address_v4::loopback(), port);
+  const auto measureFrom = Clock::now() + config.warmUp;  // Includes connection setup
+  const auto deadline = measureFrom + config.duration;
+
+  const std::size_t threadCount = std::max<std::size_t>(1, config.clientThreads);
+  std::vector<std::unique_ptr<asio::io_context>> contexts;
+  std::vector<ClientThreadState> states(threadCount);
+  for (std::size_t i = 0; i < threadCount; ++i) {
+    contexts.push_back(std::make_unique<asio::io_context>());
+  }
+  for (std::size_t i = 0; i < config.clients; ++i) {
+    asio::co_spawn(*contexts[i % threadCount], runClient(server, batch, inflight, measureFrom, deadline, states[i % threadCount]),
+                   asio::detached);
+  }
+
+  // Every io_context runs until all of its connections are closed
+  std::vector<std::thread> threads;
+  for (auto& context : contexts) {
+    threads.emplace_back([&context]() { context->run(); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  BenchResult result;
+  LatencyHistogram latencies;
+  uint64_t replies = 0;
+  for (auto& state : states) {
+    latencies.merge(state.latencies);
+    replies += state.replies;
+    result.errors += state.errors;
+  }
+  result.repliesPerSec = replies / std::chrono::duration<double>(config.duration).count();
+  result.monstersPerSec = result.repliesPerSec * batch;
+  result.p50us = latencies.percentile(50) / 1000.0;
+  result.p99us = latencies.percentile(99) / 1000.0;
+  result.p999us = latencies.percentile(99.9) / 1000.0;
+  return result;
+}
+
+BenchResult runOnce(const std::string& serverKind, std::size_t batch, std::size_t inflight, const BenchConfig& config) {
+  if (serverKind == "thread") {
+    ThreadPerConnectionServer server(0, config.verify);
+    server.runInBackground();
+    BenchResult result = measure(server.port(), batch, inflight, config);
+    server.stop();  // Waits until every session thread saw the end of its connection
+    result.serverThreads = config.clients;
+    return result;
+  }
+
+  const std::size_t serverThreads = config.serverThreads ? config.serverThreads : std::thread::hardware_concurrency();
+  AsyncMonsterServer server(0, serverThreads, {}, config.verify);
+  server.runInBackground();
+  BenchResult result = measure(server.port(), batch, inflight, config);
+  server.stop();
+  result.serverThreads = server.threadCount();
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "Monster request / reply benchmark: thread per connection vs coroutines");
+  // clang-format off
+  options.add_options()
+      ("s,servers", "Servers to compare: thread, async", cxxopts::value<std::vector<std::string>>()->default_value("thread,async"))
+      ("c,clients", "Concurrent connections", cxxopts::value<std::size_t>()->default_value("1000"))
+      ("i,inflight", "Requests in flight per connection, list", cxxopts::value<std::vector<std::size_t>>()->default_value("1,16"))
+      ("b,batch", "Monsters per request, list (1 - a single Monster frame)", cxxopts::value<std::vector<std::size_t>>()->default_value("1,16,256"))
+      ("verify", "Server side checks: verifier, trusted, asserts", cxxopts::value<std::string>()->default_value("verifier"))
+      ("t,threads", "Async server threads, 0 - hardware concurrency", cxxopts::value<std::size_t>()->default_value("0"))
+      ("client-threads", "Threads running the client connections", cxxopts::value<std::size_t>()->default_value("2"))
+      ("w,warm-up", "Warm-up in milliseconds, includes connection setup", cxxopts::value<std::size_t>()->default_value("1000"))
+      ("d,duration", "Measurement in milliseconds", cxxopts::value<std::size_t>()->default_value("3000"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  BenchConfig config;
+  config.clients = std::max<std::size_t>(1, args["clients"].as<std::size_t>());
+  config.clientThreads = args["client-threads"].as<std::size_t>();
+  config.serverThreads = args["threads"].as<std::size_t>();
+  config.verify.mode = verifyModeFromString(args["verify"].as<std::string>());
+  config.warmUp = std::chrono::milliseconds(args["warm-up"].as<std::size_t>());
+  config.duration = std::chrono::milliseconds(std::max<std::size_t>(1, args["duration"].as<std::size_t>()));
+
+  struct Row {
+    std::string server;
+    std::size_t batch;
+    std::size_t inflight;
+    BenchResult result;
+  };
+  std::vector<Row> results;
+  try {
+    for (auto& server : args["servers"].as<std::vector<std::string>>()) {
+      for (auto batch : args["batch"].as<std::vector<std::size_t>>()) {
+        for (auto inflight : args["inflight"].as<std::vector<std::size_t>>()) {
+          batch = std::max<std::size_t>(1, batch);
+          inflight = std::max<std::size_t>(1, inflight);
+          std::cout << "Running " << server << " server, " << config.clients << " clients x " << inflight << " in flight, batch "
+                    << batch << "..." << std::endl;
+          results.push_back({server, batch, inflight, runOnce(server, batch, inflight, config)});
+        }
+      }
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "\nclients=" << config.clients << " client threads=" << config.clientThreads << " cores=" << std::thread::hardware_concurrency()
+            << " verify=" << toString(config.verify.mode) << "\n\n";
+  std::cout << std::left << std::setw(9) << "server" << std::setw(10) << "threads" << std::setw(8) << "batch" << std::setw(10) << "inflight"
+            << std::setw(14) << "replies/s" << std::setw(14) << "monsters/s" << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(12) << "p99.9 us" << "errors" << std::endl;
+  for (auto& [server, batch, inflight, r] : results) {
+    std::cout << std::left << std::setw(9) << server << std::setw(10) << r.serverThreads << std::setw(8) << batch << std::setw(10) << inflight
+              << std::fixed << std::setprecision(0) << std::setw(14) << r.repliesPerSec << std::setw(14) << r.monstersPerSec << std::setprecision(1) << std::setw(10) << r.p50us
+              << std::setw(10) << r.p99us << std::setw(12) << r.p999us << r.errors << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <asio.hpp>
+#include <cstddef>
+#include <iostream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../../DebugLog.h"
+#include "../../sync_tcp/Serialization.h"
+#include "../NetworkMethodsAsync.h"
+
+// Same protocol as ThreadPerConnectionServer, served by coroutines on a fixed pool of threads.
+// Every connection is one coroutine with one reusable receive buffer: all requests which arrived with one read
+// are answered with one write, so clients may keep many requests in flight. A frame rejected by `verify` closes
+// its connection.
+class AsyncMonsterServer {
+ public:
+  AsyncMonsterServer(unsigned short port, std::size_t threadCount, FrameReader::Options framing = {}, VerifyOptions verify = {})
+      : acceptor_(io_context_, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)),
+        threadCount_(threadCount == 0 ? 1 : threadCount),
+        framing_(framing),
+        verify_(verify) {
+    asio::co_spawn(io_context_, listen(), asio::detached);
+  }
+
+  ~AsyncMonsterServer() { stop(); }
+
+  unsigned short port() const { return acceptor_.local_endpoint().port(); }
+
+  std::size_t threadCount() const { return threadCount_; }
+
+  // Runs the io_context in the calling thread and threadCount - 1 background threads.
+  // Blocks until the server is stopped.
+  void run() {
+    startThreads(threadCount_ - 1);
+    io_context_.run();
+    joinThreads();
+  }
+
+  // Runs the io_context in threadCount background threads and returns immediately. Used by benchmarks.
+  void runInBackground() { startThreads(threadCount_); }
+
+  // Must not be called from a server thread.
+  void stop() {
+    io_context_.stop();
+    joinThreads();
+  }
+
+ private:
+  asio::awaitable<void> listen() {
+    while (true) {
+      std::error_code ec;
+      asio::ip::tcp::socket socket = co_await acceptor_.async_accept(asio::redirect_error(asio::use_awaitable, ec));
+      if (ec == asio::error::operation_aborted) co_return;
+      if (ec) {
+        std::cerr << "Accept error: " << ec.message() << std::endl;
+        continue;
+      }
+      socket.set_option(asio::ip::tcp::no_delay(true));
+      asio::co_spawn(io_context_, session(std::move(socket)), asio::detached);
+    }
+  }
+
+  // Session with one client
+  asio::awaitable<void> session(asio::ip::tcp::socket socket) {
+    debugLog() << "New session with client. Client address: " << socket.remote_endpoint().address().to_string() << std::endl;
+
+    FrameReader reader(framing_);
+    FrameWriter writer;
+    std::string reply;
+    try {
+      while (co_await reader.fill(socket)) {
+        std::span<const uint8_t> monsterData;
+        while (reader.next(monsterData)) {
+          // Deserialize and verify the monsters in place, no copy of the payload. One confirmation per frame.
+          confirmRequest(monsterData, reply, verify_);
+          writer.append(asio::buffer(reply));
+        }
+        co_await writer.flush(socket);  // One write for all requests of this read
+      }
+    } catch (std::exception& e) {
+      std::cerr << "Session error: " << e.what() << std::endl;
+    }
+
+    debugLog() << "Session with client closed" << std::endl;
+  }
+
+  void startThreads(std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      threads_.emplace_back([this]() { io_context_.run(); });
+    }
+  }
+
+  void joinThreads() {
+    for (auto& thread : threads_) {
+      if (thread.joinable()) thread.join();
+    }
+    threads_.clear();
+  }
+
+  asio::io_context io_context_;
+  asio::ip::tcp::acceptor acceptor_;
+  std::size_t threadCount_;
+  FrameReader::Options framing_;
+  VerifyOptions verify_;
+  std::vector<std::thread> threads_;
+};
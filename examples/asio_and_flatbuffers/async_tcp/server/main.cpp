@@ -0,0 +1,21 @@
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "AsyncMonsterServer.h"
+
+// Usage: asio_async_tcp_and_fb_server_minimalProject [threads] [verify]
+//   threads - io_context threads (default: hardware concurrency)
+//   verify  - verifier (default), trusted or asserts, see VerifyOptions
+int main(int argc, char* argv[]) {
+  try {
+    const std::size_t threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    VerifyOptions verify;
+    if (argc > 2) verify.mode = verifyModeFromString(argv[2]);
+    AsyncMonsterServer server(12345, threads, {}, verify);
+    std::cout << "Async server started on port 12345 (" << server.threadCount() << " threads, verify: " << toString(verify.mode) << ")\n";
+    server.run();
+  } catch (std::exception& e) {
+    std::cerr << "Server error: " << e.what() << std::endl;
+  }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "flatbuffers/flatbuffer_builder.h"
+
+// Free list of reusable FlatBufferBuilders.
+// A builder is Clear()ed when it is acquired, but keeps its buffer (pre-sized to initialSize), so once the buffer has
+// grown to the message size a serialization doesn't allocate at all. Not thread safe: use one pool per thread,
+// threadLocal() returns the pool of the calling thread. A lease must be released on the thread which acquired it.
+// USAGE EXAMPLE:
+// auto builder = BuilderPool::threadLocal().acquire();
+// createMonster(*builder, line);
+// sendSizeAndData(socket, asio::buffer(builder->GetBufferPointer(), builder->GetSize()));
+// // The builder returns to the pool at the end of the scope
+class BuilderPool {
+ public:
+  // Owns the builder until it is destroyed, then returns it to the pool
+  class Lease {
+   public:
+    Lease(BuilderPool& pool, std::unique_ptr<flatbuffers::FlatBufferBuilder> builder) : pool_(&pool), builder_(std::move(builder)) {}
+
+    Lease(Lease&& other) noexcept = default;
+
+    Lease& operator=(Lease&& other) noexcept {
+      if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        builder_ = std::move(other.builder_);
+      }
+      return *this;
+    }
+
+    ~Lease() { release(); }
+
+    flatbuffers::FlatBufferBuilder& operator*() const { return *builder_; }
+
+    flatbuffers::FlatBufferBuilder* operator->() const { return builder_.get(); }
+
+   private:
+    void release() {
+      if (builder_) pool_->release(std::move(builder_));
+    }
+
+    BuilderPool* pool_;
+    std::unique_ptr<flatbuffers::FlatBufferBuilder> builder_;
+  };
+
+  static constexpr std::size_t defaultInitialSize = 1024;  // A Monster with a short name takes ~200 bytes
+
+  BuilderPool() : BuilderPool(defaultInitialSize) {}
+
+  // maxIdle: builders kept for reuse, the rest are freed on release
+  explicit BuilderPool(std::size_t initialSize, std::size_t maxIdle = 8) : initialSize_(initialSize), maxIdle_(maxIdle) {}
+
+  // Cleared builder. Allocates only if no idle builder is left.
+  Lease acquire() {
+    if (idle_.empty()) {
+      return Lease(*this, std::make_unique<flatbuffers::FlatBufferBuilder>(initialSize_));
+    }
+    std::unique_ptr<flatbuffers::FlatBufferBuilder> builder = std::move(idle_.back());
+    idle_.pop_back();
+    builder->Clear();  // Keeps the buffer
+    return Lease(*this, std::move(builder));
+  }
+
+  std::size_t idle() const { return idle_.size(); }
+
+  static BuilderPool& threadLocal() {
+    thread_local BuilderPool pool;
+    return pool;
+  }
+
+ private:
+  void release(std::unique_ptr<flatbuffers::FlatBufferBuilder> builder) {
+    if (idle_.size() < maxIdle_) idle_.push_back(std::move(builder));
+  }
+
+  std::size_t initialSize_;
+  std::size_t maxIdle_;
+  std::vector<std::unique_ptr<flatbuffers::FlatBufferBuilder>> idle_;
+};
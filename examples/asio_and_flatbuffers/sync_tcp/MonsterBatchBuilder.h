@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "Serialization.h"
+
+// Client side batching: collects monsters into one MonsterBatch frame (solder_batch.fbs), which the server confirms
+// with one reply. A batch is sent when it holds maxCount monsters or when its oldest monster waited `window`,
+// whichever comes first. The caller drives the window: add() reports a full batch, expired(now) an old one.
+// The builder and the offset list are reused, so a steady stream of batches doesn't allocate.
+// USAGE EXAMPLE:
+// MonsterBatchBuilder batch({.maxCount = 16, .window = std::chrono::milliseconds(5)});
+// if (batch.add(line) || batch.expired(MonsterBatchBuilder::Clock::now())) {
+//   auto frame = batch.finish();
+//   sendSizeAndData(socket, asio::buffer(frame.data(), frame.size()));
+// }
+class MonsterBatchBuilder {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    std::size_t maxCount = 16;
+    std::chrono::microseconds window{1000};
+  };
+
+  MonsterBatchBuilder() : MonsterBatchBuilder(Options{}) {}
+
+  explicit MonsterBatchBuilder(Options options) : options_(options), builder_(1024) {
+    if (options_.maxCount == 0) options_.maxCount = 1;
+    monsters_.reserve(options_.maxCount);
+  }
+
+  // Serializes the monster into the pending batch. Returns true if the batch is full.
+  bool add(std::string_view monsterName, Clock::time_point now = Clock::now()) {
+    if (finished_) {
+      builder_.Clear();  // Keeps the buffer
+      finished_ = false;
+    }
+    if (monsters_.empty()) oldest_ = now;
+    monsters_.push_back(serializeMonster(builder_, monsterName));
+    return monsters_.size() >= options_.maxCount;
+  }
+
+  std::size_t size() const { return monsters_.size(); }
+
+  bool empty() const { return monsters_.empty(); }
+
+  // Time when the pending batch must be sent. Only meaningful if the batch is not empty.
+  Clock::time_point deadline() const { return oldest_ + options_.window; }
+
+  bool expired(Clock::time_point now) const { return !empty() && now >= deadline(); }
+
+  // Finishes the pending batch and starts a new one. The frame is valid until the next add().
+  std::span<const uint8_t> finish() {
+    auto monsters = builder_.CreateVector(monsters_.data(), monsters_.size());
+    builder_.Finish(MyGame::Sample::CreateMonsterBatch(builder_, monsters), MyGame::Sample::MonsterBatchIdentifier());
+    monsters_.clear();
+    finished_ = true;
+    return {builder_.GetBufferPointer(), builder_.GetSize()};
+  }
+
+  const Options& options() const { return options_; }
+
+ private:
+  Options options_;
+  flatbuffers::FlatBufferBuilder builder_;
+  std::vector<flatbuffers::Offset<MyGame::Sample::Monster>> monsters_;
+  Clock::time_point oldest_;
+  bool finished_ = false;
+};
@@ -1,12 +1,24 @@
 #include "Serialization.h"
 
 #include <iostream>
+#include <stdexcept>
 
-flatbuffers::FlatBufferBuilder createMonster(const std::string& monsterName) {
-  using namespace MyGame::Sample;
+#include "../../DebugLog.h"
 
+flatbuffers::FlatBufferBuilder createMonster(const std::string& monsterName) {
   // Build up a serialized buffer algorithmically:
   flatbuffers::FlatBufferBuilder builder;
+  createMonster(builder, monsterName);
+  return builder;
+}
+
+void createMonster(flatbuffers::FlatBufferBuilder& builder, std::string_view monsterName) {
+  builder.Clear();  // Keeps the buffer of a reused builder
+  builder.Finish(serializeMonster(builder, monsterName));  // Serialize the root of the object.
+}
+
+flatbuffers::Offset<MyGame::Sample::Monster> serializeMonster(flatbuffers::FlatBufferBuilder& builder, std::string_view monsterName) {
+  using namespace MyGame::Sample;
 
   // First, lets serialize some weapons for the Monster: A 'sword' and an 'axe'.
   auto weapon_one_name = builder.CreateString("Sword");
@@ -19,35 +31,30 @@ flatbuffers::FlatBufferBuilder createMonster(const std::string& monsterName) {
   auto sword = CreateWeapon(builder, weapon_one_name, weapon_one_damage);
   auto axe = CreateWeapon(builder, weapon_two_name, weapon_two_damage);
 
-  // Create a FlatBuffer's `vector` from the `std::vector`.
-  std::vector<flatbuffers::Offset<Weapon>> weapons_vector;
-  weapons_vector.push_back(sword);
-  weapons_vector.push_back(axe);
-  auto weapons = builder.CreateVector(weapons_vector);
+  // Create a FlatBuffer's `vector` from a plain array, no temporary std::vector.
+  flatbuffers::Offset<Weapon> weapons_array[] = {sword, axe};
+  auto weapons = builder.CreateVector(weapons_array, 2);
 
   // Second, serialize the rest of the objects needed by the Monster.
   auto position = Vec3(1.0f, 2.0f, 3.0f);
 
-  auto name = builder.CreateString(monsterName);
+  auto name = builder.CreateString(monsterName.data(), monsterName.size());
 
   unsigned char inv_data[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
   auto inventory = builder.CreateVector(inv_data, 10);
 
   // Shortcut for creating monster with all fields set:
-  auto orc = CreateMonster(builder,
-                           &position,         // pos
-                           150,               // mana
-                           80,                // hp
-                           name,              // name
-                           inventory,         // inventory
-                           Color_Red,         // color
-                           weapons,           // weapons
-                           Equipment_Weapon,  // equipped_type
-                           axe.Union()        // path
+  return CreateMonster(builder,
+                       &position,         // pos
+                       150,               // mana
+                       80,                // hp
+                       name,              // name
+                       inventory,         // inventory
+                       Color_Red,         // color
+                       weapons,           // weapons
+                       Equipment_Weapon,  // equipped_type
+                       axe.Union()        // path
   );
-
-  builder.Finish(orc);  // Serialize the root of the object.
-  return builder;
 }
 
 void verifyMonster(const MyGame::Sample::Monster* monster) {
@@ -90,5 +97,70 @@ void verifyMonster(const MyGame::Sample::Monster* monster) {
   assert(equipped->damage() == 5);
   (void)equipped;
 
-  std::cout << "The FlatBuffer was successfully created and verified" << std::endl;
+  debugLog() << "The FlatBuffer was successfully created and verified" << std::endl;
+}
+
+namespace {
+
+// The identifier sits right after the root offset, a shorter frame can't be a batch
+bool isBatch(std::span<const uint8_t> frame) {
+  return frame.size() >= sizeof(flatbuffers::uoffset_t) + flatbuffers::kFileIdentifierLength &&
+         MyGame::Sample::MonsterBatchBufferHasIdentifier(frame.data());
+}
+
+}  // namespace
+
+VerifyOptions::Mode verifyModeFromString(std::string_view mode) {
+  if (mode == "verifier") return VerifyOptions::Mode::Verifier;
+  if (mode == "trusted") return VerifyOptions::Mode::Trusted;
+  if (mode == "asserts") return VerifyOptions::Mode::Asserts;
+  throw std::invalid_argument("Unknown verify mode: " + std::string(mode));
+}
+
+const char* toString(VerifyOptions::Mode mode) {
+  switch (mode) {
+    case VerifyOptions::Mode::Verifier:
+      return "verifier";
+    case VerifyOptions::Mode::Trusted:
+      return "trusted";
+    case VerifyOptions::Mode::Asserts:
+      return "asserts";
+  }
+  return "unknown";
+}
+
+bool verifyRequest(std::span<const uint8_t> frame, const VerifyOptions& options) {
+  flatbuffers::Verifier::Options verifierOptions;
+  verifierOptions.max_depth = options.maxDepth;
+  verifierOptions.max_tables = options.maxTables;
+  flatbuffers::Verifier verifier(frame.data(), frame.size(), verifierOptions);
+  return isBatch(frame) ? MyGame::Sample::VerifyMonsterBatchBuffer(verifier) : MyGame::Sample::VerifyMonsterBuffer(verifier);
+}
+
+std::size_t confirmRequest(std::span<const uint8_t> frame, std::string& reply, const VerifyOptions& options) {
+  using namespace MyGame::Sample;
+
+  // One Verifier pass covers the whole frame, every monster of a batch included
+  if (options.mode == VerifyOptions::Mode::Verifier && !verifyRequest(frame, options)) {
+    throw std::runtime_error("Malformed request frame of " + std::to_string(frame.size()) + " bytes");
+  }
+  const bool checkValues = options.mode == VerifyOptions::Mode::Asserts;
+
+  if (isBatch(frame)) {
+    // One confirmation for the whole batch
+    auto batch = GetMonsterBatch(frame.data());
+    const auto* monsters = batch->monsters();
+    const std::size_t count = monsters ? monsters->size() : 0;
+    for (std::size_t i = 0; checkValues && i < count; ++i) {
+      verifyMonster(monsters->Get(static_cast<flatbuffers::uoffset_t>(i)));  // asserts if monster is invalid
+    }
+    reply.assign("Batch of ").append(std::to_string(count)).append(" monsters verified!");
+    return count;
+  }
+
+  auto monster = GetMonster(frame.data());
+  if (checkValues) verifyMonster(monster);  // asserts if monster is invalid
+  const auto* name = monster->name();       // Optional in the schema
+  reply.assign("Monster ").append(name ? name->string_view() : std::string_view()).append(" verified!");
+  return 1;
 }
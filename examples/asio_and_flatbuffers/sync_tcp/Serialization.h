@@ -1,11 +1,50 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
 
 #include "flatbuffers/flatbuffer_builder.h"
+#include "solder_batch_generated.h"
 #include "solder_generated.h"  // Already includes "flatbuffers/flatbuffers.h"."
 
 // Create flatbuffer with monster data
 flatbuffers::FlatBufferBuilder createMonster(const std::string& monsterName);
 
+// Same as above, but serializes into an existing builder (Clear()ed first), so a reused builder
+// (see BuilderPool.h) doesn't allocate. The result stays in the builder until it is cleared.
+void createMonster(flatbuffers::FlatBufferBuilder& builder, std::string_view monsterName);
+
+// Serializes one monster into the builder without finishing the buffer. Used to put many monsters into one
+// MonsterBatch (see MonsterBatchBuilder.h).
+flatbuffers::Offset<MyGame::Sample::Monster> serializeMonster(flatbuffers::FlatBufferBuilder& builder, std::string_view monsterName);
+
 // Verify that the monster data is valid. Same as in CreadMonster method
-void verifyMonster(const MyGame::Sample::Monster* monster);
\ No newline at end of file
+void verifyMonster(const MyGame::Sample::Monster* monster);
+
+// How the server checks a request frame before reading it.
+struct VerifyOptions {
+  enum class Mode {
+    Verifier,  // flatbuffers::Verifier once per frame: offsets, bounds, depth and table count. For untrusted peers.
+    Trusted,   // No checks at all: the peer is trusted to send valid buffers, a malformed one is undefined behavior.
+    Asserts,   // verifyMonster for every monster: test values checked by assert, no structural validation.
+  };
+
+  Mode mode = Mode::Verifier;
+  flatbuffers::uoffset_t maxDepth = 64;         // Nesting of tables and vectors. The Monster schema needs 4.
+  flatbuffers::uoffset_t maxTables = 1000000;  // Tables per frame. A MonsterBatch of N monsters has about 3 * N.
+};
+
+// "verifier", "trusted" or "asserts". Throws std::invalid_argument for anything else.
+VerifyOptions::Mode verifyModeFromString(std::string_view mode);
+
+const char* toString(VerifyOptions::Mode mode);
+
+// Runs flatbuffers::Verifier over a Monster or a MonsterBatch frame with the limits from `options`.
+bool verifyRequest(std::span<const uint8_t> frame, const VerifyOptions& options = {});
+
+// Checks one request frame, a Monster or a MonsterBatch (identifier "MBAT"), as `options` says and writes the
+// confirmation into `reply`: one reply per frame, so a batch is confirmed once. Returns the number of monsters in the
+// frame. Throws std::runtime_error if the Verifier rejects the frame, the caller should close the connection.
+std::size_t confirmRequest(std::span<const uint8_t> frame, std::string& reply, const VerifyOptions& options = {});
\ No newline at end of file
@@ -0,0 +1,111 @@
+// Monster serialization: a new FlatBufferBuilder per message vs reused builders.
+//
+// - value:  createMonster(name) returns a fresh builder by value (the original path of the client).
+// - reuse:  createMonster(builder, name) into one builder owned by the loop.
+// - pool:   BuilderPool::threadLocal().acquire() per message, the builder goes back to the pool after the send.
+//
+// Every mode serializes `messages` Monsters and touches the result (the "send"). Reported: messages per second,
+// ns per message and heap allocations per message.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../../../AllocationCounter.h"
+#include "../BuilderPool.h"
+#include "../Serialization.h"
+#include "cxxopts.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  double messagesPerSec = 0;
+  double nsPerMessage = 0;
+  double allocationsPerMessage = 0;
+  std::size_t messageSize = 0;
+  uint64_t checksum = 0;
+};
+
+// Stands in for sendSizeAndData: reads the serialized bytes so nothing is optimized away
+uint64_t consume(const flatbuffers::FlatBufferBuilder& builder) {
+  return builder.GetSize() + builder.GetBufferPointer()[builder.GetSize() / 2];
+}
+
+template <typename SerializeOne>
+Result run(const std::vector<std::string>& names, std::size_t messages, SerializeOne serializeOne) {
+  Result result;
+  for (std::size_t i = 0; i < names.size(); ++i) serializeOne(names[i]);  // Warm-up: builders reach their final size
+
+  const uint64_t allocations0 = globalAllocations.load();
+  const auto start = Clock::now();
+  for (std::size_t i = 0; i < messages; ++i) {
+    result.checksum += serializeOne(names[i % names.size()]);
+  }
+  const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  result.allocationsPerMessage = static_cast<double>(globalAllocations.load() - allocations0) / messages;
+  result.messagesPerSec = messages / seconds;
+  result.nsPerMessage = seconds * 1e9 / messages;
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "Monster serialization: new builder per message vs reused builders");
+  // clang-format off
+  options.add_options()
+      ("n,messages", "Messages per mode", cxxopts::value<std::size_t>()->default_value("2000000"))
+      ("l,name-length", "Monster name length", cxxopts::value<std::size_t>()->default_value("16"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  const std::size_t messages = std::max<std::size_t>(1, args["messages"].as<std::size_t>());
+  const std::size_t nameLength = args["name-length"].as<std::size_t>();
+
+  // A few different names, like lines typed into the client
+  std::vector<std::string> names;
+  for (char c = 'a'; c < 'a' + 16; ++c) names.emplace_back(nameLength, c);
+
+  struct Row {
+    std::string mode;
+    Result result;
+  };
+  std::vector<Row> rows;
+
+  rows.push_back({"value", run(names, messages, [](const std::string& name) {
+                    flatbuffers::FlatBufferBuilder builder = createMonster(name);
+                    return consume(builder);
+                  })});
+
+  flatbuffers::FlatBufferBuilder reused(BuilderPool::defaultInitialSize);
+  rows.push_back({"reuse", run(names, messages, [&reused](const std::string& name) {
+                    createMonster(reused, name);
+                    return consume(reused);
+                  })});
+
+  rows.push_back({"pool", run(names, messages, [](const std::string& name) {
+                    auto builder = BuilderPool::threadLocal().acquire();
+                    createMonster(*builder, name);
+                    return consume(*builder);
+                  })});
+
+  createMonster(reused, names.front());
+  std::cout << "messages=" << messages << " name length=" << nameLength << " message size=" << reused.GetSize() << " bytes\n\n";
+  std::cout << std::left << std::setw(8) << "mode" << std::setw(14) << "messages/s" << std::setw(10) << "ns/msg" << std::setw(12) << "allocs/msg"
+            << "checksum" << std::endl;
+  for (auto& [mode, r] : rows) {
+    std::cout << std::left << std::setw(8) << mode << std::fixed << std::setprecision(0) << std::setw(14) << r.messagesPerSec
+              << std::setprecision(1) << std::setw(10) << r.nsPerMessage << std::setprecision(2) << std::setw(12) << r.allocationsPerMessage
+              << r.checksum << std::endl;
+  }
+  return 0;
+}
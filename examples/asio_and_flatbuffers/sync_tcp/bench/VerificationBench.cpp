@@ -0,0 +1,138 @@
+// Cost of checking a request frame on the server: confirmRequest with every VerifyOptions mode.
+//
+// - trusted:  no checks, only the reads needed for the reply. The baseline.
+// - verifier: one flatbuffers::Verifier pass over the frame (offsets, bounds, depth, table count).
+// - asserts:  verifyMonster for every monster, the value checks of the original example (compiled out with NDEBUG).
+//
+// For every batch size one frame is serialized (a Monster for batch 1, a MonsterBatch otherwise), copied into a
+// receive buffer like the one of the servers, and confirmed until `megabytes` of frames went through.
+// Reported: frames per second, MB/s, ns per monster and µs per MB, plus the µs per MB above the trusted mode,
+// i.e. what the checks cost.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../MonsterBatchBuilder.h"
+#include "../Serialization.h"
+#include "cxxopts.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  double framesPerSec = 0;
+  double megabytesPerSec = 0;
+  double nsPerMonster = 0;
+  double usPerMegabyte = 0;
+  uint64_t checksum = 0;
+};
+
+// One request frame as the servers see it: a copy in a receive buffer
+std::vector<uint8_t> makeFrame(std::size_t batch, const std::string& name) {
+  if (batch <= 1) {
+    flatbuffers::FlatBufferBuilder builder;
+    createMonster(builder, name);
+    return {builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize()};
+  }
+  MonsterBatchBuilder batchBuilder({batch, std::chrono::microseconds(0)});
+  for (std::size_t i = 0; i < batch; ++i) batchBuilder.add(name);
+  auto frame = batchBuilder.finish();
+  return {frame.begin(), frame.end()};
+}
+
+Result run(std::span<const uint8_t> frame, std::size_t monstersPerFrame, std::size_t megabytes, const VerifyOptions& verify) {
+  Result result;
+  std::string reply;
+  const std::size_t frames = std::max<std::size_t>(1, megabytes * 1024 * 1024 / frame.size());
+  for (std::size_t i = 0; i < std::min<std::size_t>(frames, 1000); ++i) confirmRequest(frame, reply, verify);  // Warm-up
+
+  const auto start = Clock::now();
+  for (std::size_t i = 0; i < frames; ++i) {
+    result.checksum += confirmRequest(frame, reply, verify) + reply.size();
+  }
+  const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  const double totalMegabytes = static_cast<double>(frames) * frame.size() / (1024 * 1024);
+  result.framesPerSec = frames / seconds;
+  result.megabytesPerSec = totalMegabytes / seconds;
+  result.nsPerMonster = seconds * 1e9 / (static_cast<double>(frames) * monstersPerFrame);
+  result.usPerMegabyte = seconds * 1e6 / totalMegabytes;
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "Cost of request verification: trusted vs flatbuffers::Verifier vs asserts");
+  // clang-format off
+  options.add_options()
+      ("b,batch", "Monsters per frame, list (1 - a single Monster frame)", cxxopts::value<std::vector<std::size_t>>()->default_value("1,16,256"))
+      ("m,modes", "Modes to compare: trusted, verifier, asserts", cxxopts::value<std::vector<std::string>>()->default_value("trusted,verifier,asserts"))
+      ("s,megabytes", "Megabytes of frames per mode", cxxopts::value<std::size_t>()->default_value("256"))
+      ("l,name-length", "Monster name length", cxxopts::value<std::size_t>()->default_value("16"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  const std::size_t megabytes = std::max<std::size_t>(1, args["megabytes"].as<std::size_t>());
+  const std::string name(args["name-length"].as<std::size_t>(), 'm');
+
+  struct Row {
+    std::size_t batch;
+    std::size_t frameSize;
+    VerifyOptions::Mode mode;
+    Result result;
+  };
+  std::vector<Row> rows;
+  std::map<std::size_t, double> trustedUsPerMegabyte;  // By batch
+  try {
+    for (auto batch : args["batch"].as<std::vector<std::size_t>>()) {
+      batch = std::max<std::size_t>(1, batch);
+      const std::vector<uint8_t> frame = makeFrame(batch, name);
+      if (!verifyRequest(frame)) {
+        std::cerr << "The Verifier rejected a valid frame, batch " << batch << std::endl;
+        return 1;
+      }
+      for (auto& modeName : args["modes"].as<std::vector<std::string>>()) {
+        VerifyOptions verify;
+        verify.mode = verifyModeFromString(modeName);
+        Result result = run(frame, batch, megabytes, verify);
+        if (verify.mode == VerifyOptions::Mode::Trusted) trustedUsPerMegabyte[batch] = result.usPerMegabyte;
+        rows.push_back({batch, frame.size(), verify.mode, result});
+      }
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  // A truncated frame must not get through the Verifier
+  const std::vector<uint8_t> frame = makeFrame(16, name);
+  const bool truncatedRejected = !verifyRequest(std::span(frame).first(frame.size() / 2));
+
+  std::cout << "megabytes per mode=" << megabytes << " name length=" << name.size() << " truncated frame rejected=" << (truncatedRejected ? "yes" : "NO") << "\n\n";
+  std::cout << std::left << std::setw(8) << "batch" << std::setw(12) << "frame B" << std::setw(10) << "mode" << std::setw(14) << "frames/s"
+            << std::setw(10) << "MB/s" << std::setw(12) << "ns/monster" << std::setw(10) << "us/MB" << std::setw(16) << "+us/MB checks"
+            << "checksum" << std::endl;
+  for (auto& [batch, frameSize, mode, r] : rows) {
+    std::cout << std::left << std::setw(8) << batch << std::setw(12) << frameSize << std::setw(10) << toString(mode) << std::fixed
+              << std::setprecision(0) << std::setw(14) << r.framesPerSec << std::setw(10) << r.megabytesPerSec << std::setprecision(1)
+              << std::setw(12) << r.nsPerMonster << std::setw(10) << r.usPerMegabyte << std::setw(16);
+    if (trustedUsPerMegabyte.count(batch)) {
+      std::cout << r.usPerMegabyte - trustedUsPerMegabyte[batch];
+    } else {
+      std::cout << "-";
+    }
+    std::cout << r.checksum << std::endl;
+  }
+  return 0;
+}
@@ -1,39 +1,97 @@
 #include <asio.hpp>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 
+#include "../BuilderPool.h"
+#include "../MonsterBatchBuilder.h"
 #include "../NetworkMethods.h"
 #include "../Serialization.h"
 
 using asio::ip::tcp;
 
-int main() {
+// Sends the lines as MonsterBatch frames: when `maxCount` lines are collected or the oldest one waited `window`.
+void sendBatched(tcp::socket& socket, MonsterBatchBuilder::Options options) {
+  MonsterBatchBuilder batch(options);
+  std::mutex mutex;
+  std::condition_variable wakeUp;
+  bool done = false;
+
+  auto send = [&socket, &batch]() {
+    auto frame = batch.finish();
+    sendSizeAndData(socket, asio::buffer(frame.data(), frame.size()));
+  };
+
+  // Sends a batch whose window expired while no new line arrived
+  std::thread flusher([&]() {
+    std::unique_lock lock(mutex);
+    while (!done) {
+      if (batch.empty()) {
+        wakeUp.wait(lock);
+      } else if (batch.expired(MonsterBatchBuilder::Clock::now())) {
+        send();
+      } else {
+        wakeUp.wait_until(lock, batch.deadline());
+      }
+    }
+  });
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    std::lock_guard lock(mutex);
+    if (batch.add(line)) send();  // Full
+    wakeUp.notify_one();          // The first line of a batch starts its window
+  }
+
+  {
+    std::lock_guard lock(mutex);
+    if (!batch.empty()) send();
+    done = true;
+  }
+  wakeUp.notify_one();
+  flusher.join();
+}
+
+// Usage: asio_sync_tcp_and_fb_client_minimalProject [batch] [windowMs]
+//   batch    - monsters per frame (default 1: one Monster per frame, no batching)
+//   windowMs - the longest time a line waits for its batch to fill (default 100)
+int main(int argc, char* argv[]) {
   try {
+    const std::size_t batchSize = argc > 1 ? std::stoul(argv[1]) : 1;
+    const auto window = std::chrono::milliseconds(argc > 2 ? std::stoul(argv[2]) : 100);
+
     asio::io_context io_context;
-    tcp::socket socket(io_context);
+    auto socket = std::make_shared<tcp::socket>(io_context);
     tcp::resolver resolver(io_context);
-    asio::connect(socket, resolver.resolve("127.0.0.1", "12345"));
+    asio::connect(*socket, resolver.resolve("127.0.0.1", "12345"));
 
     std::cout << "Connected to server. Enter monster name: " << std::endl;
 
-    std::thread reader([&socket]() {
+    std::thread reader([socket]() {
       try {
-        char reply[1024];
         while (true) {
-          std::error_code ec;
-          size_t length = socket.read_some(asio::buffer(reply), ec);
-          if (ec)
+          std::vector<uint8_t> reply = readSizeAndData(socket);  // Replies are size prefixed too
+          if (reply.empty())
             break;
-          std::cout << "Server: " << std::string(reply, length) << std::endl;
+          std::cout << "Server: " << std::string(reply.begin(), reply.end()) << std::endl;
         }
       } catch (...) {
       }
     });
 
-    std::string line;
-    while (std::getline(std::cin, line)) {
-      flatbuffers::FlatBufferBuilder builder = createMonster(line);
-      sendSizeAndData(socket, asio::buffer(builder.GetBufferPointer(), builder.GetSize()));
+    if (batchSize > 1) {
+      sendBatched(*socket, {batchSize, window});
+    } else {
+      std::string line;
+      while (std::getline(std::cin, line)) {
+        auto builder = BuilderPool::threadLocal().acquire();  // Reused for every line
+        createMonster(*builder, line);
+        sendSizeAndData(*socket, asio::buffer(builder->GetBufferPointer(), builder->GetSize()));
+      }
     }
 
     reader.join();
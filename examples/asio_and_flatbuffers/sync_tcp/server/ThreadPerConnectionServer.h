@@ -0,0 +1,103 @@
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "../../../DebugLog.h"
+#include "../NetworkMethods.h"
+#include "../Serialization.h"
+
+// Blocking server: one detached std::thread per connection, blocking reads and writes.
+// Every request is a Monster or a MonsterBatch, every request gets one text reply (see confirmRequest),
+// both sent with sendSizeAndData. A frame rejected by `verify` closes its connection.
+class ThreadPerConnectionServer {
+ public:
+  explicit ThreadPerConnectionServer(unsigned short port, VerifyOptions verify = {})
+      : acceptor_(io_context_, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)), verify_(verify) {}
+
+  ~ThreadPerConnectionServer() { stop(); }
+
+  unsigned short port() const { return acceptor_.local_endpoint().port(); }
+
+  // Thread safe. Sessions which haven't finished yet.
+  std::size_t sessionCount() const { return sessions_.load(); }
+
+  // Accepts connections in the calling thread until stop().
+  void run() {
+    while (!stopping_) {
+      auto sock = std::make_shared<asio::ip::tcp::socket>(io_context_);
+      std::error_code ec;
+      acceptor_.accept(*sock, ec);
+      if (stopping_) break;
+      if (ec) {
+        std::cerr << "Accept error: " << ec.message() << std::endl;
+        continue;
+      }
+      sock->set_option(asio::ip::tcp::no_delay(true));
+      ++sessions_;
+      std::thread([this, sock]() {
+        session(sock, verify_);
+        --sessions_;
+      }).detach();
+    }
+  }
+
+  // Accepts connections in a background thread and returns immediately. Used by benchmarks.
+  void runInBackground() {
+    acceptThread_ = std::thread([this]() { run(); });
+  }
+
+  // Stops accepting and waits until every session is closed by its client.
+  void stop() {
+    if (stopping_.exchange(true)) return;
+    if (acceptThread_.joinable()) {
+      // Wake the blocking accept() up
+      std::error_code ec;
+      asio::ip::tcp::socket wakeUp(io_context_);
+      wakeUp.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), port()), ec);
+      acceptThread_.join();
+    }
+    while (sessions_ > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+ private:
+  // Session with one client
+  static void session(std::shared_ptr<asio::ip::tcp::socket> clientSocketPrt, const VerifyOptions& verify) {
+    debugLog() << "New session with client. "
+               << "Client address: " << clientSocketPrt->remote_endpoint().address().to_string()
+               << std::endl;
+
+    try {
+      while (true) {
+        // Read monster data from the client: one Monster or a MonsterBatch
+        std::vector<uint8_t> monsterData = readSizeAndData(clientSocketPrt);
+        if (monsterData.empty())
+          break;
+
+        // Deserialize and verify the monsters, send one confirmation to the client
+        std::string reply;
+        confirmRequest(monsterData, reply, verify);
+        sendSizeAndData(*clientSocketPrt, asio::buffer(reply));
+      }
+    } catch (std::exception& e) {
+      std::cerr << "Session error: " << e.what() << std::endl;
+    }
+
+    debugLog() << "Session with client closed" << std::endl;
+  }
+
+  asio::io_context io_context_;
+  asio::ip::tcp::acceptor acceptor_;
+  VerifyOptions verify_;
+  std::atomic<bool> stopping_{false};
+  std::atomic<std::size_t> sessions_{0};
+  std::thread acceptThread_;
+};
@@ -6,6 +6,7 @@
 
 #define DEBUG_LOG_DISABLE_DEBUG_LEVEL
 #include "../../../DebugLog.h"
+#include "../../../asio/common/FrameDecoder.h"
 
 using asio::ip::tcp;
 
@@ -58,11 +59,15 @@ class ChatClient {
   }
 
   void do_read() {
-    socket_.async_read_some(asio::buffer(read_msg_),
+    socket_.async_read_some(decoder_.prepare(),
                             [this](std::error_code ec, std::size_t length) {
                               if (!ec) {
-                                // Print received message to console
-                                std::cout << "\nReceived: " << std::string(read_msg_, length) << "\n> " << std::flush;
+                                decoder_.commit(length);
+                                // Print every complete message to console. A partial message waits for the next read.
+                                FrameDecoder::Frame frame;
+                                while (decoder_.next(frame) == FrameDecoder::Status::Frame) {
+                                  std::cout << "\nReceived: " << frame.payload << "\n> " << std::flush;
+                                }
                                 do_read();  // Wait for more data
                               } else {
                                 std::cout << "Disconnected from server." << std::endl;
@@ -92,7 +97,7 @@ class ChatClient {
 
   asio::io_context& io_context_;
   asio::ssl::stream<tcp::socket> socket_;
-  char read_msg_[1024];
+  FrameDecoder decoder_;  // Newline-delimited messages
 };
 
 int main(int argc, char* argv[]) {
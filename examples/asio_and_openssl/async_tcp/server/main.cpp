@@ -2,11 +2,15 @@
 #include <asio/ssl.hpp>
 #include <iostream>
 #include <memory>
-#include <set>
 #include <string>
 
 #define DEBUG_LOG_DISABLE_DEBUG_LEVEL
 #include "../../../DebugLog.h"
+#include "../../../asio/common/FrameDecoder.h"
+#include "../../../asio/common/HandlerAllocator.h"
+#include "../../../asio/common/OutboundQueue.h"
+#include "../../../asio/common/SharedMessage.h"
+#include "../../../asio/common/SlotMap.h"
 
 using asio::ip::tcp;
 
@@ -17,17 +21,24 @@ class ClientSession;
 // This application has only one room.
 class ChatRoom {
  public:
-  void join(std::shared_ptr<ClientSession> session) {
-    sessions_.insert(session);
+  using Handle = SlotMap<std::shared_ptr<ClientSession>>::Handle;
+
+  // O(1). The session keeps the handle and passes it to leave().
+  Handle join(std::shared_ptr<ClientSession> session) {
+    Handle handle = sessions_.insert(std::move(session));
     std::cout << "Client joined. Total clients: " << sessions_.size() << std::endl;
+    return handle;
   }
 
-  void leave(std::shared_ptr<ClientSession> session) {
-    sessions_.erase(session);
+  // O(1). A stale handle (session already left) is ignored.
+  void leave(Handle handle) {
+    if (!sessions_.erase(handle)) return;
     std::cout << "Client left. Total clients: " << sessions_.size() << std::endl;
   }
 
-  void deliver(const std::string& msg) {
+  // The message is shared by all sessions: no per-session copies or allocations.
+  // Sessions are stored contiguously, so the broadcast is a linear scan.
+  void deliver(const SharedMessage& msg) {
     for (auto& session : sessions_) {
       deliverMessage(session, msg);
     }
@@ -35,65 +46,120 @@ class ChatRoom {
 
  private:
   // Using a helper to trigger the write on the session
-  void deliverMessage(std::shared_ptr<ClientSession> session, const std::string& msg);
+  void deliverMessage(const std::shared_ptr<ClientSession>& session, const SharedMessage& msg);
 
-  std::set<std::shared_ptr<ClientSession>> sessions_;
+  SlotMap<std::shared_ptr<ClientSession>> sessions_;
 };
 
 // Represents a single client connection
 class ClientSession : public std::enable_shared_from_this<ClientSession> {
  public:
-  ClientSession(tcp::socket socket, asio::ssl::context& context, ChatRoom& room)
-      : socket_(std::move(socket), context), room_(room) {}
+  ClientSession(tcp::socket socket, asio::ssl::context& context, ChatRoom& room, OutboundQueue::Limits outboundLimits,
+                FrameDecoder::Options framing)
+      : socket_(std::move(socket), context), room_(room), decoder_(framing), outbox_(outboundLimits) {}
 
   void start() {
     auto self(shared_from_this());
     socket_.async_handshake(asio::ssl::stream_base::server,
                             [this, self](std::error_code ec) {
                               if (!ec) {
-                                room_.join(shared_from_this());
+                                roomHandle_ = room_.join(shared_from_this());
                                 doRead();
                               }
                             });
   }
 
-  void deliver(const std::string& msg) {
+  void deliver(const SharedMessage& msg) {
+    if (closed_) return;
+
+    switch (outbox_.push(msg)) {
+      case OutboundQueue::PushResult::Queued:
+        if (!outbox_.writing()) doWrite();  // Otherwise the message is coalesced into the next write
+        break;
+      case OutboundQueue::PushResult::Dropped:
+        debugLog() << "Slow consumer: message dropped" << std::endl;
+        break;
+      case OutboundQueue::PushResult::Overflow:
+        std::cout << "Slow consumer: disconnecting, " << outbox_.stats().queuedBytes << " bytes queued" << std::endl;
+        close();  // The read loop fails and the session leaves the room
+        break;
+    }
+  }
+
+  // Queue depth, bytes in flight, coalescing and drop counters of this session
+  const OutboundQueue::Stats& outboundStats() const { return outbox_.stats(); }
+
+ private:
+  void doWrite() {
     auto self(shared_from_this());
-    auto msgCopy = std::make_shared<std::string>(msg);
 
-    asio::async_write(socket_, asio::buffer(*msgCopy),
-                      [self, msgCopy]  // Extent lifetime for self and asio::buffer
-                      (std::error_code ec, std::size_t /*length*/) {
-                        // If error occurs, the session will eventually be dropped by the read loop
-                      });
+    // SSL stream encrypts one buffer per record, so the queued messages are copied into one contiguous buffer
+    // instead of a gather sequence: one record and one syscall for the whole batch.
+    asio::async_write(socket_, outbox_.linearize(),
+                      withHandlerAllocator(
+                          [this, self]  // Extent lifetime for self. The queue keeps the buffer alive.
+                          (std::error_code ec, std::size_t /*length*/) {
+                            outbox_.completeWrite();
+                            // If error occurs, the session will eventually be dropped by the read loop
+                            if (!ec && outbox_.hasPending()) doWrite();
+                          }));
+  }
+
+  void close() {
+    closed_ = true;
+    std::error_code ignored;
+    socket_.lowest_layer().close(ignored);
   }
 
- private:
   void doRead() {
     auto self(shared_from_this());
-    socket_.async_read_some(asio::buffer(data_, max_length),
-                            [this, self]  // Extent lifetime for self
-                            (std::error_code ec, std::size_t length) {
-                              if (!ec) {
-                                std::string msg(data_, length);
-                                std::cout << "Broadcasting: " << msg;
-                                room_.deliver(msg);  // Send to everyone
-                                doRead();            // Wait for next message
-                              } else {
-                                room_.leave(shared_from_this());
-                              }
-                            });
+    socket_.async_read_some(decoder_.prepare(),
+                            withHandlerAllocator(
+                                [this, self]  // Extent lifetime for self
+                                (std::error_code ec, std::size_t length) {
+                                  if (!ec) {
+                                    decoder_.commit(length);
+                                    if (deliverFrames()) {
+                                      doRead();  // Wait for next message
+                                      return;
+                                    }
+                                    std::cout << "Frame above " << decoder_.options().maxFrameSize << " bytes: disconnecting" << std::endl;
+                                    close();
+                                  }
+                                  room_.leave(roomHandle_);
+                                }));
   }
 
-  asio::ssl::stream<tcp::socket> socket_;
-  ChatRoom& room_;
+  // Sends every complete frame received so far to everyone. A partial frame stays in the decoder.
+  // Returns false if the client sent a frame above the limit.
+  bool deliverFrames() {
+    FrameDecoder::Frame frame;
+    FrameDecoder::Status status;
+    const char* batchBegin = nullptr;
+    std::size_t batchSize = 0;
+    while ((status = decoder_.next(frame)) == FrameDecoder::Status::Frame) {
+      debugLog() << "Broadcasting: " << frame.payload << std::endl;
+      if (!batchBegin) batchBegin = frame.wire.data();
+      batchSize += frame.wire.size();
+    }
 
-  enum { max_length = 1024 };
+    if (batchSize > 0) {
+      // Frames are adjacent in the decoder's buffer: all frames of this read go out as one message.
+      SharedMessage msg(std::string_view(batchBegin, batchSize));  // The only allocation per broadcast
+      room_.deliver(msg);
+    }
+    return status != FrameDecoder::Status::TooLarge;
+  }
 
-  char data_[max_length];
+  asio::ssl::stream<tcp::socket> socket_;
+  ChatRoom& room_;
+  FrameDecoder decoder_;
+  OutboundQueue outbox_;
+  ChatRoom::Handle roomHandle_;
+  bool closed_ = false;
 };
 
-void ChatRoom::deliverMessage(std::shared_ptr<ClientSession> session, const std::string& msg) {
+void ChatRoom::deliverMessage(const std::shared_ptr<ClientSession>& session, const SharedMessage& msg) {
   session->deliver(msg);
 }
 
@@ -120,7 +186,7 @@ class ChatServer {
     acceptor_.async_accept(
         [this](std::error_code ec, tcp::socket socket) {
           if (!ec) {
-            std::make_shared<ClientSession>(std::move(socket), ssl_context_, room_)->start();
+            std::make_shared<ClientSession>(std::move(socket), ssl_context_, room_, outboundLimits_, framing_)->start();
           }
           doAccept();
         });
@@ -129,6 +195,8 @@ class ChatServer {
   tcp::acceptor acceptor_;
   asio::ssl::context ssl_context_;
   ChatRoom room_;
+  OutboundQueue::Limits outboundLimits_;  // High-water mark and slow consumer policy of every session
+  FrameDecoder::Options framing_;         // Newline-delimited messages, as sent by the client
 };
 
 int main() {
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <enet/enet.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// enet_malloc / enet_free backed by per-thread free lists of small blocks.
+// ENet allocates an ENetPacket and an ENetOutgoingCommand for every send, and an ENetPacket plus its data for every
+// receive. With the free lists those blocks come back from the blocks the thread freed before: no malloc in steady
+// state. Blocks above maxBlockSize go to malloc. A block may be freed by any thread, it joins that thread's list.
+// Every list keeps at most maxCachedBlocks blocks. The lists are not released at thread exit: host threads live as
+// long as their hosts, so this is a bounded leak.
+// USAGE EXAMPLE:
+// if (EnetFreeLists::initialize() != 0) { ... }  // Instead of enet_initialize()
+// atexit(enet_deinitialize);
+class EnetFreeLists {
+ public:
+  static constexpr std::size_t classSize = 64;
+  static constexpr std::size_t classCount = 24;  // Blocks up to 1536 bytes: an MTU sized packet fits
+  static constexpr std::size_t maxBlockSize = classSize * classCount;
+  static constexpr std::size_t maxCachedBlocks = 4096;
+
+  // Same as enet_initialize(), returns its result.
+  static int initialize() {
+    ENetCallbacks callbacks{};
+    callbacks.malloc = &allocate;
+    callbacks.free = &deallocate;
+    return enet_initialize_with_callbacks(ENET_VERSION, &callbacks);
+  }
+
+ private:
+  // Precedes every block. The size keeps the block aligned like malloc does.
+  struct alignas(alignof(std::max_align_t)) Header {
+    std::size_t sizeClass;  // classCount for blocks from malloc
+  };
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  // Trivially destructible, so a block freed during thread teardown still finds its list
+  struct ThreadLists {
+    FreeBlock* heads[classCount];
+    std::size_t counts[classCount];
+  };
+
+  static ThreadLists& lists() {
+    thread_local ThreadLists threadLists{};
+    return threadLists;
+  }
+
+  static void* allocate(std::size_t size) {
+    const std::size_t sizeClass = size == 0 ? 0 : (size - 1) / classSize;
+    if (sizeClass < classCount) {
+      ThreadLists& local = lists();
+      if (FreeBlock* block = local.heads[sizeClass]) {
+        local.heads[sizeClass] = block->next;
+        --local.counts[sizeClass];
+        return block;
+      }
+    }
+
+    const std::size_t blockSize = sizeClass < classCount ? (sizeClass + 1) * classSize : size;
+    auto* header = static_cast<Header*>(std::malloc(sizeof(Header) + blockSize));
+    if (!header) return nullptr;  // ENet calls its no_memory callback
+    header->sizeClass = sizeClass < classCount ? sizeClass : classCount;
+    return header + 1;
+  }
+
+  static void deallocate(void* memory) {
+    if (!memory) return;
+    auto* header = static_cast<Header*>(memory) - 1;
+    const std::size_t sizeClass = header->sizeClass;
+    if (sizeClass < classCount) {
+      ThreadLists& local = lists();
+      if (local.counts[sizeClass] < maxCachedBlocks) {
+        // The header stays untouched, the block is reused with the same size class
+        auto* block = static_cast<FreeBlock*>(memory);
+        block->next = local.heads[sizeClass];
+        local.heads[sizeClass] = block;
+        ++local.counts[sizeClass];
+        return;
+      }
+    }
+    std::free(header);
+  }
+};
@@ -0,0 +1,331 @@
+// Echo benchmark of the ENet servers: pooled replies vs enet_packet_create per reply, one thread vs a network thread
+// plus workers, 32 to 4095 peers.
+//
+// For every mode and peer count the server runs in-process on an ephemeral port. `client-threads` client hosts
+// share the peers, and every peer keeps `inflight` packets outstanding: each echo immediately triggers the next
+// packet. A packet carries its send time, so the RTT needs no per-peer state.
+//
+// Modes:
+// - pool:  replies are PacketPool packets (ENET_PACKET_FLAG_NO_ALLOCATE over preallocated buffers).
+// - alloc: enet_packet_create copies every reply into a new allocation, the original path of the server.
+// - split: SplitEnetServer, EnetNetworkThread services the host, `workers` threads handle the packets.
+// --work-us adds game logic to every packet: in pool / alloc it runs in the service loop, in split in a worker.
+// With --free-lists (default) ENet's own allocations come from EnetFreeLists in both modes. Flip it to see malloc.
+//
+// Reported: echoed packets per second and RTT percentiles, measured after a warm-up which includes the connection
+// setup. On the server side: ticks per second (--broadcast-ms: one shared state packet to every peer per tick), the
+// longest time the host went without service, and for split the time events waited in the queue for a worker.
+// ENet limits a host to 4095 peers (ENET_PROTOCOL_MAXIMUM_PEER_ID).
+
+#include <enet/enet.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "cxxopts.hpp"
+
+#include "../../LatencyHistogram.h"
+#include "../EnetFreeLists.h"
+#include "../server/EnetServer.h"
+#include "../server/PacketPool.h"
+#include "../server/SplitEnetServer.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+  std::size_t inflight = 1;
+  std::size_t size = 32;
+  bool reliable = true;
+  std::size_t clientThreads = 4;
+  std::chrono::milliseconds broadcastInterval{0};
+  std::chrono::nanoseconds simulatedWork{0};
+  std::size_t workers = 2;
+  std::chrono::milliseconds serviceTimeout{1};  // Network thread of split
+  std::chrono::milliseconds warmUp{2000};
+  std::chrono::milliseconds duration{3000};
+};
+
+struct BenchResult {
+  std::size_t connected = 0;
+  double packetsPerSec = 0;
+  double p50us = 0;
+  double p99us = 0;
+  double p999us = 0;
+  double ticksPerSec = 0;
+  double maxStallMs = 0;
+  double queueP99us = -1;  // Split only
+  uint64_t poolFallbacks = 0;
+  uint64_t errors = 0;
+};
+
+// State of the peers of one client host. Only touched by its thread.
+struct ClientThreadState {
+  LatencyHistogram latencies;
+  std::size_t connected = 0;
+  uint64_t replies = 0;  // Inside the measurement window
+  uint64_t errors = 0;   // Peers which failed to connect or lost the connection, sends without a packet
+};
+
+int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// One client host with `peerCount` peers, each keeping `inflight` packets outstanding until the deadline
+void runClients(ENetAddress server, std::size_t peerCount, const BenchConfig& config, Clock::time_point measureFrom,
+                Clock::time_point deadline, ClientThreadState& state) {
+  ENetHost* host = enet_host_create(nullptr, peerCount, 2, 0, 0);
+  if (!host) {
+    state.errors += peerCount;
+    return;
+  }
+  PacketPool pool(peerCount * config.inflight * 2, config.size);
+  const enet_uint32 flags = config.reliable ? ENET_PACKET_FLAG_RELIABLE : 0;
+
+  std::vector<ENetPeer*> peers;
+  for (std::size_t i = 0; i < peerCount; ++i) {
+    if (ENetPeer* peer = enet_host_connect(host, &server, 2, 0)) {
+      peers.push_back(peer);
+    } else {
+      ++state.errors;
+    }
+  }
+
+  auto send = [&](ENetPeer* peer) {
+    ENetPacket* packet = pool.create(config.size, flags);
+    if (!packet) {  // ENet is out of memory: the peer has one packet less in flight
+      ++state.errors;
+      return;
+    }
+    const int64_t sendTime = nowNs();
+    std::memset(packet->data, 0, packet->dataLength);
+    std::memcpy(packet->data, &sendTime, sizeof(sendTime));
+    if (enet_peer_send(peer, 0, packet) < 0) enet_packet_destroy(packet);
+  };
+
+  ENetEvent event;
+  while (Clock::now() < deadline) {
+    if (enet_host_service(host, &event, 1) <= 0) continue;
+    do {
+      const auto now = Clock::now();
+      const bool measuring = now >= measureFrom && now < deadline;
+      switch (event.type) {
+        case ENET_EVENT_TYPE_CONNECT: {
+          ++state.connected;
+          for (std::size_t i = 0; i < config.inflight; ++i) send(event.peer);
+          break;
+        }
+
+        case ENET_EVENT_TYPE_RECEIVE: {
+          if (event.channelID == 0 && event.packet->dataLength >= sizeof(int64_t)) {
+            int64_t sendTime = 0;
+            std::memcpy(&sendTime, event.packet->data, sizeof(sendTime));
+            const int64_t rtt = nowNs() - sendTime;
+            if (measuring) {
+              ++state.replies;
+              // Packets sent during the warm-up may have waited for the connection setup of other peers
+              if (Clock::time_point(std::chrono::nanoseconds(sendTime)) >= measureFrom) state.latencies.record(rtt);
+            }
+            send(event.peer);
+          }
+          enet_packet_destroy(event.packet);
+          break;
+        }
+
+        case ENET_EVENT_TYPE_DISCONNECT: {
+          ++state.errors;
+          break;
+        }
+
+        default: {
+          break;
+        }
+      }
+    } while (enet_host_check_events(host, &event) > 0);
+  }
+
+  // Tells the server right away, no waiting for the packets in flight
+  for (ENetPeer* peer : peers) {
+    if (peer->state != ENET_PEER_STATE_DISCONNECTED) enet_peer_disconnect_now(peer, 0);
+  }
+  enet_host_destroy(host);  // Before the pool, see PacketPool
+}
+
+std::atomic<uint64_t>& maxServiceGapNs(EnetServer& server) { return server.stats().maxServiceGapNs; }
+
+std::atomic<uint64_t>& maxServiceGapNs(SplitEnetServer& server) { return server.network().stats().maxServiceGapNs; }
+
+// Runs the clients against the running server, samples the server between measureFrom and the deadline
+template <typename Server>
+BenchResult measure(Server& server, std::size_t peerCount, const BenchConfig& config) {
+  std::thread serverThread([&server]() { server.run(); });
+
+  ENetAddress serverAddress;
+  enet_address_set_host(&serverAddress, "127.0.0.1");
+  serverAddress.port = server.port();
+
+  const auto measureFrom = Clock::now() + config.warmUp;  // Includes connection setup
+  const auto deadline = measureFrom + config.duration;
+  const std::size_t threadCount = std::clamp<std::size_t>(config.clientThreads, 1, peerCount);
+  std::vector<ClientThreadState> states(threadCount);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < threadCount; ++i) {
+    const std::size_t peers = peerCount / threadCount + (i < peerCount % threadCount ? 1 : 0);
+    threads.emplace_back([&, i, peers]() { runClients(serverAddress, peers, config, measureFrom, deadline, states[i]); });
+  }
+
+  std::this_thread::sleep_until(measureFrom);
+  const uint64_t ticksBefore = server.stats().broadcasts.load();
+  maxServiceGapNs(server).store(0);
+  if constexpr (std::is_same_v<Server, SplitEnetServer>) server.resetLatencies();
+  std::this_thread::sleep_until(deadline);
+  const uint64_t ticks = server.stats().broadcasts.load() - ticksBefore;
+  const uint64_t maxStallNs = maxServiceGapNs(server).load();
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  server.stop();
+  serverThread.join();
+
+  BenchResult result;
+  LatencyHistogram latencies;
+  uint64_t replies = 0;
+  for (auto& state : states) {
+    latencies.merge(state.latencies);
+    replies += state.replies;
+    result.connected += state.connected;
+    result.errors += state.errors;
+  }
+  const double seconds = std::chrono::duration<double>(config.duration).count();
+  result.packetsPerSec = replies / seconds;
+  result.p50us = latencies.percentile(50) / 1000.0;
+  result.p99us = latencies.percentile(99) / 1000.0;
+  result.p999us = latencies.percentile(99.9) / 1000.0;
+  result.ticksPerSec = ticks / seconds;
+  result.maxStallMs = maxStallNs / 1e6;
+  if constexpr (std::is_same_v<Server, SplitEnetServer>) result.queueP99us = server.eventLatencies().percentile(99) / 1000.0;
+  return result;
+}
+
+BenchResult runOnce(const std::string& mode, std::size_t peerCount, const BenchConfig& config) {
+  ENetAddress address;
+  address.host = ENET_HOST_ANY;
+  address.port = 0;  // Ephemeral
+
+  if (mode == "split") {
+    SplitEnetServer::Options options;
+    options.network.maxPeers = peerCount;
+    options.network.serviceTimeout = config.serviceTimeout;
+    options.workers = config.workers;
+    options.simulatedWork = config.simulatedWork;
+    options.tickInterval = config.broadcastInterval;
+    SplitEnetServer server(address, options);
+    return measure(server, peerCount, config);
+  }
+
+  EnetServer::Options options;
+  options.maxPeers = peerCount;
+  options.pooledReplies = mode == "pool";
+  options.poolBuffers = peerCount * config.inflight * 2 + 1024;  // Reliable replies stay in the pool until acknowledged
+  options.poolBufferSize = std::max(config.size, options.broadcastSize);
+  options.broadcastInterval = config.broadcastInterval;
+  options.simulatedWork = config.simulatedWork;
+  EnetServer server(address, options);
+  BenchResult result = measure(server, peerCount, config);
+  result.poolFallbacks = server.poolFallbacks();
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "ENet echo benchmark: pooled replies vs enet_packet_create per reply vs network thread + workers");
+  // clang-format off
+  options.add_options()
+      ("m,modes", "Servers to compare: pool, alloc, split", cxxopts::value<std::vector<std::string>>()->default_value("pool,alloc"))
+      ("p,peers", "Connected peers, list (at most 4095)", cxxopts::value<std::vector<std::size_t>>()->default_value("32,256,1024,4095"))
+      ("i,inflight", "Packets in flight per peer", cxxopts::value<std::size_t>()->default_value("1"))
+      ("s,size", "Packet size in bytes, at least 8", cxxopts::value<std::size_t>()->default_value("32"))
+      ("reliable", "Reliable packets", cxxopts::value<bool>()->default_value("true"))
+      ("broadcast-ms", "Server tick: state broadcast interval, 0 - no broadcast", cxxopts::value<std::size_t>()->default_value("0"))
+      ("work-us", "Simulated game logic per packet, microseconds", cxxopts::value<std::size_t>()->default_value("0"))
+      ("workers", "Worker threads of split", cxxopts::value<std::size_t>()->default_value("2"))
+      ("service-timeout-ms", "enet_host_service timeout of the split network thread, 0 - busy polling", cxxopts::value<std::size_t>()->default_value("1"))
+      ("free-lists", "ENet allocations from EnetFreeLists instead of malloc", cxxopts::value<bool>()->default_value("true"))
+      ("client-threads", "Client hosts, each one in its own thread", cxxopts::value<std::size_t>()->default_value("4"))
+      ("w,warm-up", "Warm-up in milliseconds, includes connection setup", cxxopts::value<std::size_t>()->default_value("2000"))
+      ("d,duration", "Measurement in milliseconds", cxxopts::value<std::size_t>()->default_value("3000"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  const bool freeLists = args["free-lists"].as<bool>();
+  if ((freeLists ? EnetFreeLists::initialize() : enet_initialize()) != 0) {
+    std::cerr << "Failed to initialize ENet" << std::endl;
+    return EXIT_FAILURE;
+  }
+  atexit(enet_deinitialize);
+
+  BenchConfig config;
+  config.inflight = std::max<std::size_t>(1, args["inflight"].as<std::size_t>());
+  config.size = std::max(sizeof(int64_t), args["size"].as<std::size_t>());
+  config.reliable = args["reliable"].as<bool>();
+  config.broadcastInterval = std::chrono::milliseconds(args["broadcast-ms"].as<std::size_t>());
+  config.simulatedWork = std::chrono::microseconds(args["work-us"].as<std::size_t>());
+  config.workers = args["workers"].as<std::size_t>();
+  config.serviceTimeout = std::chrono::milliseconds(args["service-timeout-ms"].as<std::size_t>());
+  config.clientThreads = args["client-threads"].as<std::size_t>();
+  config.warmUp = std::chrono::milliseconds(args["warm-up"].as<std::size_t>());
+  config.duration = std::chrono::milliseconds(std::max<std::size_t>(1, args["duration"].as<std::size_t>()));
+
+  struct Row {
+    std::string mode;
+    std::size_t peers;
+    BenchResult result;
+  };
+  std::vector<Row> results;
+  try {
+    for (auto& mode : args["modes"].as<std::vector<std::string>>()) {
+      for (auto peers : args["peers"].as<std::vector<std::size_t>>()) {
+        peers = std::clamp<std::size_t>(peers, 1, ENET_PROTOCOL_MAXIMUM_PEER_ID);
+        std::cout << "Running " << mode << " server, " << peers << " peers x " << config.inflight << " in flight..." << std::endl;
+        results.push_back({mode, peers, runOnce(mode, peers, config)});
+      }
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "\nsize=" << config.size << " reliable=" << config.reliable << " inflight=" << config.inflight << " free lists=" << freeLists
+            << " work us=" << config.simulatedWork.count() / 1000 << " workers=" << config.workers << " client threads=" << config.clientThreads << "\n\n";
+  std::cout << std::left << std::setw(7) << "mode" << std::setw(7) << "peers" << std::setw(11) << "connected" << std::setw(13) << "packets/s"
+            << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(12) << "p99.9 us" << std::setw(9) << "ticks/s"
+            << std::setw(14) << "max stall ms" << std::setw(14) << "queue p99 us" << std::setw(11) << "fallbacks" << "errors" << std::endl;
+  for (auto& [mode, peers, r] : results) {
+    std::cout << std::left << std::setw(7) << mode << std::setw(7) << peers << std::setw(11) << r.connected << std::fixed << std::setprecision(0)
+              << std::setw(13) << r.packetsPerSec << std::setprecision(1) << std::setw(10) << r.p50us << std::setw(10) << r.p99us
+              << std::setw(12) << r.p999us << std::setw(9) << r.ticksPerSec << std::setprecision(2) << std::setw(14) << r.maxStallMs
+              << std::setprecision(1) << std::setw(14);
+    if (r.queueP99us >= 0) {
+      std::cout << r.queueP99us;
+    } else {
+      std::cout << "-";
+    }
+    std::cout << std::setw(11) << r.poolFallbacks << r.errors << std::endl;
+  }
+  return 0;
+}
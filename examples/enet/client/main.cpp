@@ -1,9 +1,43 @@
 #include <enet/enet.h>
 
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <string>
 
+#include "../snapshot/SnapshotReceiver.h"
+
+// Decodes the snapshots of the server and acknowledges them for `duration`
+void receiveSnapshots(ENetHost* client, ENetPeer* peer, std::chrono::seconds duration) {
+  SnapshotReceiver receiver;
+  uint64_t bytes = 0;
+  std::size_t entities = 0;
+  const auto deadline = std::chrono::steady_clock::now() + duration;
+  ENetEvent event;
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (enet_host_service(client, &event, 100) <= 0) continue;
+    if (event.type != ENET_EVENT_TYPE_RECEIVE) continue;
+    if (event.channelID == 1) {
+      bytes += event.packet->dataLength;
+      if (const Snapshot* snapshot = receiver.receive({event.packet->data, event.packet->dataLength})) {
+        entities = snapshot->entities.size();
+        uint8_t ack[SnapshotFormat::ackSize];
+        SnapshotFormat::writeAck(snapshot->tick, ack);
+        enet_peer_send(peer, 1, enet_packet_create(ack, sizeof(ack), 0));  // Unreliable: the next ack replaces a lost one
+      }
+    }
+    enet_packet_destroy(event.packet);
+  }
+
+  const auto& stats = receiver.stats();
+  std::cout << "Snapshots: " << stats.decoded << " decoded (" << stats.full << " full) of " << stats.received << " received, "
+            << (stats.received ? bytes / stats.received : 0) << " bytes per snapshot, " << entities << " entities" << std::endl;
+}
+
+// Usage: enet_client_minimalProject [snapshotSeconds]
+//   snapshotSeconds - after the echo, receive the snapshots of the server for that long (default 0: none; start the
+//                     server with snapshotEntities)
 int main(int argc, char** argv) {
   if (enet_initialize() != 0) {
     std::cerr << "Failed to initialize ENet" << std::endl;
@@ -57,12 +91,15 @@ int main(int argc, char** argv) {
   // Receive response
   while (enet_host_service(client, &event, 3000) > 0) {
     if (event.type == ENET_EVENT_TYPE_RECEIVE) {
-      std::cout << "Client received: " << event.packet->data << std::endl;
+      const bool echo = event.channelID == 0;  // Channel 1 carries the state broadcast
+      if (echo) std::cout << "Client received: " << event.packet->data << std::endl;  // The server echoes the message
       enet_packet_destroy(event.packet);
-      break;
+      if (echo) break;
     }
   }
 
+  if (argc > 1) receiveSnapshots(client, peer, std::chrono::seconds(std::stoul(argv[1])));
+
   // Gracefully disconnected
   enet_peer_disconnect(peer, 0);
   while (enet_host_service(client, &event, 3000) > 0) {
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <enet/enet.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../../DebugLog.h"
+#include "blockingconcurrentqueue.h"
+#include "concurrentqueue.h"
+
+// Owns the ENetHost and services it on a dedicated thread. Worker threads never touch the host: they take the
+// inbound events from a lock-free queue and hand their packets back through another one, so game logic of any cost
+// never delays acknowledgements, pings or the sends of other peers.
+//
+// Peers are named by PeerId (the slot of the peer in the host plus its connectID), a stale id of a peer that
+// disconnected or whose slot was reused is ignored. Packets change hands with their events and commands:
+// - a received packet belongs to the worker which took the event, it must enet_packet_destroy it;
+// - a packet given to send() or broadcast() belongs to the network thread.
+// Workers create packets with enet_packet_create: with EnetFreeLists that is thread safe and cheap.
+// The host is serviced with serviceTimeout: a command waits at most that long when no packet arrives.
+// USAGE EXAMPLE:
+// EnetNetworkThread network(address, {.maxPeers = 1024});
+// EnetNetworkThread::Event event;
+// while (network.waitEvent(event, std::chrono::milliseconds(100))) {  // In every worker
+//   if (event.type == EnetNetworkThread::Event::Receive) {
+//     network.send(event.peer, event.channel, enet_packet_create(...));
+//     enet_packet_destroy(event.packet);
+//   }
+// }
+class EnetNetworkThread {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using PeerId = uint64_t;
+
+  struct Options {
+    std::size_t maxPeers = 32;  // ENet allows up to ENET_PROTOCOL_MAXIMUM_PEER_ID (4095)
+    std::size_t channels = 2;
+    std::chrono::milliseconds serviceTimeout{1};  // 0 - busy polling, lowest latency for one core
+  };
+
+  struct Event {
+    enum Type { Connect, Receive, Disconnect };
+
+    Type type = Receive;
+    PeerId peer = 0;
+    enet_uint8 channel = 0;
+    ENetPacket* packet = nullptr;  // Receive only, owned by the taker of the event
+    Clock::time_point received;    // When the network thread got it: the start of the queueing latency
+  };
+
+  // Thread safe to read while the thread runs
+  struct Stats {
+    std::atomic<uint64_t> serviceLoops{0};
+    std::atomic<uint64_t> events{0};
+    std::atomic<uint64_t> commands{0};
+    std::atomic<uint64_t> maxServiceGapNs{0};  // Longest time without enet_host_service: the work between two calls
+  };
+
+  explicit EnetNetworkThread(const ENetAddress& address) : EnetNetworkThread(address, Options{}) {}
+
+  // Throws std::runtime_error if the host can't be created.
+  EnetNetworkThread(const ENetAddress& address, Options options) : options_(options) {
+    host_ = enet_host_create(&address, options_.maxPeers, options_.channels, 0, 0);
+    if (!host_) throw std::runtime_error("Failed to create server host");
+    connectIds_.resize(host_->peerCount);
+    thread_ = std::thread([this]() { run(); });
+  }
+
+  EnetNetworkThread(const EnetNetworkThread&) = delete;
+
+  EnetNetworkThread& operator=(const EnetNetworkThread&) = delete;
+
+  // Stops the thread, destroys the packets nobody took and the host
+  ~EnetNetworkThread() {
+    stop();
+    Event event;
+    while (events_.try_dequeue(event)) {
+      if (event.packet) enet_packet_destroy(event.packet);
+    }
+    Command command;
+    while (commands_.try_dequeue(command)) {
+      if (command.packet) enet_packet_destroy(command.packet);
+    }
+    enet_host_destroy(host_);
+  }
+
+  enet_uint16 port() const { return host_->address.port; }
+
+  Stats& stats() { return stats_; }
+
+  // Thread safe. Waits up to `timeout` for the next inbound event.
+  template <typename Rep, typename Period>
+  bool waitEvent(Event& event, std::chrono::duration<Rep, Period> timeout) {
+    return events_.wait_dequeue_timed(event, timeout);
+  }
+
+  // Thread safe. Takes up to `max` events without waiting.
+  std::size_t pollEvents(Event* events, std::size_t max) { return events_.try_dequeue_bulk(events, max); }
+
+  // Thread safe. Sends the packet to the peer, destroys it if the peer is gone.
+  void send(PeerId peer, enet_uint8 channel, ENetPacket* packet) { commands_.enqueue({Command::Send, peer, channel, packet}); }
+
+  // Thread safe. One packet for every connected peer.
+  void broadcast(enet_uint8 channel, ENetPacket* packet) { commands_.enqueue({Command::Broadcast, 0, channel, packet}); }
+
+  // Thread safe. Disconnects the peer after its queued packets are sent.
+  void disconnect(PeerId peer) { commands_.enqueue({Command::Disconnect, peer, 0, nullptr}); }
+
+  // Thread safe. Joins the network thread, the queued commands are applied first.
+  void stop() {
+    stopping_ = true;
+    if (thread_.joinable()) thread_.join();
+  }
+
+ private:
+  struct Command {
+    enum Type { Send, Broadcast, Disconnect };
+
+    Type type = Send;
+    PeerId peer = 0;
+    enet_uint8 channel = 0;
+    ENetPacket* packet = nullptr;
+  };
+
+  static constexpr std::size_t commandBatch = 256;
+
+  // ENet resets the peer before it reports the disconnect, so the connectID is taken from connectIds_
+  PeerId idOf(const ENetPeer* peer) const { return (PeerId{connectIds_[peer->incomingPeerID]} << 16) | peer->incomingPeerID; }
+
+  // Connected peer with the id, or nullptr
+  ENetPeer* peerOf(PeerId id) const {
+    const std::size_t index = id & 0xFFFF;
+    if (index >= host_->peerCount) return nullptr;
+    ENetPeer* peer = &host_->peers[index];
+    return peer->connectID == (id >> 16) && peer->state == ENET_PEER_STATE_CONNECTED ? peer : nullptr;
+  }
+
+  void run() {
+    auto serviceReturned = Clock::now();
+    ENetEvent event;
+    while (true) {
+      const bool stopping = stopping_.load();
+      applyCommands();
+
+      const auto gapNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - serviceReturned).count());
+      if (gapNs > stats_.maxServiceGapNs.load(std::memory_order_relaxed)) stats_.maxServiceGapNs.store(gapNs, std::memory_order_relaxed);
+      stats_.serviceLoops.fetch_add(1, std::memory_order_relaxed);
+
+      // Sends the queued packets, then waits for packets
+      const auto timeout = stopping ? 0 : static_cast<enet_uint32>(options_.serviceTimeout.count());
+      const int serviced = enet_host_service(host_, &event, timeout);
+      serviceReturned = Clock::now();
+      if (serviced > 0) {
+        do {
+          post(event);
+        } while (enet_host_check_events(host_, &event) > 0);
+      }
+      if (stopping) break;  // The commands queued before stop() went out with the last service call
+    }
+    enet_host_flush(host_);
+  }
+
+  void applyCommands() {
+    Command batch[commandBatch];
+    std::size_t count;
+    while ((count = commands_.try_dequeue_bulk(batch, commandBatch)) > 0) {
+      stats_.commands.fetch_add(count, std::memory_order_relaxed);
+      for (std::size_t i = 0; i < count; ++i) {
+        apply(batch[i]);
+      }
+    }
+  }
+
+  void apply(const Command& command) {
+    switch (command.type) {
+      case Command::Send: {
+        ENetPeer* peer = peerOf(command.peer);
+        if (!peer || enet_peer_send(peer, command.channel, command.packet) < 0) enet_packet_destroy(command.packet);
+        break;
+      }
+
+      case Command::Broadcast: {
+        enet_host_broadcast(host_, command.channel, command.packet);  // Destroys the packet if no peer is connected
+        break;
+      }
+
+      case Command::Disconnect: {
+        if (ENetPeer* peer = peerOf(command.peer)) enet_peer_disconnect_later(peer, 0);
+        break;
+      }
+    }
+  }
+
+  void post(const ENetEvent& event) {
+    if (event.type == ENET_EVENT_TYPE_CONNECT) connectIds_[event.peer->incomingPeerID] = event.peer->connectID;
+
+    Event posted;
+    posted.peer = idOf(event.peer);
+    posted.channel = event.channelID;
+    posted.received = Clock::now();
+    switch (event.type) {
+      case ENET_EVENT_TYPE_CONNECT: {
+        debugLog() << "Client connected from " << event.peer->address.host << ":" << event.peer->address.port << std::endl;
+        posted.type = Event::Connect;
+        break;
+      }
+
+      case ENET_EVENT_TYPE_RECEIVE: {
+        posted.type = Event::Receive;
+        posted.packet = event.packet;
+        break;
+      }
+
+      case ENET_EVENT_TYPE_DISCONNECT: {
+        debugLog() << "Client disconnected" << std::endl;
+        posted.type = Event::Disconnect;
+        break;
+      }
+
+      default: {
+        return;
+      }
+    }
+    stats_.events.fetch_add(1, std::memory_order_relaxed);
+    events_.enqueue(posted);
+  }
+
+  Options options_;
+  ENetHost* host_ = nullptr;
+  std::vector<enet_uint32> connectIds_;  // By peer slot, only touched by the network thread
+  moodycamel::BlockingConcurrentQueue<Event> events_;  // Workers wait on it
+  moodycamel::ConcurrentQueue<Command> commands_;      // The network thread polls it every service loop
+  std::atomic<bool> stopping_{false};
+  Stats stats_;
+  std::thread thread_;
+};
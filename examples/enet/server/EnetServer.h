@@ -0,0 +1,228 @@
+#pragma once
+
+#include <enet/enet.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "../../DebugLog.h"
+#include "../snapshot/MovingEntities.h"
+#include "../snapshot/SnapshotReplicator.h"
+#include "PacketPool.h"
+
+// Spins for `duration`: stands in for the game logic of one packet in benchmarks
+inline void busyWork(std::chrono::nanoseconds duration) {
+  if (duration.count() <= 0) return;
+  const auto until = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < until) {
+  }
+}
+
+// Echo server: every received packet is sent back to its peer, on the same channel and with the same reliability.
+// Optionally broadcasts a state packet to every peer each broadcastInterval. With snapshotEntities every peer gets a
+// snapshot of a world of moving entities instead: the changes since the last snapshot it acknowledged on the
+// broadcast channel (SnapshotReplicator), or a full one when it has none.
+//
+// The hot path doesn't log and doesn't allocate: replies are pooled packets (PacketPool, ENET_PACKET_FLAG_NO_ALLOCATE)
+// and the broadcast is one pre-built packet shared by every peer through enet_host_broadcast. With
+// EnetFreeLists::initialize() ENet's own allocations are recycled too.
+// Game logic runs in the service loop: its cost delays the service of every peer. See SplitEnetServer.h for the
+// server which moves it to worker threads.
+// USAGE EXAMPLE:
+// EnetServer server(address, {.maxPeers = 1024});
+// std::thread thread([&server]() { server.run(); });
+// ...
+// server.stop();
+// thread.join();
+class EnetServer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    std::size_t maxPeers = 32;  // ENet allows up to ENET_PROTOCOL_MAXIMUM_PEER_ID (4095)
+    std::size_t channels = 2;
+    bool pooledReplies = true;  // false - enet_packet_create for every reply, the original path
+    std::size_t poolBuffers = 4096;
+    std::size_t poolBufferSize = 1024;
+    std::chrono::milliseconds broadcastInterval{0};  // 0 - no broadcast
+    std::size_t broadcastSize = 64;
+    enet_uint8 broadcastChannel = 1;
+    std::chrono::nanoseconds simulatedWork{0};  // busyWork per received packet, in the service loop
+    std::size_t snapshotEntities = 0;           // 0 - the broadcast, N - per-peer snapshots of N entities
+    std::size_t snapshotHistory = 32;           // Ticks a snapshot stays usable as a baseline
+  };
+
+  // Thread safe to read while the server runs
+  struct Stats {
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> broadcasts{0};
+    std::atomic<std::size_t> peers{0};
+    std::atomic<uint64_t> maxServiceGapNs{0};  // Longest time without enet_host_service: the work between two calls
+    std::atomic<uint64_t> snapshotBytes{0};
+  };
+
+  explicit EnetServer(const ENetAddress& address) : EnetServer(address, Options{}) {}
+
+  // Throws std::runtime_error if the host can't be created, std::invalid_argument for too many snapshot entities.
+  EnetServer(const ENetAddress& address, Options options)
+      : options_(options),
+        pool_(options.poolBuffers, options.poolBufferSize),
+        world_({.count = options.snapshotEntities}),
+        replicator_({.historySize = options.snapshotHistory}) {
+    host_ = enet_host_create(&address, options_.maxPeers, options_.channels, 0, 0);
+    if (!host_) throw std::runtime_error("Failed to create server host");
+  }
+
+  EnetServer(const EnetServer&) = delete;
+
+  EnetServer& operator=(const EnetServer&) = delete;
+
+  // Destroys the host before the pool: queued pooled packets go back to the pool
+  ~EnetServer() { enet_host_destroy(host_); }
+
+  enet_uint16 port() const { return host_->address.port; }
+
+  const Options& options() const { return options_; }
+
+  Stats& stats() { return stats_; }
+
+  // Pooled packets created with enet_packet_create because the pool was empty. Read after run() returned.
+  uint64_t poolFallbacks() const { return pool_.fallbacks(); }
+
+  // Services the host in the calling thread until stop()
+  void run() {
+    auto nextBroadcast = Clock::now() + options_.broadcastInterval;
+    auto serviceReturned = Clock::now();
+    ENetEvent event;
+    while (!stopping_.load(std::memory_order_relaxed)) {
+      recordServiceGap(Clock::now() - serviceReturned);
+
+      // Sends the queued replies, then waits for packets
+      const int serviced = enet_host_service(host_, &event, serviceTimeoutMs(nextBroadcast));
+      serviceReturned = Clock::now();
+      if (serviced > 0) {
+        do {
+          handle(event);
+        } while (enet_host_check_events(host_, &event) > 0);  // Events of the same service call, no socket I/O
+      }
+
+      if (options_.broadcastInterval.count() > 0 && Clock::now() >= nextBroadcast) {
+        if (options_.snapshotEntities > 0) {
+          sendSnapshots();
+        } else {
+          broadcast();
+        }
+        nextBroadcast += options_.broadcastInterval;
+      }
+    }
+    enet_host_flush(host_);
+  }
+
+  // Thread safe. run() returns within maxServiceTimeoutMs.
+  void stop() { stopping_ = true; }
+
+ private:
+  static constexpr enet_uint32 maxServiceTimeoutMs = 100;
+
+  enet_uint32 serviceTimeoutMs(Clock::time_point nextBroadcast) const {
+    if (options_.broadcastInterval.count() <= 0) return maxServiceTimeoutMs;
+    const auto untilBroadcast = std::chrono::duration_cast<std::chrono::milliseconds>(nextBroadcast - Clock::now()).count();
+    return static_cast<enet_uint32>(std::clamp<long long>(untilBroadcast, 0, maxServiceTimeoutMs));
+  }
+
+  void recordServiceGap(Clock::duration gap) {
+    const auto gapNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(gap).count());
+    if (gapNs > stats_.maxServiceGapNs.load(std::memory_order_relaxed)) stats_.maxServiceGapNs.store(gapNs, std::memory_order_relaxed);
+  }
+
+  void handle(const ENetEvent& event) {
+    switch (event.type) {
+      case ENET_EVENT_TYPE_CONNECT: {
+        debugLog() << "Client connected from " << event.peer->address.host << ":" << event.peer->address.port << std::endl;
+        event.peer->data = (void*)"Client";
+        replicator_.resetPeer(event.peer->incomingPeerID);
+        ++stats_.peers;
+        break;
+      }
+
+      case ENET_EVENT_TYPE_RECEIVE: {
+        if (options_.snapshotEntities > 0 && event.channelID == options_.broadcastChannel) {
+          acknowledge(event.peer, event.packet);
+        } else {
+          reply(event.peer, event.channelID, event.packet);
+        }
+        enet_packet_destroy(event.packet);
+        break;
+      }
+
+      case ENET_EVENT_TYPE_DISCONNECT: {
+        debugLog() << "Client disconnected" << std::endl;
+        event.peer->data = nullptr;
+        replicator_.resetPeer(event.peer->incomingPeerID);
+        --stats_.peers;
+        break;
+      }
+
+      default: {
+        break;
+      }
+    }
+  }
+
+  // Echoes the packet: the same payload, channel and reliability
+  void reply(ENetPeer* peer, enet_uint8 channel, const ENetPacket* request) {
+    stats_.received.fetch_add(1, std::memory_order_relaxed);
+    busyWork(options_.simulatedWork);
+    const enet_uint32 flags = request->flags & (ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_UNSEQUENCED);
+    ENetPacket* packet = options_.pooledReplies ? pool_.create(request->data, request->dataLength, flags)
+                                                : enet_packet_create(request->data, request->dataLength, flags);
+    if (packet && enet_peer_send(peer, channel, packet) < 0) enet_packet_destroy(packet);
+  }
+
+  // One packet for every peer: built once, referenced by each peer's queue, returned to the pool after the last send
+  void broadcast() {
+    ENetPacket* packet = pool_.create(options_.broadcastSize, 0);  // Unreliable: a newer state replaces a lost one
+    if (!packet) return;
+    const uint64_t number = stats_.broadcasts.fetch_add(1, std::memory_order_relaxed);
+    std::memset(packet->data, 0, packet->dataLength);
+    std::memcpy(packet->data, &number, std::min(sizeof(number), packet->dataLength));
+    enet_host_broadcast(host_, options_.broadcastChannel, packet);  // Destroys the packet if no peer is connected
+  }
+
+  // Snapshot of the next tick for every connected peer. Unreliable with unreliable fragments: a lost fragment costs
+  // that snapshot only, never a resend. Not pooled: the sizes differ per peer and a full snapshot exceeds the buffers.
+  void sendSnapshots() {
+    const float dt = std::chrono::duration<float>(options_.broadcastInterval).count();
+    world_.step(dt, ++tick_, snapshot_);
+    replicator_.swapIn(snapshot_);  // No copy of the entities
+    stats_.broadcasts.fetch_add(1, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < host_->peerCount; ++i) {
+      ENetPeer* peer = &host_->peers[i];
+      if (peer->state != ENET_PEER_STATE_CONNECTED) continue;
+      const auto bytes = replicator_.encodeFor(peer->incomingPeerID);
+      ENetPacket* packet = enet_packet_create(bytes.data(), bytes.size(), ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT);
+      if (packet && enet_peer_send(peer, options_.broadcastChannel, packet) < 0) enet_packet_destroy(packet);
+      stats_.snapshotBytes.fetch_add(bytes.size(), std::memory_order_relaxed);
+    }
+  }
+
+  void acknowledge(ENetPeer* peer, const ENetPacket* packet) {
+    uint32_t tick = 0;
+    if (SnapshotFormat::readAck({packet->data, packet->dataLength}, tick)) replicator_.acknowledge(peer->incomingPeerID, tick);
+  }
+
+  Options options_;
+  PacketPool pool_;  // Outlives every packet: ~EnetServer destroys the host before the members
+  ENetHost* host_ = nullptr;
+  MovingEntities world_;
+  SnapshotReplicator replicator_;
+  Snapshot snapshot_;  // Swapped with the oldest snapshot of replicator_ every tick: its buffer is reused
+  uint32_t tick_ = 0;
+  std::atomic<bool> stopping_{false};
+  Stats stats_;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <enet/enet.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Preallocated buffers for outgoing packets.
+// A pooled packet is created with ENET_PACKET_FLAG_NO_ALLOCATE over one of the buffers: ENet doesn't allocate or copy
+// the payload, and gives the buffer back through packet->freeCallback once the last peer is done with the packet
+// (acknowledged for reliable packets, sent for the others). A packet passed to enet_host_broadcast is shared by every
+// peer, so one buffer serves all of them.
+// When every buffer is in use or the payload doesn't fit, create() falls back to a regular enet_packet_create.
+// Not thread safe: packets must be created and destroyed by the thread which services the host, and the pool must
+// outlive the host (enet_host_destroy releases the packets still queued).
+// USAGE EXAMPLE:
+// PacketPool pool(4096, 1024);
+// ENetPacket* reply = pool.create(event.packet->data, event.packet->dataLength, ENET_PACKET_FLAG_RELIABLE);
+// enet_peer_send(event.peer, 0, reply);
+class PacketPool {
+ public:
+  PacketPool(std::size_t bufferCount, std::size_t bufferSize)
+      : bufferSize_(bufferSize), storage_(bufferCount * bufferSize) {
+    free_.reserve(bufferCount);
+    for (std::size_t i = 0; i < bufferCount; ++i) {
+      free_.push_back(storage_.data() + i * bufferSize);
+    }
+  }
+
+  PacketPool(const PacketPool&) = delete;
+
+  PacketPool& operator=(const PacketPool&) = delete;
+
+  // Packet of `size` bytes for the caller to fill in at packet->data. Returns nullptr only if ENet is out of memory.
+  ENetPacket* create(std::size_t size, enet_uint32 flags) {
+    if (size > bufferSize_ || free_.empty()) {
+      ++fallbacks_;
+      return enet_packet_create(nullptr, size, flags);
+    }
+    uint8_t* buffer = free_.back();
+    ENetPacket* packet = enet_packet_create(buffer, size, flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+    if (!packet) return nullptr;
+    free_.pop_back();
+    packet->userData = this;
+    packet->freeCallback = &release;
+    return packet;
+  }
+
+  // Packet with a copy of `data`
+  ENetPacket* create(const void* data, std::size_t size, enet_uint32 flags) {
+    ENetPacket* packet = create(size, flags);
+    if (packet && size > 0) std::memcpy(packet->data, data, size);
+    return packet;
+  }
+
+  std::size_t bufferSize() const { return bufferSize_; }
+
+  // Buffers not owned by a packet
+  std::size_t available() const { return free_.size(); }
+
+  // Packets created with enet_packet_create because no buffer was available
+  uint64_t fallbacks() const { return fallbacks_; }
+
+ private:
+  static void release(ENetPacket* packet) {
+    auto* pool = static_cast<PacketPool*>(packet->userData);
+    pool->free_.push_back(packet->data);
+  }
+
+  std::size_t bufferSize_;
+  std::vector<uint8_t> storage_;
+  std::vector<uint8_t*> free_;
+  uint64_t fallbacks_ = 0;
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <enet/enet.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../../LatencyHistogram.h"
+#include "EnetNetworkThread.h"
+#include "EnetServer.h"
+
+// Same protocol as EnetServer (echo, optional state broadcast), split across threads:
+// - EnetNetworkThread owns the host and only moves packets between the socket and the queues;
+// - `workers` threads run the game logic: the echo plus simulatedWork per packet;
+// - the thread which calls run() ticks: every tickInterval it broadcasts the state packet.
+// A slow packet handler delays only its own worker, never the service of the host or the tick.
+// USAGE EXAMPLE:
+// SplitEnetServer server(address, {.workers = 4, .tickInterval = std::chrono::milliseconds(16)});
+// server.run();  // Until stop()
+class SplitEnetServer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    EnetNetworkThread::Options network;
+    std::size_t workers = 2;
+    std::chrono::nanoseconds simulatedWork{0};  // busyWork per received packet, in a worker
+    std::chrono::milliseconds tickInterval{0};  // State broadcast, 0 - no broadcast
+    std::size_t broadcastSize = 64;
+    enet_uint8 broadcastChannel = 1;
+  };
+
+  // Thread safe to read while the server runs
+  struct Stats {
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> broadcasts{0};
+    std::atomic<uint64_t> maxTickLateNs{0};  // Longest delay of a tick after its scheduled time
+  };
+
+  explicit SplitEnetServer(const ENetAddress& address) : SplitEnetServer(address, Options{}) {}
+
+  // Throws std::runtime_error if the host can't be created.
+  SplitEnetServer(const ENetAddress& address, Options options)
+      : options_(options), network_(address, options.network), workers_(options.workers == 0 ? 1 : options.workers) {}
+
+  ~SplitEnetServer() { stop(); }
+
+  enet_uint16 port() const { return network_.port(); }
+
+  EnetNetworkThread& network() { return network_; }
+
+  Stats& stats() { return stats_; }
+
+  // Starts the workers and ticks in the calling thread until stop(). Joins the workers before it returns.
+  void run() {
+    for (auto& worker : workers_) {
+      worker.thread = std::thread([this, &worker]() { work(worker); });
+    }
+
+    auto nextTick = Clock::now() + options_.tickInterval;
+    while (true) {
+      {
+        // Sleeps until the tick, stop() wakes it
+        std::unique_lock lock(stopMutex_);
+        const auto stopped = [this]() { return stopping_.load(); };
+        if (options_.tickInterval.count() <= 0) {
+          stopRequested_.wait(lock, stopped);
+          break;
+        }
+        if (stopRequested_.wait_until(lock, nextTick, stopped)) break;
+      }
+      const auto lateNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - nextTick).count());
+      if (lateNs > stats_.maxTickLateNs.load(std::memory_order_relaxed)) stats_.maxTickLateNs.store(lateNs, std::memory_order_relaxed);
+      tick();
+      nextTick += options_.tickInterval;
+    }
+
+    for (auto& worker : workers_) {
+      if (worker.thread.joinable()) worker.thread.join();
+    }
+  }
+
+  // Thread safe. Wakes the tick at once, run() returns when the workers see it: within the 100 ms they wait for events.
+  void stop() {
+    {
+      std::lock_guard lock(stopMutex_);
+      stopping_ = true;
+    }
+    stopRequested_.notify_all();
+  }
+
+  // Thread safe. Starts a new measurement of the queueing latency.
+  void resetLatencies() { latencyEpoch_.fetch_add(1); }
+
+  // Time from the network thread receiving an event to a worker taking it. Call after run() returned.
+  LatencyHistogram eventLatencies() const {
+    LatencyHistogram merged;
+    for (auto& worker : workers_) {
+      merged.merge(worker.latencies);
+    }
+    return merged;
+  }
+
+ private:
+  struct Worker {
+    std::thread thread;
+    LatencyHistogram latencies;
+    uint64_t latencyEpoch = 0;
+  };
+
+  static constexpr std::size_t eventBatch = 64;
+
+  void work(Worker& worker) {
+    EnetNetworkThread::Event events[eventBatch];
+    while (!stopping_.load(std::memory_order_relaxed)) {
+      std::size_t count = network_.pollEvents(events, eventBatch);
+      if (count == 0) {
+        if (!network_.waitEvent(events[0], std::chrono::milliseconds(100))) continue;
+        count = 1;
+      }
+
+      const auto now = Clock::now();
+      if (const uint64_t epoch = latencyEpoch_.load(std::memory_order_relaxed); epoch != worker.latencyEpoch) {
+        worker.latencies.reset();
+        worker.latencyEpoch = epoch;
+      }
+      for (std::size_t i = 0; i < count; ++i) {
+        worker.latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - events[i].received).count());
+        handle(events[i]);
+      }
+    }
+  }
+
+  void handle(const EnetNetworkThread::Event& event) {
+    if (event.type != EnetNetworkThread::Event::Receive) return;  // Nothing per peer to set up or tear down
+
+    // Echoes the packet: the same payload, channel and reliability
+    stats_.received.fetch_add(1, std::memory_order_relaxed);
+    busyWork(options_.simulatedWork);
+    const enet_uint32 flags = event.packet->flags & (ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_UNSEQUENCED);
+    if (ENetPacket* reply = enet_packet_create(event.packet->data, event.packet->dataLength, flags)) {
+      network_.send(event.peer, event.channel, reply);
+    }
+    enet_packet_destroy(event.packet);
+  }
+
+  // One packet for every peer, the network thread broadcasts it
+  void tick() {
+    ENetPacket* packet = enet_packet_create(nullptr, options_.broadcastSize, 0);  // Unreliable: a newer state replaces a lost one
+    if (!packet) return;
+    const uint64_t number = stats_.broadcasts.fetch_add(1, std::memory_order_relaxed);
+    std::memset(packet->data, 0, packet->dataLength);
+    std::memcpy(packet->data, &number, std::min(sizeof(number), packet->dataLength));
+    network_.broadcast(options_.broadcastChannel, packet);
+  }
+
+  Options options_;
+  EnetNetworkThread network_;
+  std::vector<Worker> workers_;
+  std::atomic<bool> stopping_{false};  // Set under stopMutex_: the tick can't miss the notification
+  std::mutex stopMutex_;
+  std::condition_variable stopRequested_;
+  std::atomic<uint64_t> latencyEpoch_{0};
+  Stats stats_;
+};
@@ -1,11 +1,23 @@
 #include <enet/enet.h>
 
+#include <chrono>
 #include <cstdlib>
-#include <cstring>
 #include <iostream>
-
+#include <string>
+
+#include "../EnetFreeLists.h"
+#include "EnetServer.h"
+#include "SplitEnetServer.h"
+
+// Usage: enet_server_minimalProject [maxPeers] [broadcastMs] [workers] [snapshotEntities]
+//   maxPeers         - connected clients at most (default 32, ENet allows up to 4095)
+//   broadcastMs      - interval of the state broadcast to every client (default 0: no broadcast)
+//   workers          - 0 (default): one thread services the host and handles the packets (EnetServer),
+//                      N: a network thread plus N worker threads (SplitEnetServer)
+//   snapshotEntities - 0 (default): the broadcast is one shared packet, N: every broadcastMs each client gets a delta
+//                      snapshot of N moving entities (EnetServer only)
 int main(int argc, char** argv) {
-  if (enet_initialize() != 0) {
+  if (EnetFreeLists::initialize() != 0) {
     std::cerr << "Failed to initialize ENet" << std::endl;
     return EXIT_FAILURE;
   }
@@ -16,58 +28,33 @@ int main(int argc, char** argv) {
   address.host = ENET_HOST_ANY;
   address.port = 87654;
 
-  ENetHost* server = enet_host_create(&address,
-                                      32,  // max clients
-                                      2,   // channels
-                                      0,
-                                      0);
-
-  if (!server) {
-    std::cerr << "Failed to create server host" << std::endl;
-    return EXIT_FAILURE;
-  }
-
-  std::cout << "Server started on port " << address.port << std::endl;
-
-  ENetEvent event;
-
-  while (true) {
-    while (enet_host_service(server, &event, 1000) > 0) {
-      switch (event.type) {
-        case ENET_EVENT_TYPE_CONNECT: {
-          std::cout << "Client connected from "
-                    << event.peer->address.host << ":"
-                    << event.peer->address.port << std::endl;
-          event.peer->data = (void*)"Client";
-          break;
-        }
-
-        case ENET_EVENT_TYPE_RECEIVE: {
-          std::cout << "Server received: " << event.packet->data << std::endl;
-
-          const char* reply = "Hello from server!";
-          ENetPacket* packet = enet_packet_create(reply,
-                                                  strlen(reply) + 1,
-                                                  ENET_PACKET_FLAG_RELIABLE);
-          enet_peer_send(event.peer, 0, packet);
-
-          enet_packet_destroy(event.packet);
-          break;
-        }
-
-        case ENET_EVENT_TYPE_DISCONNECT: {
-          std::cout << "Client disconnected" << std::endl;
-          event.peer->data = nullptr;
-          break;
-        }
-
-        default: {
-          break;
-        }
-      }
+  try {
+    const std::size_t maxPeers = argc > 1 ? std::stoul(argv[1]) : 32;
+    const auto broadcastInterval = std::chrono::milliseconds(argc > 2 ? std::stoul(argv[2]) : 0);
+    const std::size_t workers = argc > 3 ? std::stoul(argv[3]) : 0;
+    const std::size_t snapshotEntities = argc > 4 ? std::stoul(argv[4]) : 0;
+
+    // Echoes every packet back to its client
+    if (workers > 0) {
+      SplitEnetServer::Options options;
+      options.network.maxPeers = maxPeers;
+      options.workers = workers;
+      options.tickInterval = broadcastInterval;
+      SplitEnetServer server(address, options);
+      std::cout << "Server started on port " << server.port() << " (network thread + " << workers << " workers)" << std::endl;
+      server.run();
+    } else {
+      EnetServer::Options options;
+      options.maxPeers = maxPeers;
+      options.broadcastInterval = broadcastInterval;
+      options.snapshotEntities = snapshotEntities;
+      EnetServer server(address, options);
+      std::cout << "Server started on port " << server.port() << std::endl;
+      server.run();
     }
+  } catch (std::exception& e) {
+    std::cerr << "Server error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
   }
-
-  enet_host_destroy(server);
   return 0;
 }
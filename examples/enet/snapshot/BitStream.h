@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Bit-level packing of snapshot fields: a value takes exactly the bits it needs, not a whole byte.
+// Bits are written LSB first into a 64-bit scratch word which spills into the output a byte at a time.
+// USAGE EXAMPLE:
+// std::vector<uint8_t> bytes;
+// BitWriter writer(bytes);
+// writer.write(value, 18);
+// writer.flush();
+// BitReader reader(bytes);
+// uint32_t value = reader.read(18);
+// if (!reader.ok()) { ... }  // Read past the end
+class BitWriter {
+ public:
+  // Clears `out` and appends to it
+  explicit BitWriter(std::vector<uint8_t>& out) : out_(out) { out_.clear(); }
+
+  // Low `bits` bits of value, bits <= 32
+  void write(uint32_t value, unsigned bits) {
+    scratch_ |= (uint64_t{value} & ((uint64_t{1} << bits) - 1)) << scratchBits_;
+    scratchBits_ += bits;
+    bitCount_ += bits;
+    while (scratchBits_ >= 8) {
+      out_.push_back(static_cast<uint8_t>(scratch_));
+      scratch_ >>= 8;
+      scratchBits_ -= 8;
+    }
+  }
+
+  void writeBool(bool value) { write(value ? 1 : 0, 1); }
+
+  // Zigzag: small magnitudes of either sign get small codes
+  void writeSigned(int32_t value, unsigned bits) { write(zigzag(value), bits); }
+
+  // Appends the partial last byte. Call once, after the last write.
+  void flush() {
+    if (scratchBits_ > 0) out_.push_back(static_cast<uint8_t>(scratch_));
+    scratch_ = 0;
+    scratchBits_ = 0;
+  }
+
+  std::size_t bits() const { return bitCount_; }
+
+  static uint32_t zigzag(int32_t value) { return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31); }
+
+  // Whether the zigzag code of value fits in `bits` bits
+  static bool fits(int32_t value, unsigned bits) { return zigzag(value) < (uint32_t{1} << bits); }
+
+ private:
+  std::vector<uint8_t>& out_;
+  uint64_t scratch_ = 0;
+  unsigned scratchBits_ = 0;
+  std::size_t bitCount_ = 0;
+};
+
+// Reads what BitWriter wrote. Reading past the end returns zeros and clears ok(): the input comes from the network,
+// so the caller checks ok() once at the end instead of every read.
+class BitReader {
+ public:
+  explicit BitReader(std::span<const uint8_t> data) : data_(data) {}
+
+  uint32_t read(unsigned bits) {
+    while (scratchBits_ < bits) {
+      if (position_ == data_.size()) {
+        ok_ = false;
+        return 0;
+      }
+      scratch_ |= uint64_t{data_[position_++]} << scratchBits_;
+      scratchBits_ += 8;
+    }
+    const auto value = static_cast<uint32_t>(scratch_ & ((uint64_t{1} << bits) - 1));
+    scratch_ >>= bits;
+    scratchBits_ -= bits;
+    return value;
+  }
+
+  bool readBool() { return read(1) != 0; }
+
+  int32_t readSigned(unsigned bits) {
+    const uint32_t code = read(bits);
+    return static_cast<int32_t>(code >> 1) ^ -static_cast<int32_t>(code & 1);
+  }
+
+  bool ok() const { return ok_; }
+
+ private:
+  std::span<const uint8_t> data_;
+  std::size_t position_ = 0;
+  uint64_t scratch_ = 0;
+  unsigned scratchBits_ = 0;
+  bool ok_ = true;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "Snapshot.h"
+
+// Entities walking around a square arena: the replicated world of the snapshot demo and benchmark.
+// Moving entities walk straight and now and then turn, stationary ones only take damage. An entity which respawns
+// is missing from the snapshot of one tick and then appears somewhere else, so deltas carry removals and full
+// entities too.
+// USAGE EXAMPLE:
+// MovingEntities world({.count = 1000});
+// Snapshot snapshot;
+// world.step(1.0f / 60, tick, snapshot);
+class MovingEntities {
+ public:
+  struct Options {
+    std::size_t count = 1000;
+    double movingFraction = 1.0;
+    float speed = 5.0f;             // Meters per second
+    float arena = 500.0f;           // Half size, meters
+    double turnChance = 0.02;       // Per entity and tick
+    double damageChance = 0.005;    // Per entity and tick
+    double respawnChance = 0.0005;  // Per entity and tick
+    uint32_t seed = 1;
+  };
+
+  MovingEntities() : MovingEntities(Options{}) {}
+
+  // Throws std::invalid_argument for more entities than a snapshot can carry.
+  explicit MovingEntities(Options options) : options_(options), random_(options.seed) {
+    if (options_.count > SnapshotFormat::maxEntities) throw std::invalid_argument("Too many entities for a snapshot");
+    entities_.resize(options_.count);
+    for (std::size_t i = 0; i < entities_.size(); ++i) {
+      spawn(entities_[i]);
+      entities_[i].moving = static_cast<double>(i) < options_.movingFraction * entities_.size();
+    }
+  }
+
+  // Advances the world by dt seconds and writes its quantized state into `out`
+  void step(float dt, uint32_t tick, Snapshot& out) {
+    out.tick = tick;
+    out.entities.clear();
+    for (std::size_t i = 0; i < entities_.size(); ++i) {
+      Entity& entity = entities_[i];
+      if (entity.respawning) {
+        spawn(entity);
+      } else if (chance(options_.respawnChance)) {
+        entity.respawning = true;
+        continue;  // Gone for this tick
+      }
+
+      if (entity.moving) {
+        if (chance(options_.turnChance)) entity.heading = angle_(random_);
+        entity.x += std::cos(entity.heading) * options_.speed * dt;
+        entity.y += std::sin(entity.heading) * options_.speed * dt;
+        if (std::abs(entity.x) > options_.arena || std::abs(entity.y) > options_.arena) {  // Back into the arena
+          entity.x = std::clamp(entity.x, -options_.arena, options_.arena);
+          entity.y = std::clamp(entity.y, -options_.arena, options_.arena);
+          entity.heading += 3.14159265f;
+        }
+      }
+      if (chance(options_.damageChance)) entity.health = static_cast<uint8_t>(entity.health > 10 ? entity.health - 10 : 100);
+
+      EntityState state;
+      state.id = static_cast<uint16_t>(i);
+      state.x = SnapshotFormat::quantizePosition(entity.x);
+      state.y = SnapshotFormat::quantizePosition(entity.y);
+      state.z = SnapshotFormat::quantizePosition(entity.z);
+      state.yaw = SnapshotFormat::quantizeYaw(entity.heading);
+      state.health = entity.health;
+      out.entities.push_back(state);
+    }
+  }
+
+ private:
+  struct Entity {
+    float x = 0;
+    float y = 0;
+    float z = 0;
+    float heading = 0;
+    uint8_t health = 100;
+    bool moving = false;
+    bool respawning = false;
+  };
+
+  bool chance(double probability) { return probability > 0 && unit_(random_) < probability; }
+
+  void spawn(Entity& entity) {
+    std::uniform_real_distribution<float> position(-options_.arena, options_.arena);
+    entity.x = position(random_);
+    entity.y = position(random_);
+    entity.heading = angle_(random_);
+    entity.health = 100;
+    entity.respawning = false;
+  }
+
+  Options options_;
+  std::mt19937 random_;
+  std::uniform_real_distribution<double> unit_{0.0, 1.0};
+  std::uniform_real_distribution<float> angle_{0.0f, 6.28318531f};
+  std::vector<Entity> entities_;  // Index is the entity id
+};
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "BitStream.h"
+
+// Replicated state of one entity, already quantized: what the client sees is exactly what the server encoded.
+struct EntityState {
+  uint16_t id = 0;
+  int32_t x = 0;  // Position in SnapshotFormat::positionPerMeter steps
+  int32_t y = 0;
+  int32_t z = 0;
+  uint16_t yaw = 0;  // SnapshotFormat::yawBits steps per turn
+  uint8_t health = 0;
+
+  bool operator==(const EntityState&) const = default;
+};
+
+// State of the world at one server tick
+struct Snapshot {
+  uint32_t tick = 0;
+  std::vector<EntityState> entities;  // Sorted by id
+};
+
+// Wire format of snapshots and acks, see SnapshotCodec
+struct SnapshotFormat {
+  static constexpr unsigned tickBits = 32;
+  static constexpr unsigned baselineAgeBits = 8;  // A delta refers to a baseline up to 255 ticks older
+  static constexpr unsigned countBits = 16;
+  static constexpr unsigned idBits = 16;
+  static constexpr unsigned positionBits = 18;
+  static constexpr int32_t positionPerMeter = 64;  // 1.6 cm steps, ±2048 m
+  static constexpr int32_t positionOffset = 1 << (positionBits - 1);
+  static constexpr unsigned smallDeltaBits = 7;  // Position changes of up to 63 steps (~1 m) since the baseline
+  static constexpr unsigned yawBits = 10;
+  static constexpr unsigned healthBits = 8;
+  static constexpr std::size_t maxEntities = (std::size_t{1} << countBits) - 1;
+  static constexpr std::size_t maxBaselineAge = (std::size_t{1} << baselineAgeBits) - 1;
+  static constexpr std::size_t ackSize = 4;  // The acknowledged tick, little endian
+
+  static int32_t quantizePosition(float meters) {
+    const auto steps = static_cast<int32_t>(std::lround(meters * positionPerMeter));
+    return std::clamp(steps, -positionOffset, positionOffset - 1);
+  }
+
+  static float position(int32_t steps) { return static_cast<float>(steps) / positionPerMeter; }
+
+  static uint16_t quantizeYaw(float radians) {
+    constexpr float turn = 6.28318531f;
+    const float normalized = radians / turn - std::floor(radians / turn);  // [0, 1)
+    return static_cast<uint16_t>(std::lround(normalized * (1 << yawBits)) & ((1 << yawBits) - 1));
+  }
+
+  static void writeAck(uint32_t tick, uint8_t (&out)[ackSize]) {
+    for (std::size_t i = 0; i < ackSize; ++i) out[i] = static_cast<uint8_t>(tick >> (8 * i));
+  }
+
+  static bool readAck(std::span<const uint8_t> data, uint32_t& tick) {
+    if (data.size() != ackSize) return false;
+    tick = 0;
+    for (std::size_t i = 0; i < ackSize; ++i) tick |= uint32_t{data[i]} << (8 * i);
+    return true;
+  }
+};
+
+// Bit-packed snapshots: a full one, or the changes since a baseline snapshot both sides have.
+//
+// Header: tick, a delta bit, for a delta the age of the baseline in ticks, the entity count.
+// Then every entity of the snapshot in id order: its id (one bit when it follows the previous id), and
+// - in a full snapshot, or when the baseline doesn't have it: every field;
+// - otherwise a changed bit, and for a changed entity per position axis nothing / a small delta / the new value,
+//   then the yaw and the health, each a changed bit plus the new value.
+// An entity of the baseline which isn't listed is gone. An entity which didn't change costs 2 bits.
+// USAGE EXAMPLE:
+// std::vector<uint8_t> bytes;
+// SnapshotCodec::encode(current, &acknowledged, bytes);  // Server
+// Snapshot decoded;
+// if (!SnapshotCodec::decode(bytes, &baseline, decoded)) { ... }  // Client, baseline of header.baselineTick
+class SnapshotCodec {
+ public:
+  struct Header {
+    uint32_t tick = 0;
+    bool delta = false;
+    uint32_t baselineTick = 0;  // Delta only
+    std::size_t count = 0;
+  };
+
+  // Full snapshot if baseline is nullptr. A baseline must be 1 to maxBaselineAge ticks older than current.
+  // Throws std::invalid_argument for a snapshot the format can't carry.
+  static void encode(const Snapshot& current, const Snapshot* baseline, std::vector<uint8_t>& out) {
+    if (current.entities.size() > SnapshotFormat::maxEntities) throw std::invalid_argument("Too many entities in the snapshot");
+    if (baseline && (baseline->tick >= current.tick || current.tick - baseline->tick > SnapshotFormat::maxBaselineAge)) {
+      throw std::invalid_argument("The baseline must be 1 to 255 ticks older than the snapshot");
+    }
+
+    BitWriter writer(out);
+    writer.write(current.tick, SnapshotFormat::tickBits);
+    writer.writeBool(baseline != nullptr);
+    if (baseline) writer.write(current.tick - baseline->tick, SnapshotFormat::baselineAgeBits);
+    writer.write(static_cast<uint32_t>(current.entities.size()), SnapshotFormat::countBits);
+
+    std::size_t b = 0;  // Both lists are sorted by id: one merge pass finds the baseline state of every entity
+    int32_t previousId = -1;
+    for (const EntityState& entity : current.entities) {
+      if (entity.id <= previousId) throw std::invalid_argument("Snapshot entities must be sorted by id");
+      writeId(writer, entity.id, previousId);
+      previousId = entity.id;
+
+      if (baseline) {
+        while (b < baseline->entities.size() && baseline->entities[b].id < entity.id) ++b;
+        if (b < baseline->entities.size() && baseline->entities[b].id == entity.id) {
+          writeChanges(writer, baseline->entities[b], entity);
+          continue;
+        }
+      }
+      writeFields(writer, entity);
+    }
+    writer.flush();
+  }
+
+  static bool readHeader(std::span<const uint8_t> data, Header& header) {
+    BitReader reader(data);
+    return readHeader(reader, header);
+  }
+
+  // `baseline` must be the snapshot of header.baselineTick for a delta, it is ignored for a full snapshot.
+  // Returns false for malformed data or a wrong baseline, `out` is unspecified then.
+  static bool decode(std::span<const uint8_t> data, const Snapshot* baseline, Snapshot& out) {
+    BitReader reader(data);
+    Header header;
+    if (!readHeader(reader, header)) return false;
+    if (header.delta && (!baseline || baseline->tick != header.baselineTick)) return false;
+    if (!header.delta) baseline = nullptr;
+
+    out.tick = header.tick;
+    out.entities.clear();
+    out.entities.reserve(header.count);
+    std::size_t b = 0;
+    int32_t previousId = -1;
+    for (std::size_t i = 0; i < header.count && reader.ok(); ++i) {
+      EntityState entity;
+      entity.id = readId(reader, previousId);
+      if (entity.id <= previousId) return false;
+      previousId = entity.id;
+
+      bool found = false;
+      if (baseline) {
+        while (b < baseline->entities.size() && baseline->entities[b].id < entity.id) ++b;
+        found = b < baseline->entities.size() && baseline->entities[b].id == entity.id;
+      }
+      if (found) {
+        readChanges(reader, baseline->entities[b], entity);
+      } else {
+        readFields(reader, entity);
+      }
+      out.entities.push_back(entity);
+    }
+    return reader.ok();
+  }
+
+ private:
+  static bool readHeader(BitReader& reader, Header& header) {
+    header.tick = reader.read(SnapshotFormat::tickBits);
+    header.delta = reader.readBool();
+    if (header.delta) {
+      const uint32_t age = reader.read(SnapshotFormat::baselineAgeBits);
+      if (age == 0 || age > header.tick) return false;
+      header.baselineTick = header.tick - age;
+    }
+    header.count = reader.read(SnapshotFormat::countBits);
+    return reader.ok();
+  }
+
+  static void writeId(BitWriter& writer, uint16_t id, int32_t previousId) {
+    writer.writeBool(id == previousId + 1);
+    if (id != previousId + 1) writer.write(id, SnapshotFormat::idBits);
+  }
+
+  static uint16_t readId(BitReader& reader, int32_t previousId) {
+    if (reader.readBool()) return static_cast<uint16_t>(previousId + 1);
+    return static_cast<uint16_t>(reader.read(SnapshotFormat::idBits));
+  }
+
+  static void writePosition(BitWriter& writer, int32_t value) {
+    writer.write(static_cast<uint32_t>(value + SnapshotFormat::positionOffset), SnapshotFormat::positionBits);
+  }
+
+  static int32_t readPosition(BitReader& reader) {
+    return static_cast<int32_t>(reader.read(SnapshotFormat::positionBits)) - SnapshotFormat::positionOffset;
+  }
+
+  static void writeFields(BitWriter& writer, const EntityState& entity) {
+    writePosition(writer, entity.x);
+    writePosition(writer, entity.y);
+    writePosition(writer, entity.z);
+    writer.write(entity.yaw, SnapshotFormat::yawBits);
+    writer.write(entity.health, SnapshotFormat::healthBits);
+  }
+
+  static void readFields(BitReader& reader, EntityState& entity) {
+    entity.x = readPosition(reader);
+    entity.y = readPosition(reader);
+    entity.z = readPosition(reader);
+    entity.yaw = static_cast<uint16_t>(reader.read(SnapshotFormat::yawBits));
+    entity.health = static_cast<uint8_t>(reader.read(SnapshotFormat::healthBits));
+  }
+
+  static void writePositionChange(BitWriter& writer, int32_t base, int32_t value) {
+    const int32_t delta = value - base;
+    writer.writeBool(delta != 0);
+    if (delta == 0) return;
+    const bool small = BitWriter::fits(delta, SnapshotFormat::smallDeltaBits);
+    writer.writeBool(small);
+    if (small) {
+      writer.writeSigned(delta, SnapshotFormat::smallDeltaBits);
+    } else {
+      writePosition(writer, value);
+    }
+  }
+
+  static int32_t readPositionChange(BitReader& reader, int32_t base) {
+    if (!reader.readBool()) return base;
+    if (reader.readBool()) return base + reader.readSigned(SnapshotFormat::smallDeltaBits);
+    return readPosition(reader);
+  }
+
+  static void writeChanges(BitWriter& writer, const EntityState& base, const EntityState& entity) {
+    writer.writeBool(!(entity == base));
+    if (entity == base) return;
+    writePositionChange(writer, base.x, entity.x);
+    writePositionChange(writer, base.y, entity.y);
+    writePositionChange(writer, base.z, entity.z);
+    writer.writeBool(entity.yaw != base.yaw);
+    if (entity.yaw != base.yaw) writer.write(entity.yaw, SnapshotFormat::yawBits);
+    writer.writeBool(entity.health != base.health);
+    if (entity.health != base.health) writer.write(entity.health, SnapshotFormat::healthBits);
+  }
+
+  static void readChanges(BitReader& reader, const EntityState& base, EntityState& entity) {
+    const uint16_t id = entity.id;
+    entity = base;
+    entity.id = id;
+    if (!reader.readBool()) return;
+    entity.x = readPositionChange(reader, base.x);
+    entity.y = readPositionChange(reader, base.y);
+    entity.z = readPositionChange(reader, base.z);
+    if (reader.readBool()) entity.yaw = static_cast<uint16_t>(reader.read(SnapshotFormat::yawBits));
+    if (reader.readBool()) entity.health = static_cast<uint8_t>(reader.read(SnapshotFormat::healthBits));
+  }
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "Snapshot.h"
+
+// Client side of the snapshot replication: decodes full snapshots and deltas, keeps the recent snapshots as
+// baselines. After every decoded snapshot the client acknowledges latestTick() to the server.
+// A snapshot older than the latest one, or a delta against a baseline the client no longer has, is dropped:
+// the server falls back to an older baseline or to a full snapshot on its own, no request is needed.
+// USAGE EXAMPLE:
+// SnapshotReceiver receiver;
+// if (const Snapshot* snapshot = receiver.receive({event.packet->data, event.packet->dataLength})) {
+//   uint8_t ack[SnapshotFormat::ackSize];
+//   SnapshotFormat::writeAck(snapshot->tick, ack);
+//   enet_peer_send(peer, 1, enet_packet_create(ack, sizeof(ack), 0));
+// }
+class SnapshotReceiver {
+ public:
+  struct Options {
+    std::size_t historySize = 32;  // Snapshots kept as baselines, at least the historySize of the server
+  };
+
+  struct Stats {
+    uint64_t received = 0;
+    uint64_t decoded = 0;
+    uint64_t full = 0;
+    uint64_t stale = 0;            // Older than the latest snapshot
+    uint64_t missingBaseline = 0;  // Delta against a snapshot the client doesn't have
+    uint64_t malformed = 0;
+  };
+
+  SnapshotReceiver() : SnapshotReceiver(Options{}) {}
+
+  explicit SnapshotReceiver(Options options)
+      : history_(std::clamp<std::size_t>(options.historySize, 2, SnapshotFormat::maxBaselineAge + 1)), filled_(history_.size(), false) {}
+
+  // The decoded snapshot, valid until the snapshot historySize ticks later is received. nullptr if dropped.
+  const Snapshot* receive(std::span<const uint8_t> data) {
+    ++stats_.received;
+    SnapshotCodec::Header header;
+    if (!SnapshotCodec::readHeader(data, header)) {
+      ++stats_.malformed;
+      return nullptr;
+    }
+    if (decoded_ > 0 && header.tick <= latestTick_) {
+      ++stats_.stale;
+      return nullptr;
+    }
+    const Snapshot* baseline = nullptr;
+    if (header.delta && !(baseline = find(header.baselineTick))) {
+      ++stats_.missingBaseline;
+      return nullptr;
+    }
+    if (!SnapshotCodec::decode(data, baseline, scratch_)) {
+      ++stats_.malformed;
+      return nullptr;
+    }
+
+    // Decoded into scratch_ first: behind a server with a longer history the slot could hold the baseline.
+    // The swap keeps both allocations.
+    const std::size_t slot = header.tick % history_.size();
+    std::swap(history_[slot], scratch_);
+    filled_[slot] = true;
+    latestTick_ = header.tick;
+    ++decoded_;
+    ++stats_.decoded;
+    if (!header.delta) ++stats_.full;
+    return &history_[slot];
+  }
+
+  // Tick of the latest decoded snapshot: the one to acknowledge
+  uint32_t latestTick() const { return latestTick_; }
+
+  // The snapshot of the tick if the client still has it, or nullptr
+  const Snapshot* find(uint32_t tick) const {
+    const std::size_t slot = tick % history_.size();
+    return filled_[slot] && history_[slot].tick == tick ? &history_[slot] : nullptr;
+  }
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  std::vector<Snapshot> history_;  // By tick % size
+  std::vector<bool> filled_;
+  Snapshot scratch_;
+  uint64_t decoded_ = 0;
+  uint32_t latestTick_ = 0;
+  Stats stats_;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Snapshot.h"
+
+// Server side of the snapshot replication: the recent snapshots plus the newest tick every peer acknowledged.
+//
+// Every peer gets the changes since the last snapshot it acknowledged. Snapshots travel unreliable, so a lost one is
+// simply never acknowledged and the next delta refers to an older baseline. A peer without a usable baseline - new,
+// or nothing acknowledged for historySize ticks - gets full snapshots until it acknowledges one.
+// Peers which acknowledged the same tick share one encode per tick.
+// Not thread safe: call it from the thread which services the host.
+// USAGE EXAMPLE:
+// SnapshotReplicator replicator;
+// replicator.swapIn(snapshot);  // Every tick, `snapshot` comes back with an old one to refill
+// auto bytes = replicator.encodeFor(peer->incomingPeerID);
+// enet_peer_send(peer, 1, enet_packet_create(bytes.data(), bytes.size(), ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT));
+// replicator.acknowledge(event.peer->incomingPeerID, tick);  // For every ack packet, SnapshotFormat::readAck
+class SnapshotReplicator {
+ public:
+  struct Options {
+    std::size_t historySize = 32;  // Ticks kept as baselines, 2 to 256. Clients must keep at least as many.
+  };
+
+  struct Stats {
+    uint64_t full = 0;
+    uint64_t deltas = 0;
+    uint64_t bytes = 0;
+    uint64_t encodes = 0;  // Below full + deltas when peers share baselines
+  };
+
+  SnapshotReplicator() : SnapshotReplicator(Options{}) {}
+
+  explicit SnapshotReplicator(Options options)
+      : history_(std::clamp<std::size_t>(options.historySize, 2, SnapshotFormat::maxBaselineAge + 1)), deltas_(history_.size()) {}
+
+  // The snapshot of the next tick. Throws std::invalid_argument if its tick isn't newer than the latest one.
+  void push(Snapshot snapshot) { swapIn(snapshot); }
+
+  // push() without a copy: `snapshot` is swapped with the snapshot it replaces in the history and comes back holding
+  // that one, whose entity buffer the next tick refills without allocating.
+  void swapIn(Snapshot& snapshot) {
+    if (pushed_ > 0 && snapshot.tick <= latestTick_) throw std::invalid_argument("Snapshot ticks must increase");
+    if (pushed_ == 0) firstTick_ = snapshot.tick;
+    latestTick_ = snapshot.tick;
+    std::swap(history_[snapshot.tick % history_.size()], snapshot);
+    ++pushed_;
+    full_.valid = false;
+    for (auto& delta : deltas_) {
+      delta.valid = false;
+    }
+  }
+
+  const Snapshot& latest() const { return history_[latestTick_ % history_.size()]; }
+
+  // Payload of the latest snapshot for the peer: a delta against its acknowledged tick or a full snapshot.
+  // Valid until the next push(). Requires a push() before.
+  std::span<const uint8_t> encodeFor(std::size_t peer) {
+    const Snapshot* baseline = baselineOf(peer);
+    Encoding& encoding = baseline ? deltas_[latestTick_ - baseline->tick] : full_;
+    if (!encoding.valid) {
+      SnapshotCodec::encode(latest(), baseline, encoding.bytes);
+      encoding.valid = true;
+      ++stats_.encodes;
+    }
+    ++(baseline ? stats_.deltas : stats_.full);
+    stats_.bytes += encoding.bytes.size();
+    return encoding.bytes;
+  }
+
+  // The peer has the snapshot of `tick`. Ignores ticks which were never sent and acks older than the known one.
+  void acknowledge(std::size_t peer, uint32_t tick) {
+    if (pushed_ == 0 || tick < firstTick_ || tick > latestTick_) return;
+    PeerState& state = peerState(peer);
+    if (state.acknowledged && tick <= state.tick) return;
+    state.acknowledged = true;
+    state.tick = tick;
+  }
+
+  // Forgets what the peer acknowledged: on connect and disconnect of the peer slot
+  void resetPeer(std::size_t peer) { peerState(peer) = {}; }
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct PeerState {
+    bool acknowledged = false;
+    uint32_t tick = 0;
+  };
+
+  struct Encoding {
+    bool valid = false;
+    std::vector<uint8_t> bytes;
+  };
+
+  PeerState& peerState(std::size_t peer) {
+    if (peer >= peers_.size()) peers_.resize(peer + 1);
+    return peers_[peer];
+  }
+
+  // The acknowledged snapshot of the peer if it is still in the history, or nullptr
+  const Snapshot* baselineOf(std::size_t peer) {
+    const PeerState& state = peerState(peer);
+    if (!state.acknowledged) return nullptr;
+    const uint32_t age = latestTick_ - state.tick;
+    if (age == 0 || age >= history_.size()) return nullptr;
+    const Snapshot& baseline = history_[state.tick % history_.size()];
+    return baseline.tick == state.tick ? &baseline : nullptr;
+  }
+
+  std::vector<Snapshot> history_;  // By tick % size
+  uint64_t pushed_ = 0;
+  uint32_t firstTick_ = 0;
+  uint32_t latestTick_ = 0;
+  std::vector<PeerState> peers_;  // By peer slot
+  Encoding full_;
+  std::vector<Encoding> deltas_;  // Of the latest snapshot, by baseline age
+  Stats stats_;
+};
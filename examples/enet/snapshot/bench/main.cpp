@@ -0,0 +1,219 @@
+// Bandwidth of the snapshot replication: bytes per tick and peer for a world of moving entities.
+//
+// The server side (SnapshotReplicator) and `peers` clients (SnapshotReceiver) run in one thread over a simulated
+// link: every packet, snapshot or ack, is lost with probability `loss` and arrives half of `latency-ms` later.
+// No sockets: the numbers are payload bytes, ENet adds its headers (and fragments snapshots above the MTU).
+//
+// Modes:
+// - raw:   every entity as plain fields (id, float position and yaw, health: 19 bytes) plus the tick, every tick.
+//          The full state broadcast the clients got so far.
+// - full:  bit-packed full snapshot every tick, the clients never acknowledge.
+// - delta: bit-packed changes since the snapshot the peer acknowledged, full snapshots until the first ack and
+//          whenever no acknowledged snapshot is left in the history.
+// Every snapshot a client decodes is compared with the one of the server: `mismatches` must be 0.
+//
+// Reported per peer, after `warm-up` ticks: average and p99 bytes per tick, kbit/s at the tick rate, the share of full
+// snapshots, the snapshots a client received but couldn't use, and the server encode time per tick for all peers.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cxxopts.hpp"
+
+#include "../MovingEntities.h"
+#include "../Snapshot.h"
+#include "../SnapshotReceiver.h"
+#include "../SnapshotReplicator.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+  MovingEntities::Options world;
+  std::size_t peers = 16;
+  std::size_t ticks = 1200;
+  std::size_t warmUp = 60;
+  std::size_t tickRate = 60;
+  std::size_t latencyMs = 100;
+  std::size_t history = 32;
+};
+
+struct BenchResult {
+  double bytesPerTick = 0;
+  double p99BytesPerTick = 0;
+  double kbitPerSec = 0;
+  double fullShare = 0;  // Of the snapshots sent
+  uint64_t unusable = 0;
+  uint64_t mismatches = 0;
+  double encodeUsPerTick = 0;
+};
+
+// Plain encoding of the state: what a client gets without the snapshot subsystem
+constexpr std::size_t rawEntitySize = sizeof(uint16_t) + 3 * sizeof(float) + sizeof(float) + sizeof(uint8_t);
+
+struct InFlight {
+  std::size_t arrival = 0;  // Tick
+  std::vector<uint8_t> bytes;
+  uint32_t ack = 0;
+};
+
+struct Client {
+  SnapshotReceiver receiver;
+  std::deque<InFlight> snapshots;  // Server -> client
+  std::deque<InFlight> acks;       // Client -> server
+};
+
+BenchResult runOnce(const std::string& mode, double loss, const BenchConfig& config) {
+  const std::size_t oneWay = static_cast<std::size_t>(std::lround(config.latencyMs / 2.0 * config.tickRate / 1000.0));
+  const float dt = 1.0f / static_cast<float>(config.tickRate);
+  const bool raw = mode == "raw";
+  const bool acknowledge = mode == "delta";
+
+  MovingEntities world(config.world);
+  SnapshotReplicator replicator({config.history});
+  std::vector<Client> clients(config.peers);
+  for (auto& client : clients) {
+    client.receiver = SnapshotReceiver({config.history});
+  }
+  std::vector<Snapshot> sent(oneWay + 2);  // The server snapshots still in flight, by tick % size
+  std::mt19937 random(7);
+  std::bernoulli_distribution lost(loss);
+
+  std::vector<uint32_t> packetSizes;
+  uint64_t bytes = 0;
+  uint64_t packets = 0;
+  uint64_t fullAtWarmUp = 0;
+  Clock::duration encodeTime{0};
+  BenchResult result;
+  for (std::size_t tick = 1; tick <= config.ticks; ++tick) {
+    const bool measuring = tick > config.warmUp;
+    if (tick == config.warmUp + 1) fullAtWarmUp = replicator.stats().full;
+
+    for (std::size_t peer = 0; peer < clients.size(); ++peer) {
+      auto& acks = clients[peer].acks;
+      for (; !acks.empty() && acks.front().arrival <= tick; acks.pop_front()) {
+        replicator.acknowledge(peer, acks.front().ack);
+      }
+    }
+
+    Snapshot& snapshot = sent[tick % sent.size()];
+    world.step(dt, static_cast<uint32_t>(tick), snapshot);
+    replicator.push(snapshot);
+
+    const auto encodeStart = Clock::now();
+    for (std::size_t peer = 0; peer < clients.size(); ++peer) {
+      std::span<const uint8_t> payload;
+      std::size_t size = sizeof(uint32_t) + snapshot.entities.size() * rawEntitySize;
+      if (!raw) {
+        payload = replicator.encodeFor(peer);
+        size = payload.size();
+      }
+      if (measuring) {
+        packetSizes.push_back(static_cast<uint32_t>(size));
+        bytes += size;
+        ++packets;
+      }
+      if (!raw && !lost(random)) clients[peer].snapshots.push_back({tick + oneWay, {payload.begin(), payload.end()}, 0});
+    }
+    if (measuring) encodeTime += Clock::now() - encodeStart;
+
+    for (auto& client : clients) {
+      for (; !client.snapshots.empty() && client.snapshots.front().arrival <= tick; client.snapshots.pop_front()) {
+        const Snapshot* decoded = client.receiver.receive(client.snapshots.front().bytes);
+        if (!decoded) continue;
+        const Snapshot& expected = sent[decoded->tick % sent.size()];
+        if (expected.tick != decoded->tick || expected.entities != decoded->entities) ++result.mismatches;
+        if (acknowledge && !lost(random)) client.acks.push_back({tick + oneWay, {}, decoded->tick});
+      }
+    }
+  }
+
+  const std::size_t measuredTicks = config.ticks - std::min(config.warmUp, config.ticks);
+  if (packets == 0 || measuredTicks == 0) return result;
+  std::nth_element(packetSizes.begin(), packetSizes.begin() + packetSizes.size() * 99 / 100, packetSizes.end());
+  result.bytesPerTick = static_cast<double>(bytes) / packets;
+  result.p99BytesPerTick = packetSizes[packetSizes.size() * 99 / 100];
+  result.kbitPerSec = result.bytesPerTick * 8 * config.tickRate / 1000.0;
+  result.fullShare = raw ? 1.0 : static_cast<double>(replicator.stats().full - fullAtWarmUp) / packets;
+  for (auto& client : clients) {
+    const auto& stats = client.receiver.stats();
+    result.unusable += stats.stale + stats.missingBaseline + stats.malformed;
+  }
+  result.encodeUsPerTick = std::chrono::duration<double, std::micro>(encodeTime).count() / measuredTicks;
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "Snapshot replication bandwidth: raw state vs bit-packed full snapshots vs deltas");
+  // clang-format off
+  options.add_options()
+      ("m,modes", "Modes to compare: raw, full, delta", cxxopts::value<std::vector<std::string>>()->default_value("raw,full,delta"))
+      ("e,entities", "Entities in the world", cxxopts::value<std::size_t>()->default_value("1000"))
+      ("moving", "Share of moving entities, percent", cxxopts::value<std::size_t>()->default_value("100"))
+      ("speed", "Entity speed, meters per second", cxxopts::value<float>()->default_value("5"))
+      ("p,peers", "Clients", cxxopts::value<std::size_t>()->default_value("16"))
+      ("l,loss", "Packet loss in percent, list", cxxopts::value<std::vector<double>>()->default_value("0,1,5,20"))
+      ("latency-ms", "Round trip time", cxxopts::value<std::size_t>()->default_value("100"))
+      ("r,rate", "Ticks per second", cxxopts::value<std::size_t>()->default_value("60"))
+      ("t,ticks", "Simulated ticks", cxxopts::value<std::size_t>()->default_value("1200"))
+      ("w,warm-up", "Ticks not measured: the first ack takes a round trip", cxxopts::value<std::size_t>()->default_value("60"))
+      ("history", "Baselines kept by the server and the clients, ticks", cxxopts::value<std::size_t>()->default_value("32"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  BenchConfig config;
+  config.world.count = args["entities"].as<std::size_t>();
+  config.world.movingFraction = std::min<std::size_t>(100, args["moving"].as<std::size_t>()) / 100.0;
+  config.world.speed = args["speed"].as<float>();
+  config.peers = std::max<std::size_t>(1, args["peers"].as<std::size_t>());
+  config.latencyMs = args["latency-ms"].as<std::size_t>();
+  config.tickRate = std::max<std::size_t>(1, args["rate"].as<std::size_t>());
+  config.ticks = std::max<std::size_t>(1, args["ticks"].as<std::size_t>());
+  config.warmUp = args["warm-up"].as<std::size_t>();
+  config.history = args["history"].as<std::size_t>();
+
+  struct Row {
+    std::string mode;
+    double loss;
+    BenchResult result;
+  };
+  std::vector<Row> results;
+  try {
+    for (auto loss : args["loss"].as<std::vector<double>>()) {
+      for (auto& mode : args["modes"].as<std::vector<std::string>>()) {
+        std::cout << "Running " << mode << ", " << loss << "% loss..." << std::endl;
+        results.push_back({mode, loss, runOnce(mode, std::clamp(loss, 0.0, 100.0) / 100.0, config)});
+      }
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "\nentities=" << config.world.count << " moving=" << config.world.movingFraction * 100 << "% speed=" << config.world.speed
+            << " m/s peers=" << config.peers << " rate=" << config.tickRate << " Hz rtt=" << config.latencyMs << " ms history=" << config.history
+            << "\n\n";
+  std::cout << std::left << std::setw(7) << "mode" << std::setw(8) << "loss %" << std::setw(12) << "B/tick" << std::setw(14) << "p99 B/tick"
+            << std::setw(10) << "kbit/s" << std::setw(8) << "full %" << std::setw(10) << "unusable" << std::setw(12) << "mismatches"
+            << "encode us/tick" << std::endl;
+  for (auto& [mode, loss, r] : results) {
+    std::cout << std::left << std::setw(7) << mode << std::fixed << std::setprecision(1) << std::setw(8) << loss << std::setprecision(0)
+              << std::setw(12) << r.bytesPerTick << std::setw(14) << r.p99BytesPerTick << std::setw(10) << r.kbitPerSec << std::setprecision(1) << std::setw(8)
+              << r.fullShare * 100 << std::setw(10) << r.unusable << std::setw(12) << r.mismatches << r.encodeUsPerTick << std::endl;
+  }
+  return 0;
+}
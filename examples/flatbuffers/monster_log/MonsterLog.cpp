@@ -0,0 +1,145 @@
+#include "MonsterLog.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+namespace {
+
+[[noreturn]] void throwNotALog(const std::string& path) {
+  throw std::runtime_error("Not a Monster log: " + path);
+}
+
+}  // namespace
+
+MonsterLogWriter::MonsterLogWriter(const std::string& path) : path_(path) {
+  const std::string indexPath = MonsterLogFormat::indexPath(path);
+  std::error_code ec;
+  const bool exists = std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) > 0;
+
+  std::vector<uint64_t> missingOffsets;  // Records the index file doesn't list yet
+  if (exists) {
+    // The reader finds the complete records. It must be gone before the file is resized (Windows can't resize a
+    // mapped file).
+    MonsterLogReader reader(path);
+    end_ = reader.end();
+    records_ = reader.size();
+    for (std::size_t i = records_ - reader.scanned(); i < records_; ++i) {
+      missingOffsets.push_back(reader.offset(i));
+    }
+  }
+
+  // Cut off an incomplete record and index entries past the end of the log
+  if (exists) std::filesystem::resize_file(path, end_);
+  if (std::filesystem::exists(indexPath, ec)) {
+    std::filesystem::resize_file(indexPath, (records_ - missingOffsets.size()) * sizeof(uint64_t));
+  }
+
+  log_.open(path, std::ios::binary | std::ios::app);
+  index_.open(indexPath, std::ios::binary | std::ios::app);
+  if (!log_ || !index_) throw std::system_error(errno, std::generic_category(), "Can't open " + path);
+
+  if (!exists) {
+    uint8_t header[MonsterLogFormat::headerSize];
+    std::memcpy(header, MonsterLogFormat::magic, sizeof(MonsterLogFormat::magic));
+    flatbuffers::WriteScalar(header + sizeof(MonsterLogFormat::magic), MonsterLogFormat::version);
+    log_.write(reinterpret_cast<const char*>(header), sizeof(header));
+    end_ = sizeof(header);
+  }
+  index_.write(reinterpret_cast<const char*>(missingOffsets.data()), missingOffsets.size() * sizeof(uint64_t));
+  if (!log_ || !index_) throw std::runtime_error("Can't write " + path);
+}
+
+std::size_t MonsterLogWriter::append(std::span<const uint8_t> monsterBuffer) {
+  static constexpr char zeros[MonsterLogFormat::bufferAlignment] = {};
+
+  if (monsterBuffer.empty() || monsterBuffer.size() > FLATBUFFERS_MAX_BUFFER_SIZE) {
+    throw std::invalid_argument("Monster buffer of " + std::to_string(monsterBuffer.size()) + " bytes");
+  }
+
+  const uint64_t offset = MonsterLogFormat::recordOffset(end_);
+  uint8_t prefix[MonsterLogFormat::prefixSize];
+  flatbuffers::WriteScalar(prefix, static_cast<flatbuffers::uoffset_t>(monsterBuffer.size()));
+
+  log_.write(zeros, static_cast<std::streamsize>(offset - end_));
+  log_.write(reinterpret_cast<const char*>(prefix), sizeof(prefix));
+  log_.write(reinterpret_cast<const char*>(monsterBuffer.data()), static_cast<std::streamsize>(monsterBuffer.size()));
+  index_.write(reinterpret_cast<const char*>(&offset), sizeof(offset));  // After the record, see MonsterLogFormat
+  if (!log_ || !index_) throw std::runtime_error("Can't write " + path_);
+
+  end_ = offset + sizeof(prefix) + monsterBuffer.size();
+  return records_++;
+}
+
+void MonsterLogWriter::flush() {
+  log_.flush();
+  index_.flush();
+}
+
+MonsterLogReader::MonsterLogReader(const std::string& path) : file_(path) {
+  const uint8_t* data = file_.data();
+  if (file_.size() < MonsterLogFormat::headerSize || std::memcmp(data, MonsterLogFormat::magic, sizeof(MonsterLogFormat::magic)) != 0 ||
+      flatbuffers::ReadScalar<uint32_t>(data + sizeof(MonsterLogFormat::magic)) != MonsterLogFormat::version) {
+    throwNotALog(path);
+  }
+
+  // The index file, read in one go: 8 bytes per record, the log pages stay untouched
+  std::ifstream index(MonsterLogFormat::indexPath(path), std::ios::binary | std::ios::ate);
+  if (index) {
+    offsets_.resize(static_cast<std::size_t>(index.tellg()) / sizeof(uint64_t));
+    index.seekg(0);
+    index.read(reinterpret_cast<char*>(offsets_.data()), static_cast<std::streamsize>(offsets_.size() * sizeof(uint64_t)));
+    offsets_.resize(static_cast<std::size_t>(index.gcount()) / sizeof(uint64_t));
+  }
+
+  // The index is not trusted more than the log: from the first entry which can't be the offset of a record (not after
+  // the previous record, misaligned or past the end of the file) the records are found by scanning. Checked on the
+  // offsets only, the pages of the log stay untouched; record() checks the size prefixes. An entry which skips a record
+  // can't be told from the offsets: that record is not listed.
+  for (std::size_t i = 0; i < offsets_.size(); ++i) {
+    const uint64_t offset = offsets_[i];
+    const uint64_t first = i == 0 ? MonsterLogFormat::recordOffset(MonsterLogFormat::headerSize) : MonsterLogFormat::recordOffset(offsets_[i - 1] + MonsterLogFormat::prefixSize + 1);
+    if (offset < first || (offset + MonsterLogFormat::prefixSize) % MonsterLogFormat::bufferAlignment != 0 ||
+        offset > file_.size() - MonsterLogFormat::prefixSize) {
+      offsets_.resize(i);
+      break;
+    }
+  }
+
+  // Entries are written after their records, so only the last ones may point past the end of the log
+  while (!offsets_.empty() && recordEnd(offsets_.back()) == 0) {
+    offsets_.pop_back();
+  }
+  if (!offsets_.empty()) end_ = recordEnd(offsets_.back());
+
+  // Records the index doesn't list
+  for (uint64_t offset = MonsterLogFormat::recordOffset(end_), next; (next = recordEnd(offset)) != 0; offset = MonsterLogFormat::recordOffset(next)) {
+    offsets_.push_back(offset);
+    end_ = next;
+    ++scanned_;
+  }
+}
+
+uint64_t MonsterLogReader::recordEnd(uint64_t offset) const {
+  // Written so that no sum overflows: the offset may come from a corrupt index (the file holds at least the header)
+  if (offset < MonsterLogFormat::headerSize || offset > file_.size() - MonsterLogFormat::prefixSize) return 0;
+  const uint64_t size = flatbuffers::ReadScalar<flatbuffers::uoffset_t>(file_.data() + offset);
+  return size > 0 && size <= file_.size() - offset - MonsterLogFormat::prefixSize ? offset + MonsterLogFormat::prefixSize + size : 0;
+}
+
+std::span<const uint8_t> MonsterLogReader::record(std::size_t i) const {
+  // A size prefix reaching into the next record or past the end of the log: the index entry is wrong
+  const uint64_t end = recordEnd(offsets_[i]);
+  if (end == 0 || end > (i + 1 < offsets_.size() ? offsets_[i + 1] : end_)) return {};
+  const uint8_t* prefix = file_.data() + offsets_[i];
+  return {prefix + MonsterLogFormat::prefixSize, static_cast<std::size_t>(end - offsets_[i] - MonsterLogFormat::prefixSize)};
+}
+
+bool MonsterLogReader::verify(std::size_t i) const {
+  const auto buffer = record(i);
+  if (buffer.empty()) return false;
+  flatbuffers::Verifier verifier(buffer.data(), buffer.size());
+  return MyGame::Sample::VerifyMonsterBuffer(verifier);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../../MappedFile.h"
+#include "monster_generated.h"  // Already includes "flatbuffers/flatbuffers.h".
+
+// Append-only log of Monster FlatBuffers (../monster.fbs), read back through a memory mapping without copies.
+//
+// File layout: "MLOG" and a uint32_t version, then the records. A record is a size-prefixed FlatBuffer, the same
+// bytes FinishSizePrefixed produces: uint32_t size (little endian) followed by the Monster buffer. Zero padding
+// before a record keeps every Monster buffer 8-byte aligned in the file, so the Verifier's alignment checks pass
+// on the mapping.
+//
+// `<path>.idx` holds the file offset of every record (uint64_t, host byte order), appended by the writer. A reader
+// opens a log of any size without touching its pages and finds record i in O(1). Records without an index entry
+// (no index file, or the writer stopped between the two writes) are found by scanning the size prefixes. So are the
+// records from the first index entry which can't be the offset of a record (out of order, misaligned, past the end).
+// A record whose bytes are not all in the file is ignored by the reader and cut off by the next writer.
+struct MonsterLogFormat {
+  static constexpr char magic[4] = {'M', 'L', 'O', 'G'};
+  static constexpr uint32_t version = 1;
+  static constexpr std::size_t headerSize = sizeof(magic) + sizeof(version);
+  static constexpr std::size_t prefixSize = sizeof(flatbuffers::uoffset_t);
+  static constexpr std::size_t bufferAlignment = 8;
+
+  // Offset of the record which follows the `end` byte: its buffer, after the size prefix, is aligned
+  static uint64_t recordOffset(uint64_t end) {
+    return (end + prefixSize + bufferAlignment - 1) / bufferAlignment * bufferAlignment - prefixSize;
+  }
+
+  static std::string indexPath(const std::string& path) { return path + ".idx"; }
+};
+
+// Appends Monster buffers to the log. Not thread safe.
+// USAGE EXAMPLE:
+// MonsterLogWriter log("monsters.log");
+// log.append(frame);  // A received Monster frame is stored as is, no re-serialization
+class MonsterLogWriter {
+ public:
+  // Opens the log for appending, creates it if it doesn't exist. Throws std::runtime_error if the file is not a
+  // Monster log and std::system_error if it can't be opened.
+  explicit MonsterLogWriter(const std::string& path);
+
+  // Appends one finished Monster buffer (Finish, not FinishSizePrefixed). Returns the number of the record.
+  // Throws std::runtime_error if the write fails.
+  std::size_t append(std::span<const uint8_t> monsterBuffer);
+
+  std::size_t append(const flatbuffers::FlatBufferBuilder& builder) { return append({builder.GetBufferPointer(), builder.GetSize()}); }
+
+  // Hands the buffered records to the OS. Doesn't fsync.
+  void flush();
+
+  // Records in the log
+  std::size_t size() const { return records_; }
+
+  // File size after the last record
+  uint64_t end() const { return end_; }
+
+ private:
+  std::string path_;
+  std::ofstream log_;
+  std::ofstream index_;
+  uint64_t end_ = 0;
+  std::size_t records_ = 0;
+};
+
+// Maps the log and gives zero-copy access to every record. The records appended after the construction are not
+// visible, open a new reader to see them. Thread safe: every method is const.
+// USAGE EXAMPLE:
+// MonsterLogReader log("monsters.log");
+// for (std::size_t i = 0; i < log.size(); ++i) {
+//   auto monster = log.monster(i);  // Points into the mapping
+//   std::cout << monster->name()->str() << std::endl;
+// }
+class MonsterLogReader {
+ public:
+  // Throws std::runtime_error if the file is not a Monster log and std::system_error if it can't be mapped.
+  explicit MonsterLogReader(const std::string& path);
+
+  std::size_t size() const { return offsets_.size(); }
+
+  // The Monster buffer of record i, without the size prefix. Valid while the reader lives.
+  // Empty if the size prefix doesn't fit between the offset of the record and the next one (a corrupt index entry).
+  std::span<const uint8_t> record(std::size_t i) const;
+
+  // nullptr if record(i) is empty. The buffer itself is not checked: verify(i) first for logs from elsewhere.
+  const MyGame::Sample::Monster* monster(std::size_t i) const {
+    const auto buffer = record(i);
+    return buffer.empty() ? nullptr : MyGame::Sample::GetMonster(buffer.data());
+  }
+
+  // Runs flatbuffers::Verifier over record i. The log is not trusted more than a network peer.
+  bool verify(std::size_t i) const;
+
+  // File offset of the size prefix of record i
+  uint64_t offset(std::size_t i) const { return offsets_[i]; }
+
+  // File size after the last complete record
+  uint64_t end() const { return end_; }
+
+  // Records found by scanning because the index file didn't list them
+  std::size_t scanned() const { return scanned_; }
+
+ private:
+  // Returns the end of the record at `offset`, or 0 if the record is not complete
+  uint64_t recordEnd(uint64_t offset) const;
+
+  MappedFile file_;
+  std::vector<uint64_t> offsets_;
+  uint64_t end_ = MonsterLogFormat::headerSize;
+  std::size_t scanned_ = 0;
+};
@@ -0,0 +1,227 @@
+// Reading the Monster log back: memory mapping vs std::ifstream.
+//
+// The bench writes a log of `megabytes` Monster records (a few distinct Monsters, serialized once and appended as
+// received frames would be), then reads it:
+// - mmap:        MonsterLogReader, GetMonster right on the mapping, no copy.
+// - mmap+verify: the same, plus flatbuffers::Verifier for every record.
+// - stream:      std::ifstream, the size prefix and then the record into one reused std::vector, GetMonster on it.
+// Every mode reads a few fields of every Monster. Sequential scans report GB/s and ns per record (best of `passes`),
+// random reads of single records through the offset index report ns per lookup.
+//
+// The log was just written, so it is in the page cache: the numbers are the cost of the read path, not of the disk.
+// Drop the caches and run with --no-write to measure cold reads.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../MonsterLog.h"
+#include "cxxopts.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  double seconds = 0;
+  std::size_t records = 0;
+  uint64_t checksum = 0;
+};
+
+// Touches a few fields, like a consumer of the log would
+uint64_t consume(const MyGame::Sample::Monster* monster) {
+  return monster->hp() + monster->name()->size() + monster->inventory()->Get(9);
+}
+
+// Serializes the Monster of the flatbuffers sample with the given name
+void createMonster(flatbuffers::FlatBufferBuilder& builder, const std::string& monsterName) {
+  using namespace MyGame::Sample;
+  builder.Clear();
+  auto sword = CreateWeapon(builder, builder.CreateString("Sword"), 3);
+  auto axe = CreateWeapon(builder, builder.CreateString("Axe"), 5);
+  flatbuffers::Offset<Weapon> weapons_array[] = {sword, axe};
+  auto weapons = builder.CreateVector(weapons_array, 2);
+  auto position = Vec3(1.0f, 2.0f, 3.0f);
+  auto name = builder.CreateString(monsterName);
+  unsigned char inv_data[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  auto inventory = builder.CreateVector(inv_data, 10);
+  builder.Finish(CreateMonster(builder, &position, 150, 80, name, inventory, Color_Red, weapons, Equipment_Weapon, axe.Union()));
+}
+
+void writeLog(const std::string& path, std::size_t megabytes) {
+  std::filesystem::remove(path);
+  std::filesystem::remove(MonsterLogFormat::indexPath(path));
+
+  // Names of 1..64 characters, the frames are serialized once
+  std::vector<std::vector<uint8_t>> frames;
+  flatbuffers::FlatBufferBuilder builder;
+  for (std::size_t length = 1; length <= 64; length += 7) {
+    createMonster(builder, std::string(length, 'a' + static_cast<char>(length % 26)));
+    frames.emplace_back(builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize());
+  }
+
+  MonsterLogWriter log(path);
+  const auto start = Clock::now();
+  const uint64_t bytes = static_cast<uint64_t>(megabytes) * 1024 * 1024;
+  for (std::size_t i = 0; log.end() < bytes; ++i) {
+    log.append(frames[i % frames.size()]);
+  }
+  log.flush();
+  const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  std::cout << "Written " << log.size() << " records, " << log.end() / (1024 * 1024) << " MB in " << std::fixed << std::setprecision(2) << seconds
+            << " s (" << log.end() / seconds / 1e9 << " GB/s)" << std::endl;
+}
+
+Result scanMapped(const MonsterLogReader& log, bool verify) {
+  Result result;
+  const auto start = Clock::now();
+  for (std::size_t i = 0; i < log.size(); ++i) {
+    if (verify && !log.verify(i)) throw std::runtime_error("Record " + std::to_string(i) + " failed verification");
+    result.checksum += consume(log.monster(i));
+  }
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  result.records = log.size();
+  return result;
+}
+
+Result scanStream(const std::string& path) {
+  Result result;
+  const auto start = Clock::now();
+  std::ifstream file(path, std::ios::binary);
+  std::vector<uint8_t> buffer;  // Reused: the aligned copy of one record
+  uint64_t end = MonsterLogFormat::headerSize;
+  file.seekg(static_cast<std::streamoff>(end));
+  uint8_t prefix[MonsterLogFormat::prefixSize];
+  while (true) {
+    const uint64_t offset = MonsterLogFormat::recordOffset(end);
+    file.ignore(static_cast<std::streamsize>(offset - end));  // Padding
+    if (!file.read(reinterpret_cast<char*>(prefix), sizeof(prefix))) break;
+    buffer.resize(flatbuffers::ReadScalar<flatbuffers::uoffset_t>(prefix));
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()))) break;
+    result.checksum += consume(MyGame::Sample::GetMonster(buffer.data()));
+    ++result.records;
+    end = offset + sizeof(prefix) + buffer.size();
+  }
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return result;
+}
+
+// Reads `lookups` random records: through the mapping, or with seekg + read
+Result randomReads(const MonsterLogReader& log, const std::string& path, std::size_t lookups, bool mapped) {
+  std::mt19937_64 random(42);
+  std::uniform_int_distribution<std::size_t> pick(0, log.size() - 1);
+  std::ifstream file(path, std::ios::binary);
+  std::vector<uint8_t> buffer;
+
+  Result result;
+  const auto start = Clock::now();
+  for (std::size_t i = 0; i < lookups; ++i) {
+    const std::size_t n = pick(random);
+    if (mapped) {
+      result.checksum += consume(log.monster(n));
+      continue;
+    }
+    uint8_t prefix[MonsterLogFormat::prefixSize];
+    file.seekg(static_cast<std::streamoff>(log.offset(n)));
+    file.read(reinterpret_cast<char*>(prefix), sizeof(prefix));
+    buffer.resize(flatbuffers::ReadScalar<flatbuffers::uoffset_t>(prefix));
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    result.checksum += consume(MyGame::Sample::GetMonster(buffer.data()));
+  }
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  result.records = lookups;
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "Monster log: sequential scan and random reads, mmap vs std::ifstream");
+  const std::string defaultPath = (std::filesystem::temp_directory_path() / "monster_log_bench.log").string();
+  // clang-format off
+  options.add_options()
+      ("p,path", "Log file, its index is <path>.idx", cxxopts::value<std::string>()->default_value(defaultPath))
+      ("s,megabytes", "Log size to write", cxxopts::value<std::size_t>()->default_value("512"))
+      ("n,passes", "Sequential scans per mode, the best one is reported", cxxopts::value<std::size_t>()->default_value("3"))
+      ("r,random", "Random record reads per mode", cxxopts::value<std::size_t>()->default_value("1000000"))
+      ("no-write", "Read an existing log")
+      ("keep", "Don't delete the log at exit")
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  const std::string path = args["path"].as<std::string>();
+  const std::size_t passes = std::max<std::size_t>(1, args["passes"].as<std::size_t>());
+  const std::size_t lookups = args["random"].as<std::size_t>();
+
+  struct Row {
+    std::string mode;
+    Result result;
+  };
+  std::vector<Row> scans;
+  std::vector<Row> lookupsRows;
+  uint64_t logBytes = 0;
+  try {
+    if (!args.count("no-write")) writeLog(path, std::max<std::size_t>(1, args["megabytes"].as<std::size_t>()));
+
+    const auto openStart = Clock::now();
+    MonsterLogReader log(path);
+    const double openMs = std::chrono::duration<double, std::milli>(Clock::now() - openStart).count();
+    logBytes = log.end();
+    std::cout << "Opened " << log.size() << " records in " << std::fixed << std::setprecision(2) << openMs << " ms (" << log.scanned()
+              << " found by scanning, the rest through the index)" << std::endl;
+    if (log.size() == 0) throw std::runtime_error("The log is empty");
+
+    auto best = [passes](auto scan) {
+      Result result = scan();
+      for (std::size_t i = 1; i < passes; ++i) {
+        Result next = scan();
+        if (next.seconds < result.seconds) result = next;
+      }
+      return result;
+    };
+    scans.push_back({"mmap", best([&]() { return scanMapped(log, false); })});
+    scans.push_back({"mmap+verify", best([&]() { return scanMapped(log, true); })});
+    scans.push_back({"stream", best([&]() { return scanStream(path); })});
+
+    if (lookups > 0) {
+      lookupsRows.push_back({"mmap", randomReads(log, path, lookups, true)});
+      lookupsRows.push_back({"stream", randomReads(log, path, lookups, false)});
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  if (!args.count("keep") && !args.count("no-write")) {
+    std::filesystem::remove(path);
+    std::filesystem::remove(MonsterLogFormat::indexPath(path));
+  }
+
+  std::cout << "\nlog=" << logBytes / (1024 * 1024) << " MB passes=" << passes << "\n\n";
+  std::cout << std::left << std::setw(14) << "scan" << std::setw(10) << "GB/s" << std::setw(14) << "records/s" << std::setw(12) << "ns/record"
+            << "checksum" << std::endl;
+  for (auto& [mode, r] : scans) {
+    std::cout << std::left << std::setw(14) << mode << std::fixed << std::setprecision(2) << std::setw(10) << logBytes / r.seconds / 1e9
+              << std::setprecision(0) << std::setw(14) << r.records / r.seconds << std::setprecision(1) << std::setw(12)
+              << r.seconds * 1e9 / r.records << r.checksum << std::endl;
+  }
+
+  if (!lookupsRows.empty()) {
+    std::cout << "\n" << std::left << std::setw(14) << "random read" << std::setw(14) << "lookups/s" << std::setw(12) << "ns/lookup" << "checksum" << std::endl;
+    for (auto& [mode, r] : lookupsRows) {
+      std::cout << std::left << std::setw(14) << mode << std::fixed << std::setprecision(0) << std::setw(14) << r.records / r.seconds
+                << std::setprecision(1) << std::setw(12) << r.seconds * 1e9 / r.records << r.checksum << std::endl;
+    }
+  }
+  return 0;
+}
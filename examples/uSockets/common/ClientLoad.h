@@ -0,0 +1,255 @@
+#pragma once
+
+#include <libusockets.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../../LatencyHistogram.h"
+#include "WriteBuffer.h"
+
+struct ClientLoadOptions {
+  std::string host = "127.0.0.1";
+  int port = 0;
+  int ssl = 0;
+  std::string caFile;                    // TLS: verify the server with it, empty - no verification
+  std::vector<std::string> sourceHosts;  // Round robin per connection, empty - chosen by the kernel
+  std::size_t connections = 1;
+  std::size_t threads = 1;
+  std::chrono::steady_clock::time_point measureFrom;  // End of the warm-up, which includes the connection setup
+  std::chrono::steady_clock::time_point deadline;
+};
+
+// Base of the Client of ClientLoad: the counters every load tool has. Only touched by the thread of the client.
+struct ClientLoadThread {
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point measureFrom;  // Set by ClientLoad::run
+  Clock::time_point deadline;
+  bool stopping = false;  // Set at the deadline, before the connections are closed
+
+  LatencyHistogram latencies;
+  std::size_t connected = 0;
+  uint64_t errors = 0;  // Connections lost before the deadline, protocol errors
+  uint64_t connectErrors = 0;
+
+  bool measuring(Clock::time_point now) const { return now >= measureFrom && now < deadline; }
+
+  // Adds the counters of another thread, after the run
+  void merge(const ClientLoadThread& other) {
+    latencies.merge(other.latencies);
+    connected += other.connected;
+    errors += other.errors;
+    connectErrors += other.connectErrors;
+  }
+};
+
+// Client side of the load tools: `connections` connections over `threads` client threads, one uSockets loop each,
+// from the connect to the deadline. At the deadline the socket context of every loop is closed, with the sockets still
+// connecting, and the loops return. Every socket writes through a WriteBuffer flushed from on_writable, so TLS (where
+// nothing goes out before the handshake) and writes larger than the kernel takes work.
+// The protocol is a Client, one per thread, derived from ClientLoadThread:
+// - Client::Connection: the state of one connection;
+// - void onOpen(Connection&, WriteBuffer&): the connection is open, what is appended to the buffer is sent;
+// - void onData(Connection&, std::string_view data, WriteBuffer&): received bytes, the same for the writes.
+//   Throws for bytes it can't take: the connection is closed and counted as an error.
+// USAGE EXAMPLE:
+// struct PingClient : ClientLoadThread {
+//   struct Connection {};
+//   void onOpen(Connection&, WriteBuffer& writes) { writes.append("ping\n"); }
+//   void onData(Connection&, std::string_view data, WriteBuffer& writes) { ++replies; writes.append("ping\n"); }
+//   uint64_t replies = 0;
+// };
+// std::vector<PingClient> clients = ClientLoad<PingClient>::run(options, [](std::size_t thread) { return PingClient{}; });
+template <typename Client>
+class ClientLoad {
+ public:
+  // Runs the connections until the deadline, returns the clients with their counters.
+  // `makeClient(std::size_t thread)` returns the Client of a thread, called before any thread starts.
+  template <typename MakeClient>
+  static std::vector<Client> run(const ClientLoadOptions& options, MakeClient&& makeClient) {
+    const std::size_t connections = std::max<std::size_t>(1, options.connections);
+    const std::size_t threadCount = std::clamp<std::size_t>(options.threads, 1, connections);
+    std::vector<Thread> states;
+    states.reserve(threadCount);  // Sockets point to their Thread: no reallocation once they run
+    for (std::size_t i = 0; i < threadCount; ++i) {
+      states.push_back(Thread{&options, nullptr, makeClient(i)});
+      states.back().client.measureFrom = options.measureFrom;
+      states.back().client.deadline = options.deadline;
+    }
+
+    std::vector<std::thread> threads;
+    std::size_t first = 0;
+    for (std::size_t i = 0; i < threadCount; ++i) {
+      const std::size_t share = connections / threadCount + (i < connections % threadCount ? 1 : 0);
+      threads.emplace_back([&state = states[i], first, share]() {
+        if (state.options->ssl) {
+          runThread<1>(state, first, share);
+        } else {
+          runThread<0>(state, first, share);
+        }
+      });
+      first += share;
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    std::vector<Client> clients;
+    clients.reserve(threadCount);
+    for (auto& state : states) clients.push_back(std::move(state.client));
+    return clients;
+  }
+
+ private:
+  struct Thread {
+    const ClientLoadOptions* options;
+    us_socket_context_t* context;
+    Client client;
+  };
+
+  // One connection. Created in on_open, the socket ext holds the pointer (nullptr while connecting).
+  struct Socket {
+    Thread* thread;
+    WriteBuffer writes;
+    typename Client::Connection connection;
+  };
+
+  template <int SSL>
+  static Socket*& socketOf(us_socket_t* s) {
+    return *static_cast<Socket**>(us_socket_ext(SSL, s));
+  }
+
+  template <int SSL>
+  static Thread*& threadOf(us_socket_context_t* context) {
+    return *static_cast<Thread**>(us_socket_context_ext(SSL, context));
+  }
+
+  /* We don't need any of these */
+  static void onWakeup(us_loop_t* loop) {}
+
+  static void onPre(us_loop_t* loop) {}
+
+  static void onPost(us_loop_t* loop) {}
+
+  template <int SSL>
+  static us_socket_t* onOpen(us_socket_t* s, int is_client, char* ip, int ip_length) {
+    Thread& thread = *threadOf<SSL>(us_socket_context(SSL, s));
+    auto* socket = new Socket{&thread, {}, {}};
+    socketOf<SSL>(s) = socket;
+    ++thread.client.connected;
+    thread.client.onOpen(socket->connection, socket->writes);
+    socket->writes.flush(SSL, s);
+    return s;
+  }
+
+  template <int SSL>
+  static us_socket_t* onData(us_socket_t* s, char* data, int length) {
+    Socket& socket = *socketOf<SSL>(s);
+    try {
+      socket.thread->client.onData(socket.connection, {data, static_cast<std::size_t>(length)}, socket.writes);
+    } catch (std::exception&) {
+      ++socket.thread->client.errors;
+      return us_socket_close(SSL, s, 0, nullptr);
+    }
+    socket.writes.flush(SSL, s);
+    if (socket.writes.full()) return us_socket_close(SSL, s, 0, nullptr);  // The server doesn't read: on_close counts it
+    return s;
+  }
+
+  template <int SSL>
+  static us_socket_t* onWritable(us_socket_t* s) {
+    socketOf<SSL>(s)->writes.flush(SSL, s);
+    return s;
+  }
+
+  // Closing the context at the deadline also closes the sockets still connecting: they have no Socket
+  template <int SSL>
+  static us_socket_t* onClose(us_socket_t* s, int code, void* reason) {
+    Socket* socket = socketOf<SSL>(s);
+    if (!socket) return s;
+    if (!socket->thread->client.stopping) ++socket->thread->client.errors;
+    delete socket;
+    return s;
+  }
+
+  template <int SSL>
+  static us_socket_t* onEnd(us_socket_t* s) {
+    return us_socket_close(SSL, s, 0, nullptr);
+  }
+
+  template <int SSL>
+  static us_socket_t* onTimeout(us_socket_t* s) {
+    return s;
+  }
+
+  template <int SSL>
+  static us_socket_t* onConnectError(us_socket_t* s, int code) {
+    ++threadOf<SSL>(us_socket_context(SSL, s))->client.connectErrors;
+    return s;
+  }
+
+  // Closes every connection at the deadline: the loop has nothing left and us_loop_run returns
+  template <int SSL>
+  static void onDeadlineCheck(us_timer_t* timer) {
+    Thread& thread = **static_cast<Thread**>(us_timer_ext(timer));
+    if (ClientLoadThread::Clock::now() < thread.client.deadline) return;
+    thread.client.stopping = true;
+    us_socket_context_close(SSL, thread.context);
+    us_timer_close(timer);
+  }
+
+  // `first` - index of the first connection of the thread over all threads, for the round robin over the source hosts
+  template <int SSL>
+  static void runThread(Thread& thread, std::size_t first, std::size_t connections) {
+    const ClientLoadOptions& options = *thread.options;
+    us_loop_t* loop = us_create_loop(nullptr, onWakeup, onPre, onPost, 0);
+
+    us_socket_context_options_t contextOptions = {};
+    if (!options.caFile.empty()) contextOptions.ca_file_name = options.caFile.c_str();
+    thread.context = us_create_socket_context(SSL, loop, sizeof(Thread*), contextOptions);
+    if (!thread.context) {
+      std::cerr << "Could not create the socket context (CA file?)" << std::endl;
+      thread.client.connectErrors += connections;
+      us_loop_free(loop);
+      return;
+    }
+    threadOf<SSL>(thread.context) = &thread;
+
+    us_socket_context_on_open(SSL, thread.context, onOpen<SSL>);
+    us_socket_context_on_data(SSL, thread.context, onData<SSL>);
+    us_socket_context_on_writable(SSL, thread.context, onWritable<SSL>);
+    us_socket_context_on_close(SSL, thread.context, onClose<SSL>);
+    us_socket_context_on_timeout(SSL, thread.context, onTimeout<SSL>);
+    us_socket_context_on_end(SSL, thread.context, onEnd<SSL>);
+    us_socket_context_on_connect_error(SSL, thread.context, onConnectError<SSL>);
+
+    for (std::size_t i = first; i < first + connections; ++i) {
+      const char* source = options.sourceHosts.empty() ? nullptr : options.sourceHosts[i % options.sourceHosts.size()].c_str();
+      us_socket_t* s = us_socket_context_connect(SSL, thread.context, options.host.c_str(), options.port, source, 0, sizeof(Socket*));
+      if (s) {
+        socketOf<SSL>(s) = nullptr;  // Until on_open
+      } else {
+        ++thread.client.connectErrors;
+      }
+    }
+
+    us_timer_t* timer = us_create_timer(loop, 0, sizeof(Thread*));
+    *static_cast<Thread**>(us_timer_ext(timer)) = &thread;
+    us_timer_set(timer, onDeadlineCheck<SSL>, 50, 50);
+
+    us_loop_run(loop);
+
+    us_socket_context_free(SSL, thread.context);
+    us_loop_free(loop);
+  }
+};
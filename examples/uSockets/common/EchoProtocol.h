@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Requests and reply parsing of the echo benchmark. Two protocols cover every echo server of the examples:
+// - Tcp:       the payload as is, ending with '\n'. Byte stream servers (uSockets) echo it, newline framed servers
+//              (asio sync_tcp) see one message. A reply is the next `payload` bytes of the stream.
+// - WebSocket: an HTTP upgrade, then one masked binary frame per request. A reply is one data frame; pings are
+//              answered, other control frames are skipped.
+// USAGE EXAMPLE:
+// EchoProtocol protocol(EchoProtocol::Kind::Tcp, 64);
+// out += protocol.request();
+// bool upgradedNow;
+// std::size_t replies = protocol.consume(data, connection, out, upgradedNow);  // For every chunk of received bytes
+class EchoProtocol {
+ public:
+  enum class Kind { Tcp, WebSocket };
+
+  EchoProtocol(Kind kind, std::size_t payload) : kind_(kind), payload_(payload < 1 ? 1 : payload) {
+    std::string body(payload_, 'x');
+    body.back() = '\n';
+    request_ = kind_ == Kind::Tcp ? body : frame(0x2, body);
+  }
+
+  Kind kind() const { return kind_; }
+
+  std::size_t payload() const { return payload_; }
+
+  // Written before the first request: the upgrade request of a WebSocket, nothing for Tcp
+  std::string handshake(std::string_view host, int port) const {
+    if (kind_ == Kind::Tcp) return {};
+    return "GET / HTTP/1.1\r\n"
+           "Host: " + std::string(host) + ":" + std::to_string(port) + "\r\n"
+           "Upgrade: websocket\r\n"
+           "Connection: Upgrade\r\n"
+           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+           "Sec-WebSocket-Version: 13\r\n\r\n";
+  }
+
+  // One request, the same bytes every time: built once
+  const std::string& request() const { return request_; }
+
+  // Per connection parsing state
+  struct Connection {
+    bool upgraded = false;     // WebSocket: the 101 response was received
+    std::size_t received = 0;  // Tcp: bytes of the reply in progress
+    std::string pending;       // WebSocket: bytes of an incomplete response or frame
+  };
+
+  // Parses received bytes, returns the number of complete replies. Control frame answers are appended to `out`.
+  // `upgradedNow` is set when the WebSocket handshake completed in these bytes: the first requests may go out.
+  // Throws std::runtime_error for bytes which can't be a reply: the caller closes the connection.
+  std::size_t consume(std::string_view data, Connection& connection, std::string& out, bool& upgradedNow) const {
+    return consume(data, connection, out, upgradedNow, [](std::string_view /*payload*/) {});
+  }
+
+  // The same, `onMessage(std::string_view payload)` is called for every WebSocket data frame (not for Tcp):
+  // for clients of servers which push messages rather than echo them.
+  template <typename OnMessage>
+  std::size_t consume(std::string_view data, Connection& connection, std::string& out, bool& upgradedNow, OnMessage&& onMessage) const {
+    upgradedNow = false;
+    if (kind_ == Kind::Tcp) {
+      connection.received += data.size();
+      const std::size_t replies = connection.received / payload_;
+      connection.received %= payload_;
+      return replies;
+    }
+
+    std::string_view input = data;
+    if (!connection.pending.empty()) {  // Only a split frame or handshake is copied, the common case parses in place
+      connection.pending.append(data);
+      input = connection.pending;
+    }
+
+    std::size_t offset = 0;
+    if (!connection.upgraded) {
+      const std::size_t end = input.find("\r\n\r\n");
+      if (end == std::string_view::npos) {
+        keep(input, offset, connection);
+        return 0;
+      }
+      if (input.substr(0, 12) != "HTTP/1.1 101") throw std::runtime_error("WebSocket upgrade refused: " + std::string(input.substr(0, input.find('\r'))));
+      connection.upgraded = true;
+      upgradedNow = true;
+      offset = end + 4;
+    }
+
+    std::size_t replies = 0;
+    while (true) {
+      std::string_view frameData;
+      uint8_t opcode = 0;
+      const std::size_t size = parseFrame(input.substr(offset), opcode, frameData);
+      if (size == 0) break;
+      offset += size;
+      if (opcode == 0x1 || opcode == 0x2 || opcode == 0x0) {
+        ++replies;
+        onMessage(frameData);
+      } else if (opcode == 0x9) {
+        out += frame(0xA, frameData);  // Pong with the payload of the ping
+      } else if (opcode == 0x8) {
+        throw std::runtime_error("WebSocket closed by the server");
+      }
+    }
+    keep(input, offset, connection);
+    return replies;
+  }
+
+ private:
+  // Client frame: FIN, the opcode, the length, a zero mask key (the payload needs no XOR, servers accept any key)
+  static std::string frame(uint8_t opcode, std::string_view payload) {
+    std::string bytes;
+    bytes.push_back(static_cast<char>(0x80 | opcode));
+    if (payload.size() < 126) {
+      bytes.push_back(static_cast<char>(0x80 | payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+      bytes.push_back(static_cast<char>(0x80 | 126));
+      for (int shift = 8; shift >= 0; shift -= 8) bytes.push_back(static_cast<char>(payload.size() >> shift));
+    } else {
+      bytes.push_back(static_cast<char>(0x80 | 127));
+      for (int shift = 56; shift >= 0; shift -= 8) bytes.push_back(static_cast<char>(static_cast<uint64_t>(payload.size()) >> shift));
+    }
+    bytes.append(4, '\0');
+    bytes.append(payload);
+    return bytes;
+  }
+
+  // Size of the complete server frame at the start of `data`, 0 if it is incomplete
+  static std::size_t parseFrame(std::string_view data, uint8_t& opcode, std::string_view& payload) {
+    if (data.size() < 2) return 0;
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+    opcode = bytes[0] & 0x0F;
+    const bool masked = bytes[1] & 0x80;
+    uint64_t length = bytes[1] & 0x7F;
+    std::size_t header = 2;
+    if (length >= 126) {
+      const std::size_t extended = length == 126 ? 2 : 8;
+      if (data.size() < header + extended) return 0;
+      length = 0;
+      for (std::size_t i = 0; i < extended; ++i) length = (length << 8) | bytes[header + i];
+      header += extended;
+    }
+    if (masked) header += 4;  // Servers don't mask, tolerated anyway
+    if (data.size() < header + length) return 0;
+    payload = data.substr(header, static_cast<std::size_t>(length));
+    return header + static_cast<std::size_t>(length);
+  }
+
+  // Keeps the unparsed tail of `input` for the next call
+  static void keep(std::string_view input, std::size_t offset, Connection& connection) {
+    if (offset == input.size()) {
+      connection.pending.clear();
+    } else if (input.data() == connection.pending.data()) {
+      connection.pending.erase(0, offset);
+    } else {
+      connection.pending.assign(input.substr(offset));
+    }
+  }
+
+  Kind kind_;
+  std::size_t payload_;
+  std::string request_;
+};
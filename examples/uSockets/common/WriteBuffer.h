@@ -0,0 +1,74 @@
+#pragma once
+
+#include <libusockets.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Bytes a uSockets socket didn't take yet. us_socket_write doesn't buffer: it writes what the kernel accepts and
+// returns the count. With TLS it returns 0 until the handshake is done (the first write only starts the handshake),
+// and on_writable is called once writing can go on. A write whose result is ignored loses the rest of the data: a
+// TLS client which writes its first request in on_open and waits for the reply waits forever.
+// Keep one WriteBuffer per socket, write through it and flush it from on_writable.
+// A peer which doesn't read makes the bytes pile up: write() reports more than `limit` waiting, the caller closes the
+// socket. Written bytes are dropped from the front once they are half of the buffer, not only when it drained.
+// USAGE EXAMPLE:
+// us_socket_t* on_data(us_socket_t* s, char* data, int length) {
+//   if (!writeBufferOf(s).write(ssl, s, {data, static_cast<std::size_t>(length)})) return us_socket_close(ssl, s, 0, nullptr);
+//   return s;
+// }
+// us_socket_t* on_writable(us_socket_t* s) {
+//   writeBufferOf(s).flush(ssl, s);
+//   return s;
+// }
+class WriteBuffer {
+ public:
+  static constexpr std::size_t defaultLimit = 4 * 1024 * 1024;
+
+  WriteBuffer() = default;
+
+  explicit WriteBuffer(std::size_t limit) : limit_(limit) {}
+
+  // Writes the data after the bytes still waiting, keeps what the socket doesn't take.
+  // Returns false if more than the limit is left waiting: the peer doesn't read, close the socket.
+  bool write(int ssl, us_socket_t* s, std::string_view data) {
+    append(data);
+    flush(ssl, s);
+    return !full();
+  }
+
+  // Queues the data without writing: several appends go out with one flush
+  void append(std::string_view data) { buffer_.append(data); }
+
+  // Writes as much as the socket takes. Returns true if nothing is left.
+  bool flush(int ssl, us_socket_t* s) {
+    while (offset_ < buffer_.size()) {
+      const int written = us_socket_write(ssl, s, buffer_.data() + offset_, static_cast<int>(buffer_.size() - offset_), 0);
+      if (written <= 0) break;
+      offset_ += static_cast<std::size_t>(written);
+    }
+    if (offset_ == buffer_.size()) {
+      buffer_.clear();  // Keeps the capacity for the next writes
+      offset_ = 0;
+      return true;
+    }
+    if (offset_ > buffer_.size() / 2) {  // Moves less than was written: amortized O(1) per byte
+      buffer_.erase(0, offset_);
+      offset_ = 0;
+    }
+    return false;
+  }
+
+  std::size_t size() const { return buffer_.size() - offset_; }
+
+  bool empty() const { return size() == 0; }
+
+  // More than the limit is waiting
+  bool full() const { return size() > limit_; }
+
+ private:
+  std::string buffer_;
+  std::size_t offset_ = 0;  // Bytes of buffer_ already written
+  std::size_t limit_ = defaultLimit;
+};
@@ -0,0 +1,268 @@
+// Latency and throughput harness for the echo servers of the examples: uSockets, asio and uWebSockets.
+//
+// `threads` client threads run one uSockets loop each and share `connections` connections. Every connection keeps
+// `depth` requests of `payload` bytes in flight (pipelining): each reply immediately triggers the next request, so
+// this is a closed loop load and the latency includes the wait behind the requests ahead in the pipeline.
+// The connections, their writes and the deadline are ClientLoad (../common/ClientLoad.h), this file is the protocol.
+//
+// Replies are counted and their latency recorded (LatencyHistogram) from the end of the warm-up to the deadline;
+// the warm-up includes the connection setup. Every combination of the `connections`, `depth` and `payload` lists is
+// one run. The result goes to a table, and with --json as JSON to a file or stdout ("-").
+//
+// Servers, see README.md:
+//   uSockets tcp_no_ssl server / multi_loop_server: --port 12345
+//   asio sync_tcp server (newline framed):           --port 12345
+//   uWebSockets WebSocketEchoServer (wss):          --port 9001 --protocol ws --tls
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "cxxopts.hpp"
+
+#include "../common/ClientLoad.h"
+#include "../common/EchoProtocol.h"
+
+using Clock = std::chrono::steady_clock;
+
+int ssl = 0;  // Set once from --tls before the threads start
+
+struct BenchConfig {
+  std::string host = "127.0.0.1";
+  int port = 12345;
+  EchoProtocol::Kind protocol = EchoProtocol::Kind::Tcp;
+  std::string caFile;  // TLS: verify the server with it, empty - no verification
+  std::size_t threads = 2;
+  std::chrono::milliseconds warmUp{1000};
+  std::chrono::milliseconds duration{5000};
+};
+
+struct BenchResult {
+  std::size_t connections = 0;
+  std::size_t depth = 0;
+  std::size_t payload = 0;
+  std::size_t connected = 0;
+  double requestsPerSec = 0;
+  double megabytesPerSec = 0;  // Payload in one direction
+  double meanUs = 0;
+  double p50us = 0;
+  double p90us = 0;
+  double p99us = 0;
+  double p999us = 0;
+  double maxUs = 0;
+  uint64_t errors = 0;
+  uint64_t connectErrors = 0;
+};
+
+// One client thread: the echo protocol and its replies
+struct EchoClient : ClientLoadThread {
+  struct Connection {
+    EchoProtocol::Connection parser;
+    std::string control;                       // Answers to control frames, from the parser
+    std::vector<Clock::time_point> sendTimes;  // Replies come in request order: a ring of `depth`
+    uint64_t sent = 0;
+    uint64_t received = 0;
+  };
+
+  const BenchConfig* config = nullptr;
+  const EchoProtocol* protocol = nullptr;
+  std::size_t depth = 1;
+  uint64_t replies = 0;  // Inside the measurement window
+
+  void onOpen(Connection& connection, WriteBuffer& writes) {
+    connection.sendTimes.resize(depth);
+    writes.append(protocol->handshake(config->host, config->port));
+    if (writes.empty()) {  // Tcp: no handshake, the pipeline starts now
+      const auto now = Clock::now();
+      for (std::size_t i = 0; i < depth; ++i) sendRequest(connection, writes, now);
+    }
+  }
+
+  void onData(Connection& connection, std::string_view data, WriteBuffer& writes) {
+    bool upgradedNow = false;
+    const std::size_t count = protocol->consume(data, connection.parser, connection.control, upgradedNow);
+    writes.append(connection.control);
+    connection.control.clear();
+    const auto now = Clock::now();
+    if (upgradedNow) {
+      for (std::size_t i = 0; i < depth; ++i) sendRequest(connection, writes, now);
+    }
+    for (std::size_t i = 0; i < count && connection.received < connection.sent; ++i) {
+      const auto sendTime = connection.sendTimes[connection.received % connection.sendTimes.size()];
+      ++connection.received;
+      if (measuring(now)) {
+        ++replies;
+        // Requests sent during the warm-up may have waited for the connection setup
+        if (sendTime >= measureFrom) latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - sendTime).count());
+      }
+      if (now < deadline) sendRequest(connection, writes, now);
+    }
+  }
+
+  void sendRequest(Connection& connection, WriteBuffer& writes, Clock::time_point now) {
+    connection.sendTimes[connection.sent % connection.sendTimes.size()] = now;
+    writes.append(protocol->request());
+    ++connection.sent;
+  }
+};
+
+BenchResult runOnce(std::size_t connections, std::size_t depth, std::size_t payload, const BenchConfig& config) {
+  const EchoProtocol protocol(config.protocol, payload);
+  const auto measureFrom = Clock::now() + config.warmUp;  // Includes connection setup
+  const auto deadline = measureFrom + config.duration;
+
+  ClientLoadOptions load;
+  load.host = config.host;
+  load.port = config.port;
+  load.ssl = ssl;
+  load.caFile = config.caFile;
+  load.connections = connections;
+  load.threads = config.threads;
+  load.measureFrom = measureFrom;
+  load.deadline = deadline;
+  const auto clients = ClientLoad<EchoClient>::run(load, [&config, &protocol, depth](std::size_t /*thread*/) {
+    EchoClient client;
+    client.config = &config;
+    client.protocol = &protocol;
+    client.depth = depth;
+    return client;
+  });
+
+  BenchResult result;
+  result.connections = connections;
+  result.depth = depth;
+  result.payload = protocol.payload();
+  ClientLoadThread total;
+  uint64_t replies = 0;
+  for (auto& client : clients) {
+    total.merge(client);
+    replies += client.replies;
+  }
+  result.connected = total.connected;
+  result.errors = total.errors;
+  result.connectErrors = total.connectErrors;
+  const double seconds = std::chrono::duration<double>(config.duration).count();
+  result.requestsPerSec = replies / seconds;
+  result.megabytesPerSec = result.requestsPerSec * result.payload / (1024 * 1024);
+  result.meanUs = total.latencies.mean() / 1000.0;
+  result.p50us = total.latencies.percentile(50) / 1000.0;
+  result.p90us = total.latencies.percentile(90) / 1000.0;
+  result.p99us = total.latencies.percentile(99) / 1000.0;
+  result.p999us = total.latencies.percentile(99.9) / 1000.0;
+  result.maxUs = total.latencies.max() / 1000.0;
+  return result;
+}
+
+nlohmann::json toJson(const std::string& label, const BenchConfig& config, const std::vector<BenchResult>& results) {
+  nlohmann::json runs = nlohmann::json::array();
+  for (auto& r : results) {
+    runs.push_back({{"connections", r.connections},
+                    {"depth", r.depth},
+                    {"payload", r.payload},
+                    {"connected", r.connected},
+                    {"requestsPerSec", r.requestsPerSec},
+                    {"megabytesPerSec", r.megabytesPerSec},
+                    {"latencyUs", {{"mean", r.meanUs}, {"p50", r.p50us}, {"p90", r.p90us}, {"p99", r.p99us}, {"p99.9", r.p999us}, {"max", r.maxUs}}},
+                    {"errors", r.errors},
+                    {"connectErrors", r.connectErrors}});
+  }
+  return {{"label", label},
+          {"host", config.host},
+          {"port", config.port},
+          {"protocol", config.protocol == EchoProtocol::Kind::Tcp ? "tcp" : "ws"},
+          {"tls", ssl != 0},
+          {"threads", config.threads},
+          {"warmUpMs", config.warmUp.count()},
+          {"durationMs", config.duration.count()},
+          {"cores", std::thread::hardware_concurrency()},
+          {"runs", runs}};
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "Echo server benchmark: throughput and latency percentiles over uSockets clients");
+  // clang-format off
+  options.add_options()
+      ("host", "Server address", cxxopts::value<std::string>()->default_value("127.0.0.1"))
+      ("p,port", "Server port", cxxopts::value<int>()->default_value("12345"))
+      ("protocol", "tcp (raw or newline framed echo) or ws (WebSocket)", cxxopts::value<std::string>()->default_value("tcp"))
+      ("tls", "Connect with TLS")
+      ("ca", "TLS: CA file to verify the server with, none by default", cxxopts::value<std::string>()->default_value(""))
+      ("c,connections", "Connections, list", cxxopts::value<std::vector<std::size_t>>()->default_value("64"))
+      ("d,depth", "Requests in flight per connection, list", cxxopts::value<std::vector<std::size_t>>()->default_value("1,16"))
+      ("s,payload", "Request size in bytes, list", cxxopts::value<std::vector<std::size_t>>()->default_value("64"))
+      ("t,threads", "Client threads, one loop each", cxxopts::value<std::size_t>()->default_value("2"))
+      ("w,warm-up", "Warm-up in milliseconds, includes connection setup", cxxopts::value<std::size_t>()->default_value("1000"))
+      ("duration", "Measurement in milliseconds", cxxopts::value<std::size_t>()->default_value("5000"))
+      ("label", "Name of the server in the JSON output", cxxopts::value<std::string>()->default_value(""))
+      ("json", "Write the results as JSON to the file, - for stdout", cxxopts::value<std::string>()->default_value(""))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  BenchConfig config;
+  config.host = args["host"].as<std::string>();
+  config.port = args["port"].as<int>();
+  const std::string protocolName = args["protocol"].as<std::string>();
+  if (protocolName != "tcp" && protocolName != "ws") {
+    std::cerr << "Unknown protocol: " << protocolName << std::endl;
+    return 1;
+  }
+  config.protocol = protocolName == "ws" ? EchoProtocol::Kind::WebSocket : EchoProtocol::Kind::Tcp;
+  config.caFile = args["ca"].as<std::string>();
+  config.threads = std::max<std::size_t>(1, args["threads"].as<std::size_t>());
+  config.warmUp = std::chrono::milliseconds(args["warm-up"].as<std::size_t>());
+  config.duration = std::chrono::milliseconds(std::max<std::size_t>(1, args["duration"].as<std::size_t>()));
+  ssl = args.count("tls") ? 1 : 0;
+  const std::string json = args["json"].as<std::string>();
+  std::ostream& log = json == "-" ? std::cerr : std::cout;  // Keeps stdout pure JSON
+
+  std::vector<BenchResult> results;
+  for (auto connections : args["connections"].as<std::vector<std::size_t>>()) {
+    for (auto depth : args["depth"].as<std::vector<std::size_t>>()) {
+      for (auto payload : args["payload"].as<std::vector<std::size_t>>()) {
+        connections = std::max<std::size_t>(1, connections);
+        depth = std::max<std::size_t>(1, depth);
+        log << "Running " << connections << " connections x " << depth << " in flight, " << payload << " bytes..." << std::endl;
+        results.push_back(runOnce(connections, depth, payload, config));
+      }
+    }
+  }
+
+  log << "\n" << config.host << ":" << config.port << " protocol=" << protocolName << " tls=" << ssl << " threads=" << config.threads
+      << " cores=" << std::thread::hardware_concurrency() << "\n\n";
+  log << std::left << std::setw(13) << "connections" << std::setw(7) << "depth" << std::setw(9) << "payload" << std::setw(14) << "requests/s"
+      << std::setw(8) << "MB/s" << std::setw(10) << "p50 us" << std::setw(10) << "p90 us" << std::setw(10) << "p99 us" << std::setw(12)
+      << "p99.9 us" << std::setw(11) << "max us" << "errors" << std::endl;
+  for (auto& r : results) {
+    log << std::left << std::setw(13) << r.connections << std::setw(7) << r.depth << std::setw(9) << r.payload << std::fixed
+        << std::setprecision(0) << std::setw(14) << r.requestsPerSec << std::setprecision(1) << std::setw(8) << r.megabytesPerSec
+        << std::setw(10) << r.p50us << std::setw(10) << r.p90us << std::setw(10) << r.p99us << std::setw(12) << r.p999us << std::setw(11)
+        << r.maxUs << r.errors + r.connectErrors << (r.connected < r.connections ? " (not all connected)" : "") << std::endl;
+  }
+
+  if (!json.empty()) {
+    const auto document = toJson(args["label"].as<std::string>(), config, results);
+    if (json == "-") {
+      std::cout << document.dump(2) << std::endl;
+    } else {
+      std::ofstream(json) << document.dump(2) << std::endl;
+      log << "\nResults written to " << json << std::endl;
+    }
+  }
+  return 0;
+}
@@ -1,37 +1,13 @@
 #pragma once
 
 namespace Globals {
-constexpr int sslEnabled = 0;  // This example doesn't work with SSL, so we use '0'
+constexpr int sslEnabled = 0;  // 1 - TLS with server.crt / server.key (see README.md)
 constexpr int port = 12345;
 }  // namespace Globals
 
 /*
-Globals::sslEnabled = 0
-[CLIENT][DEBUG][74088] on_tcp_socket_open
-[CLIENT][DEBUG][74088] All connections established
-[CLIENT][DEBUG][74088] Running benchmark now...
-[CLIENT][DEBUG][74088] on_tcp_socket_data - A LOT OF THESE MESSAGES
-...
-[CLIENT][DEBUG][74088] on_tcp_socket_timeout
-[CLIENT][DEBUG][74088] Req/sec: 7756
-
-[SERVER][DEBUG][100632] Listening on port 12345
-[SERVER][DEBUG][100632] on_tcp_socket_open
-[SERVER][DEBUG][100632] Client connected. Total=1
-[SERVER][DEBUG][100632] on_tcp_socket_data
-[SERVER][DEBUG][100632] Received: Message for ping-pong
-
----
-
-Globals::sslEnabled = 1 - PROBLEM HERE ???
-[CLIENT][DEBUG][90688] on_tcp_socket_open
-[CLIENT][DEBUG][90688] All connections established
-[CLIENT][DEBUG][90688] Running benchmark now...
-[CLIENT][DEBUG][90688] on_tcp_socket_writable
-[CLIENT][DEBUG][90688] on_tcp_socket_timeout
-[CLIENT][DEBUG][90688] Req/sec: 0
-
-[SERVER][DEBUG][55796] Listening on port 12345
-[SERVER][DEBUG][55796] on_tcp_socket_open
-[SERVER][DEBUG][55796] Client connected. Total=1
-*/
\ No newline at end of file
+Globals::sslEnabled = 1 used to measure 0 req/sec: the client wrote its first request in on_open and ignored the
+result of us_socket_write. uSockets doesn't buffer writes, and before the TLS handshake is done a write only starts
+the handshake and returns 0. The request was lost, the server never replied, the client only got on_writable.
+Both sides now write through WriteBuffer and finish the writes in on_writable.
+*/
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <libusockets.h>
+#include <openssl/rand.h>
+#include <openssl/ssl.h>
+
+#include <cstdint>
+#include <stdexcept>
+
+// TLS session resumption for uSockets. uSockets creates the SSL_CTX of a TLS socket context and one SSL per socket,
+// but has no options for resumption: the native handles of the context and the socket give access to OpenSSL.
+//
+// Server: OpenSSL issues stateless session tickets by default, encrypted with keys random per SSL_CTX. Every loop of
+// a multi-loop server has its own context, so a ticket of one loop is useless on another: enableServerResumption
+// gives all contexts of the process the same keys.
+// Client: TlsSessionCache keeps the last ticket of the server and offers it in the ClientHello of new connections.
+// A resumed handshake skips the certificate and its signature: no RSA operation on the server, smaller messages.
+// Only for contexts created with ssl = 1.
+// USAGE EXAMPLE:
+// enableServerResumption(serverContext);
+//
+// TlsSessionCache sessions;  // Outlives the client context, used by its loop only
+// sessions.attach(clientContext);
+// us_socket_t* on_open(us_socket_t* s, ...) { sessions.resume(s); ... }    // Before the first write
+// us_socket_t* on_data(us_socket_t* s, ...) { TlsSessionCache::resumed(s); ... }
+
+// Process wide session ticket keys: name, HMAC key and AES key, 80 bytes since OpenSSL 1.1.0
+inline const unsigned char* ticketKeys() {
+  static unsigned char keys[80];
+  static const bool generated = RAND_bytes(keys, sizeof(keys)) == 1;
+  if (!generated) throw std::runtime_error("RAND_bytes failed");
+  return keys;
+}
+
+// Throws std::runtime_error if OpenSSL rejects the ticket keys.
+inline void enableServerResumption(us_socket_context_t* context) {
+  static const unsigned char sessionIdContext[] = "uSockets echo";
+  auto* sslContext = static_cast<SSL_CTX*>(us_socket_context_get_native_handle(1, context));
+  SSL_CTX_set_session_cache_mode(sslContext, SSL_SESS_CACHE_SERVER);
+  SSL_CTX_set_session_id_context(sslContext, sessionIdContext, sizeof(sessionIdContext) - 1);
+  if (SSL_CTX_set_tlsext_ticket_keys(sslContext, const_cast<unsigned char*>(ticketKeys()), 80) != 1) {
+    throw std::runtime_error("Failed to set the session ticket keys");
+  }
+}
+
+// Last session ticket of one client context. Not thread safe: used by the loop of the context.
+class TlsSessionCache {
+ public:
+  TlsSessionCache() = default;
+
+  TlsSessionCache(const TlsSessionCache&) = delete;
+
+  TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+  ~TlsSessionCache() {
+    if (session_) SSL_SESSION_free(session_);
+  }
+
+  // The context keeps a pointer to the cache: attach before connecting, free the context first.
+  void attach(us_socket_context_t* context) {
+    auto* sslContext = static_cast<SSL_CTX*>(us_socket_context_get_native_handle(1, context));
+    SSL_CTX_set_ex_data(sslContext, exIndex(), this);
+    // No internal store: the callback gets every ticket, OpenSSL keeps none
+    SSL_CTX_set_session_cache_mode(sslContext, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(sslContext, onNewSession);
+  }
+
+  // Offers the last ticket. Call in on_open of a client socket: the handshake starts with the first write.
+  // The socket gets a copy: OpenSSL marks the session of a connection closed without close_notify as not resumable.
+  void resume(us_socket_t* s) const {
+    if (!session_) return;
+    SSL_SESSION* copy = SSL_SESSION_dup(session_);
+    if (!copy) return;
+    SSL_set_session(static_cast<SSL*>(us_socket_get_native_handle(1, s)), copy);
+    SSL_SESSION_free(copy);  // The SSL holds its own reference
+  }
+
+  // True if the handshake of the socket resumed a session
+  static bool resumed(us_socket_t* s) { return SSL_session_reused(static_cast<SSL*>(us_socket_get_native_handle(1, s))) == 1; }
+
+  bool hasSession() const { return session_ != nullptr; }
+
+  uint64_t tickets() const { return tickets_; }
+
+ private:
+  static int exIndex() {
+    static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+  }
+
+  // TLS 1.3 servers send tickets after the handshake, a few per connection: the newest one is kept.
+  // `session` stays the session of the connection, uSockets closes it without close_notify: a copy is kept.
+  static int onNewSession(SSL* ssl, SSL_SESSION* session) {
+    auto* cache = static_cast<TlsSessionCache*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), exIndex()));
+    if (!cache || !SSL_SESSION_is_resumable(session)) return 0;
+    SSL_SESSION* copy = SSL_SESSION_dup(session);
+    if (!copy) return 0;
+    if (cache->session_) SSL_SESSION_free(cache->session_);
+    cache->session_ = copy;
+    ++cache->tickets_;
+    return 0;  // OpenSSL keeps its reference to `session`
+  }
+
+  SSL_SESSION* session_ = nullptr;
+  uint64_t tickets_ = 0;
+};
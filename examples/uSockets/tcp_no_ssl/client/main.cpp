@@ -2,18 +2,45 @@
 
 #include <libusockets.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
 
 #define DEBUG_LOG_DISABLE_DEBUG_LEVEL
 #define DEBUG_LOG_DISABLE_VERBOSE_LEVEL
 #define DEBUG_LOG_USER_PREFIX "[CLIENT]"
 #include "../../../DebugLog.h"
+#include "../../../PerThreadCounters.h"
 #include "../Globals.h"
+#include "../TlsSessions.h"
+#include "../../common/WriteBuffer.h"
 
 std::string host = "127.0.0.1";
 std::string clientRequestMsg = "Message for ping-pong";
-int numberOfConnections = 20;
-int responses;
+int numberOfConnections = 20;  // Of all threads
+int numberOfThreads = 1;
+
+// One loop per thread. The socket context of a loop carries a pointer to the state of its thread.
+struct alignas(cacheLineSize) ThreadState {
+  int connectionsToOpen = 0;
+  std::atomic<uint64_t> responses{0};  // Written by the thread only, read by the main thread
+  TlsSessionCache sessions;            // TLS: connections opened after the first handshake resume its session
+};
+
+ThreadState& stateOf(us_socket_t* s) {
+  return **static_cast<ThreadState**>(us_socket_context_ext(Globals::sslEnabled, us_socket_context(Globals::sslEnabled, s)));
+}
+
+// Every socket carries the bytes it didn't write yet: constructed in on_open, destroyed in on_close
+WriteBuffer& writeBufferOf(us_socket_t* s) {
+  return *static_cast<WriteBuffer*>(us_socket_ext(Globals::sslEnabled, s));
+}
 
 /* We don't need any of these */
 void on_wakeup(us_loop_t* loop) {
@@ -31,11 +58,13 @@ void on_post(us_loop_t* loop) {
 
 us_socket_t* on_tcp_socket_writable(us_socket_t* s) {
   debugLog() << "on_tcp_socket_writable" << std::endl;
+  writeBufferOf(s).flush(Globals::sslEnabled, s);  // TLS: the first request goes out once the handshake is done
   return s;
 }
 
 us_socket_t* on_tcp_socket_close(us_socket_t* s, int code, void* reason) {
   debugLog() << "on_tcp_socket_close" << std::endl;
+  writeBufferOf(s).~WriteBuffer();
   return s;
 }
 
@@ -46,26 +75,26 @@ us_socket_t* on_tcp_socket_end(us_socket_t* s) {
 
 us_socket_t* on_tcp_socket_data(us_socket_t* s, char* data, int length) {
   debugLog() << "on_tcp_socket_data" << std::endl;
-  us_socket_write(Globals::sslEnabled, s, clientRequestMsg.c_str(), clientRequestMsg.size(), 0);
-  responses++;
+  writeBufferOf(s).write(Globals::sslEnabled, s, clientRequestMsg);
+  add<uint64_t>(stateOf(s).responses, 1);
   return s;
 }
 
 us_socket_t* on_tcp_socket_open(us_socket_t* s, int is_client, char* ip, int ip_length) {
   debugLog() << "on_tcp_socket_open" << std::endl;
+  new (us_socket_ext(Globals::sslEnabled, s)) WriteBuffer;
+  if (Globals::sslEnabled) stateOf(s).sessions.resume(s);
+
   /* Send a request */
-  us_socket_write(Globals::sslEnabled, s, clientRequestMsg.c_str(), clientRequestMsg.size(), 0);
+  writeBufferOf(s).write(Globals::sslEnabled, s, clientRequestMsg);
 
-  if (--numberOfConnections) {
+  if (--stateOf(s).connectionsToOpen > 0) {
     // Initiate another connection
-    us_socket_context_connect(Globals::sslEnabled, us_socket_context(Globals::sslEnabled, s), host.c_str(), Globals::port, nullptr, 0, 0);
+    us_socket_context_connect(Globals::sslEnabled, us_socket_context(Globals::sslEnabled, s), host.c_str(), Globals::port, nullptr, 0, sizeof(WriteBuffer));
   } else {
-    debugLog() << "All connections established" << std::endl;
-    debugLog() << "Running benchmark now..." << std::endl;
+    debugLog() << "All connections of the thread established" << std::endl;
 
-    constexpr int seconds = LIBUS_TIMEOUT_GRANULARITY;  // 4 seconds
     constexpr int minutes = 1;
-    us_socket_timeout(Globals::sslEnabled, s, seconds);       // Start high-resolution frequency timeout (seconds)
     us_socket_long_timeout(Globals::sslEnabled, s, minutes);  // Start low-resolution frequency timeout (minutes)
   }
 
@@ -86,15 +115,6 @@ us_socket_t* on_tcp_socket_long_timeout(us_socket_t* s) {
 
 us_socket_t* on_tcp_socket_timeout(us_socket_t* s) {
   debugLog() << "on_tcp_socket_timeout" << std::endl;
-  /* Print current statistics */
-  constexpr int seconds = LIBUS_TIMEOUT_GRANULARITY;  // 4 seconds
-
-  std::cout << "Req/sec: " << (float)responses / seconds << std::endl;  // Show performance metrics
-
-  responses = 0;  // Reset statistics
-
-  us_socket_timeout(Globals::sslEnabled, s, seconds);  // Start high-resolution frequency timeout (seconds)
-
   return s;
 }
 
@@ -104,23 +124,8 @@ us_socket_t* on_tcp_socket_connect_error(us_socket_t* s, int code) {
   return s;
 }
 
-int main() {
-  // clang-format off
-  std::cout << "This is client-server benchmark for uSockets (TCP).\n"
-               "1. Client creates XXX TCP connections to server.\n"
-               "2. Client and server ping pong messages and calculate "
-               "average throughput in requests per second every 4 seconds. \n"
-               "\n"
-               "* Long timeout equals 1 minute is used for informing only.\n"
-               "** add `#define DISABLE_DEBUG_LOG` to disable debug logging to measure real throughput."
-               "You may use debugger to see how many requests are sent per second.\n"
-               "---\n"
-               "numberOfConnections=" << numberOfConnections << "\n"
-               "Globals::sslEnabled=" << Globals::sslEnabled << "\n"
-               "---\n"
-            << std::endl;
-  // clang-format on
-
+// Runs the connections of one thread until the process exits
+void runThread(ThreadState& state) {
   /* Create the event loop */
   us_loop_t* loop = us_create_loop(nullptr, on_wakeup, on_pre, on_post, 0);
 
@@ -128,12 +133,14 @@ int main() {
   us_socket_context_options_t options = {
       .ca_file_name = "server.crt"};
 
-  us_socket_context_t* tcp_context = us_create_socket_context(Globals::sslEnabled, loop, 0, options);
+  us_socket_context_t* tcp_context = us_create_socket_context(Globals::sslEnabled, loop, sizeof(ThreadState*), options);
 
   if (!tcp_context) {
     std::cerr << "Could not load SSL cert/key" << std::endl;
     exit(0);
   }
+  *static_cast<ThreadState**>(us_socket_context_ext(Globals::sslEnabled, tcp_context)) = &state;
+  if (Globals::sslEnabled) state.sessions.attach(tcp_context);
 
   /* Set up event handlers */
   us_socket_context_on_open(Globals::sslEnabled, tcp_context, on_tcp_socket_open);
@@ -146,7 +153,7 @@ int main() {
   us_socket_context_on_connect_error(Globals::sslEnabled, tcp_context, on_tcp_socket_connect_error);
 
   /* Start making HTTP connections */
-  if (!us_socket_context_connect(Globals::sslEnabled, tcp_context, host.c_str(), Globals::port, nullptr, 0, 0)) {
+  if (!us_socket_context_connect(Globals::sslEnabled, tcp_context, host.c_str(), Globals::port, nullptr, 0, sizeof(WriteBuffer))) {
     std::cerr << "Cannot connect to server" << std::endl;
   }
 
@@ -155,3 +162,51 @@ int main() {
   us_socket_context_free(Globals::sslEnabled, tcp_context);
   us_loop_free(loop);
 }
+
+// USAGE: uSockets_tcp_no_sll_client_minimalProject [numberOfConnections] [numberOfThreads]
+// The connections are spread over the threads, one event loop each. Against the multi-loop server use at least
+// a few connections per server loop: SO_REUSEPORT balances connections, not load.
+int main(int argc, char* argv[]) {
+  if (argc > 1) numberOfConnections = std::stoi(argv[1]);
+  if (argc > 2) numberOfThreads = std::stoi(argv[2]);
+  numberOfThreads = std::max(1, std::min(numberOfThreads, numberOfConnections));
+
+  // clang-format off
+  std::cout << "This is client-server benchmark for uSockets (TCP).\n"
+               "1. Client creates XXX TCP connections to server, spread over YYY threads.\n"
+               "2. Client and server ping pong messages and calculate "
+               "average throughput of all threads in requests per second every 4 seconds. \n"
+               "\n"
+               "* Long timeout equals 1 minute is used for informing only.\n"
+               "** add `#define DISABLE_DEBUG_LOG` to disable debug logging to measure real throughput."
+               "You may use debugger to see how many requests are sent per second.\n"
+               "---\n"
+               "numberOfConnections=" << numberOfConnections << "\n"
+               "numberOfThreads=" << numberOfThreads << "\n"
+               "Globals::sslEnabled=" << Globals::sslEnabled << "\n"
+               "---\n"
+            << std::endl;
+  // clang-format on
+
+  std::vector<ThreadState> states(numberOfThreads);
+  for (int i = 0; i < numberOfThreads; ++i) {
+    states[i].connectionsToOpen = numberOfConnections / numberOfThreads + (i < numberOfConnections % numberOfThreads ? 1 : 0);
+    std::thread([&state = states[i]]() { runThread(state); }).detach();  // The loops run until the process exits
+  }
+
+  // Aggregated statistics of all threads every LIBUS_TIMEOUT_GRANULARITY seconds
+  constexpr int seconds = LIBUS_TIMEOUT_GRANULARITY;  // 4 seconds
+  std::vector<uint64_t> lastResponses(numberOfThreads, 0);
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    uint64_t responses = 0;
+    std::string perThread;
+    for (int i = 0; i < numberOfThreads; ++i) {
+      const uint64_t threadResponses = states[i].responses.load(std::memory_order_relaxed);
+      responses += threadResponses - lastResponses[i];
+      perThread += " " + std::to_string((threadResponses - lastResponses[i]) / seconds);
+      lastResponses[i] = threadResponses;
+    }
+    std::cout << "Req/sec: " << (float)responses / seconds << " (per thread:" << perThread << ")" << std::endl;  // Show performance metrics
+  }
+}
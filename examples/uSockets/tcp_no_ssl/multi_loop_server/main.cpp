@@ -0,0 +1,175 @@
+// Echo server with one event loop per hardware thread, every loop listening on Globals::port.
+//
+// uSockets sets SO_REUSEPORT on its listen sockets (unless LIBUS_LISTEN_EXCLUSIVE_PORT is passed), so on Linux the
+// kernel spreads the incoming connections over the loops. A connection then stays on its loop and thread for good:
+// the loops share nothing, each one counts into its own LoopStats and the main thread only reads them.
+// Without SO_REUSEPORT (Windows) only the first loop gets the port, the others report it and exit.
+//
+// USAGE: uSockets_tcp_no_sll_multi_loop_server_minimalProject [loops]
+// By default one loop (and thread) per hardware thread is started.
+
+#include <libusockets.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define DEBUG_LOG_DISABLE_DEBUG_LEVEL
+#define DEBUG_LOG_DISABLE_VERBOSE_LEVEL
+#define DEBUG_LOG_USER_PREFIX "[SERVER]"
+#include "../../../DebugLog.h"
+#include "../../../PerThreadCounters.h"
+#include "../Globals.h"
+#include "../TlsSessions.h"
+#include "../../common/WriteBuffer.h"
+
+// Counters of one loop. Written by the thread of the loop only, read by the main thread.
+struct alignas(cacheLineSize) LoopStats {
+  std::atomic<int64_t> connections{0};
+  std::atomic<uint64_t> accepted{0};
+  std::atomic<uint64_t> echoes{0};
+  std::atomic<int> state{0};  // 0 - starting, 1 - listening, -1 - failed to listen
+};
+
+// The socket context of every loop carries a pointer to the stats of its loop
+LoopStats& statsOf(us_socket_t* s) {
+  return **static_cast<LoopStats**>(us_socket_context_ext(Globals::sslEnabled, us_socket_context(Globals::sslEnabled, s)));
+}
+
+// Every socket carries the bytes it didn't write yet: constructed in on_open, destroyed in on_close
+WriteBuffer& writeBufferOf(us_socket_t* s) {
+  return *static_cast<WriteBuffer*>(us_socket_ext(Globals::sslEnabled, s));
+}
+
+/* We don't need any of these */
+void on_wakeup(us_loop_t* loop) {}
+
+void on_pre(us_loop_t* loop) {}
+
+void on_post(us_loop_t* loop) {}
+
+us_socket_t* on_tcp_socket_writable(us_socket_t* s) {
+  writeBufferOf(s).flush(Globals::sslEnabled, s);
+  return s;
+}
+
+us_socket_t* on_tcp_socket_close(us_socket_t* s, int code, void* reason) {
+  debugLog() << "on_tcp_socket_close" << std::endl;
+  writeBufferOf(s).~WriteBuffer();
+  add<int64_t>(statsOf(s).connections, -1);
+  return s;
+}
+
+us_socket_t* on_tcp_socket_end(us_socket_t* s) {
+  us_socket_shutdown(Globals::sslEnabled, s);
+  return us_socket_close(Globals::sslEnabled, s, 0, nullptr);
+}
+
+us_socket_t* on_tcp_socket_data(us_socket_t* s, char* data, int length) {
+  if (!writeBufferOf(s).write(Globals::sslEnabled, s, {data, static_cast<std::size_t>(length)})) {
+    return us_socket_close(Globals::sslEnabled, s, 0, nullptr);  // Doesn't read its echoes
+  }
+  add<uint64_t>(statsOf(s).echoes, 1);
+  return s;
+}
+
+us_socket_t* on_tcp_socket_open(us_socket_t* s, int is_client, char* ip, int ip_length) {
+  debugLog() << "on_tcp_socket_open" << std::endl;
+  new (us_socket_ext(Globals::sslEnabled, s)) WriteBuffer;
+  LoopStats& stats = statsOf(s);
+  add<int64_t>(stats.connections, 1);
+  add<uint64_t>(stats.accepted, 1);
+  return s;
+}
+
+us_socket_t* on_tcp_socket_timeout(us_socket_t* s) {
+  return s;
+}
+
+// Runs in its own thread until the process exits
+void runLoop(LoopStats& stats) {
+  us_loop_t* loop = us_create_loop(nullptr, on_wakeup, on_pre, on_post, 0);  // No hint: a new loop, not the default one
+
+  us_socket_context_options_t options = {
+      .key_file_name = "server.key",
+      .cert_file_name = "server.crt",
+      .passphrase = "123Qwe!",
+  };
+  us_socket_context_t* tcp_context = us_create_socket_context(Globals::sslEnabled, loop, sizeof(LoopStats*), options);
+  if (!tcp_context) {
+    std::cerr << "Could not load Common::SSL cert/key" << std::endl;
+    stats.state = -1;
+    us_loop_free(loop);
+    return;
+  }
+  *static_cast<LoopStats**>(us_socket_context_ext(Globals::sslEnabled, tcp_context)) = &stats;
+  if (Globals::sslEnabled) enableServerResumption(tcp_context);  // The same ticket keys in every loop
+
+  us_socket_context_on_open(Globals::sslEnabled, tcp_context, on_tcp_socket_open);
+  us_socket_context_on_data(Globals::sslEnabled, tcp_context, on_tcp_socket_data);
+  us_socket_context_on_writable(Globals::sslEnabled, tcp_context, on_tcp_socket_writable);
+  us_socket_context_on_close(Globals::sslEnabled, tcp_context, on_tcp_socket_close);
+  us_socket_context_on_timeout(Globals::sslEnabled, tcp_context, on_tcp_socket_timeout);
+  us_socket_context_on_end(Globals::sslEnabled, tcp_context, on_tcp_socket_end);
+
+  // Options 0: SO_REUSEPORT, every loop gets its own listen socket on the same port
+  us_listen_socket_t* listen_socket = us_socket_context_listen(Globals::sslEnabled, tcp_context, nullptr, Globals::port, 0, sizeof(WriteBuffer));
+  if (!listen_socket) {
+    stats.state = -1;
+    us_socket_context_free(Globals::sslEnabled, tcp_context);
+    us_loop_free(loop);
+    return;
+  }
+  stats.state = 1;
+  us_loop_run(loop);
+}
+
+int main(int argc, char* argv[]) {
+  std::cout << "Globals::sslEnabled=" << Globals::sslEnabled << std::endl;
+
+  std::size_t loopCount = std::thread::hardware_concurrency();
+  if (argc > 1) loopCount = std::stoul(argv[1]);
+  if (loopCount == 0) loopCount = 1;
+
+  std::vector<LoopStats> stats(loopCount);
+  std::vector<std::thread> threads;
+  for (auto& loopStats : stats) {
+    threads.emplace_back([&loopStats]() { runLoop(loopStats); });
+    threads.back().detach();  // The loops run until the process exits
+  }
+
+  std::size_t listening = 0;
+  for (auto& loopStats : stats) {
+    while (loopStats.state == 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (loopStats.state == 1) ++listening;
+  }
+  if (listening == 0) {
+    std::cerr << "Failed to listen!" << std::endl;
+    return 1;
+  }
+  std::cout << "Listening on port " << Globals::port << " with " << listening << " of " << loopCount << " loop(s)" << std::endl;
+
+  // Aggregated statistics every LIBUS_TIMEOUT_GRANULARITY seconds, like the client
+  constexpr int seconds = LIBUS_TIMEOUT_GRANULARITY;
+  std::vector<uint64_t> lastEchoes(loopCount, 0);
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    int64_t connections = 0;
+    uint64_t echoes = 0;
+    std::string perLoop;
+    for (std::size_t i = 0; i < loopCount; ++i) {
+      const uint64_t loopEchoes = stats[i].echoes.load(std::memory_order_relaxed);
+      connections += stats[i].connections.load(std::memory_order_relaxed);
+      echoes += loopEchoes - lastEchoes[i];
+      perLoop += " " + std::to_string((loopEchoes - lastEchoes[i]) / seconds);
+      lastEchoes[i] = loopEchoes;
+    }
+    std::cout << "Connections: " << connections << " Echoes/sec: " << echoes / seconds << " (per loop:" << perLoop << ")" << std::endl;
+  }
+}
@@ -4,6 +4,7 @@
 
 #include <cassert>
 #include <iostream>
+#include <new>
 #include <string>
 
 #define DEBUG_LOG_DISABLE_DEBUG_LEVEL
@@ -11,9 +12,16 @@
 #define DEBUG_LOG_USER_PREFIX "[SERVER]"
 #include "../../../DebugLog.h"
 #include "../Globals.h"
+#include "../TlsSessions.h"
+#include "../../common/WriteBuffer.h"
 
 long long int clientCount = 0;
 
+// Every socket carries the bytes it didn't write yet: constructed in on_open, destroyed in on_close
+WriteBuffer& writeBufferOf(us_socket_t* s) {
+  return *static_cast<WriteBuffer*>(us_socket_ext(Globals::sslEnabled, s));
+}
+
 /* We don't need any of these */
 void on_wakeup(us_loop_t* loop) {
   verboseLog() << "on_wakeup" << std::endl;
@@ -30,11 +38,13 @@ void on_post(us_loop_t* loop) {
 
 us_socket_t* on_tcp_socket_writable(us_socket_t* s) {
   debugLog() << "on_tcp_socket_writable" << std::endl;
+  writeBufferOf(s).flush(Globals::sslEnabled, s);
   return s;
 }
 
 us_socket_t* on_tcp_socket_close(us_socket_t* s, int code, void* reason) {
   debugLog() << "on_tcp_socket_close" << std::endl;
+  writeBufferOf(s).~WriteBuffer();
   clientCount--;
   std::cout << "Client disconnected. Count=" << clientCount << std::endl;
   return s;
@@ -51,12 +61,16 @@ us_socket_t* on_tcp_socket_data(us_socket_t* s, char* data, int length) {
   debugLog() << "on_tcp_socket_data" << std::endl;
   std::string_view echo(data, length);
   debugLog() << "Received: " << echo << std::endl;
-  us_socket_write(Globals::sslEnabled, s, echo.data(), echo.size(), 0);
+  if (!writeBufferOf(s).write(Globals::sslEnabled, s, echo)) {
+    std::cout << "Client doesn't read its echoes, closing" << std::endl;
+    return us_socket_close(Globals::sslEnabled, s, 0, nullptr);
+  }
   return s;
 }
 
 us_socket_t* on_tcp_socket_open(us_socket_t* s, int is_client, char* ip, int ip_length) {
   debugLog() << "on_tcp_socket_open" << std::endl;
+  new (us_socket_ext(Globals::sslEnabled, s)) WriteBuffer;
   clientCount++;
   std::cout << "Client connected. Total=" << clientCount << std::endl;
   return s;
@@ -87,6 +101,8 @@ int main() {
     exit(0);
   }
 
+  if (Globals::sslEnabled) enableServerResumption(tcp_context);
+
   /* Set up event handlers */
   us_socket_context_on_open(Globals::sslEnabled, tcp_context, on_tcp_socket_open);
   us_socket_context_on_data(Globals::sslEnabled, tcp_context, on_tcp_socket_data);
@@ -96,7 +112,7 @@ int main() {
   us_socket_context_on_end(Globals::sslEnabled, tcp_context, on_tcp_socket_end);
 
   /* Start serving HTTP connections */
-  us_listen_socket_t* listen_socket = us_socket_context_listen(Globals::sslEnabled, tcp_context, nullptr, Globals::port, 0, 0);
+  us_listen_socket_t* listen_socket = us_socket_context_listen(Globals::sslEnabled, tcp_context, nullptr, Globals::port, 0, sizeof(WriteBuffer));
 
   if (listen_socket) {
     std::cout << "Listening on port " << Globals::port << std::endl;
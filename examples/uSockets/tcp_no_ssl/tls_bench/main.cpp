@@ -0,0 +1,483 @@
+// What TLS costs on uSockets: plaintext vs TLS vs TLS with session resumption.
+//
+// For every mode the echo server of the examples runs in-process (`server-loops` loops on one port, SO_REUSEPORT)
+// and two tests run against it from `threads` client loops, `connections` connections in total:
+// - handshake:  every connection connects, sends one request of `payload` bytes, waits for the echo and closes, then
+//               the next one is opened. Reported: connections per second and the latency from connect to the echo
+//               (TCP handshake, TLS handshake, one round trip). Closed with RST (SO_LINGER 0): otherwise TIME_WAIT
+//               runs the client out of ephemeral ports within seconds.
+// - throughput: persistent connections, one request in flight each. Reported: requests per second, MB/s, latency.
+// Modes:
+// - plain:      ssl = 0.
+// - tls:        a full TLS 1.3 handshake per connection: key exchange, the server signs with the RSA 2048 key of
+//               server.crt / server.key, the client verifies the certificate.
+// - tls-resume: the client offers the last session ticket of its loop (TlsSessionCache): no certificate, no RSA
+//               signature. The first connection of every client loop does a full handshake.
+// The throughput of tls and tls-resume is the same by design: resumption only changes the handshake.
+//
+// kTLS: OpenSSL moves the record encryption into the kernel only when its BIO is a socket. uSockets feeds OpenSSL
+// through its own memory BIO and does the socket I/O itself, so kTLS can't be enabled without changing uSockets;
+// the gap between plain and tls throughput is what it could win back.
+//
+// Run from the build directory: the server reads server.key / server.crt, the client verifies with server.crt.
+
+#include <libusockets.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
+
+#include "cxxopts.hpp"
+
+#define DEBUG_LOG_DISABLE_DEBUG_LEVEL
+#define DEBUG_LOG_DISABLE_VERBOSE_LEVEL
+#define DEBUG_LOG_USER_PREFIX "[BENCH]"
+#include "../../../DebugLog.h"
+#include "../../../LatencyHistogram.h"
+#include "../TlsSessions.h"
+#include "../../common/WriteBuffer.h"
+
+using Clock = std::chrono::steady_clock;
+
+int ssl = 0;  // Of the mode being measured, set before its threads start
+
+enum class Test { Handshake, Throughput };
+
+struct BenchConfig {
+  std::size_t connections = 64;
+  std::size_t threads = 2;
+  std::size_t serverLoops = 1;
+  std::size_t payload = 64;
+  std::chrono::milliseconds warmUp{500};
+  std::chrono::milliseconds duration{3000};
+};
+
+struct TestResult {
+  double perSec = 0;  // Connections (handshake) or requests (throughput)
+  double megabytesPerSec = 0;
+  double p50us = 0;
+  double p99us = 0;
+  double resumedPercent = 0;
+  uint64_t errors = 0;
+};
+
+// ------------------------------------------------------------------------------------------------------------------
+// Server: one loop per thread, every loop listens on the same port
+// ------------------------------------------------------------------------------------------------------------------
+
+struct ServerLoop {
+  us_loop_t* loop = nullptr;
+  us_socket_context_t* context = nullptr;
+  std::atomic<bool> stopping{false};
+  std::thread thread;
+};
+
+WriteBuffer& writeBufferOf(us_socket_t* s) {
+  return *static_cast<WriteBuffer*>(us_socket_ext(ssl, s));
+}
+
+/* We don't need any of these */
+void on_pre(us_loop_t* loop) {}
+
+void on_post(us_loop_t* loop) {}
+
+// stop() wakes the loop up: closing the context closes the listen socket and the connections, us_loop_run returns
+void on_server_wakeup(us_loop_t* loop) {
+  ServerLoop& server = **static_cast<ServerLoop**>(us_loop_ext(loop));
+  if (server.stopping && server.context) {
+    us_socket_context_close(ssl, server.context);
+  }
+}
+
+us_socket_t* on_server_open(us_socket_t* s, int is_client, char* ip, int ip_length) {
+  new (us_socket_ext(ssl, s)) WriteBuffer;
+  return s;
+}
+
+us_socket_t* on_server_data(us_socket_t* s, char* data, int length) {
+  if (!writeBufferOf(s).write(ssl, s, {data, static_cast<std::size_t>(length)})) return us_socket_close(ssl, s, 0, nullptr);
+  return s;
+}
+
+us_socket_t* on_server_writable(us_socket_t* s) {
+  writeBufferOf(s).flush(ssl, s);
+  return s;
+}
+
+us_socket_t* on_server_close(us_socket_t* s, int code, void* reason) {
+  writeBufferOf(s).~WriteBuffer();
+  return s;
+}
+
+us_socket_t* on_server_end(us_socket_t* s) {
+  return us_socket_close(ssl, s, 0, nullptr);
+}
+
+us_socket_t* on_server_timeout(us_socket_t* s) {
+  return s;
+}
+
+// Reports the port (0 - the first loop picks one) or -1 through `listening`, then serves until stopped
+void runServerLoop(ServerLoop& server, int port, std::promise<int>& listening) {
+  server.loop = us_create_loop(nullptr, on_server_wakeup, on_pre, on_post, sizeof(ServerLoop*));
+  *static_cast<ServerLoop**>(us_loop_ext(server.loop)) = &server;
+
+  us_socket_context_options_t options = {
+      .key_file_name = "server.key",
+      .cert_file_name = "server.crt",
+      .passphrase = "123Qwe!",
+  };
+  server.context = us_create_socket_context(ssl, server.loop, 0, options);
+  us_listen_socket_t* listenSocket = nullptr;
+  if (server.context) {
+    if (ssl) enableServerResumption(server.context);  // The same ticket keys in every loop
+    us_socket_context_on_open(ssl, server.context, on_server_open);
+    us_socket_context_on_data(ssl, server.context, on_server_data);
+    us_socket_context_on_writable(ssl, server.context, on_server_writable);
+    us_socket_context_on_close(ssl, server.context, on_server_close);
+    us_socket_context_on_end(ssl, server.context, on_server_end);
+    us_socket_context_on_timeout(ssl, server.context, on_server_timeout);
+    listenSocket = us_socket_context_listen(ssl, server.context, "127.0.0.1", port, 0, sizeof(WriteBuffer));
+  }
+  if (!listenSocket) {
+    std::cerr << (server.context ? "Failed to listen" : "Could not load server.key / server.crt") << std::endl;
+    if (server.context) us_socket_context_free(ssl, server.context);
+    server.context = nullptr;
+    us_loop_free(server.loop);
+    listening.set_value(-1);
+    return;
+  }
+  listening.set_value(us_socket_local_port(ssl, reinterpret_cast<us_socket_t*>(listenSocket)));
+
+  us_loop_run(server.loop);
+
+  us_socket_context_free(ssl, server.context);
+  us_loop_free(server.loop);
+}
+
+class EchoServer {
+ public:
+  // Throws std::runtime_error if a loop can't listen.
+  explicit EchoServer(std::size_t loops) {
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, loops); ++i) {
+      auto& server = *loops_.emplace_back(std::make_unique<ServerLoop>());
+      std::promise<int> listening;
+      auto listeningPort = listening.get_future();
+      server.thread = std::thread([&server, port = port_, listening = std::move(listening)]() mutable { runServerLoop(server, port, listening); });
+      const int loopPort = listeningPort.get();
+      if (loopPort < 0) {
+        server.thread.join();
+        loops_.pop_back();
+        stop();
+        throw std::runtime_error("Echo server failed to start");
+      }
+      port_ = loopPort;
+    }
+  }
+
+  EchoServer(const EchoServer&) = delete;
+
+  EchoServer& operator=(const EchoServer&) = delete;
+
+  ~EchoServer() { stop(); }
+
+  int port() const { return port_; }
+
+  void stop() {
+    for (auto& server : loops_) {
+      if (!server->thread.joinable()) continue;
+      server->stopping = true;
+      us_wakeup_loop(server->loop);
+      server->thread.join();
+    }
+  }
+
+ private:
+  std::vector<std::unique_ptr<ServerLoop>> loops_;
+  int port_ = 0;
+};
+
+// ------------------------------------------------------------------------------------------------------------------
+// Client: one loop per thread
+// ------------------------------------------------------------------------------------------------------------------
+
+// State of one client thread, only touched by that thread
+struct ClientThread {
+  Test test = Test::Handshake;
+  bool resume = false;
+  int port = 0;
+  const std::string* request = nullptr;
+  Clock::time_point measureFrom;
+  Clock::time_point deadline;
+  us_socket_context_t* context = nullptr;
+  TlsSessionCache sessions;
+
+  LatencyHistogram latencies;
+  uint64_t completed = 0;  // Handshakes or replies inside the measurement window
+  uint64_t resumed = 0;
+  uint64_t errors = 0;
+};
+
+// One connection, created with the connecting socket: the handshake latency starts there
+struct Connection {
+  ClientThread* thread = nullptr;
+  WriteBuffer writes;
+  Clock::time_point started;  // Of the connection (handshake) or of the request in flight (throughput)
+  std::size_t received = 0;   // Bytes of the reply in progress
+  bool done = false;          // Closed by the client after its last reply
+};
+
+Connection*& connectionOf(us_socket_t* s) {
+  return *static_cast<Connection**>(us_socket_ext(ssl, s));
+}
+
+ClientThread& clientOf(us_socket_context_t* context) {
+  return **static_cast<ClientThread**>(us_socket_context_ext(ssl, context));
+}
+
+void openConnection(ClientThread& thread) {
+  auto* connection = new Connection;
+  connection->thread = &thread;
+  connection->started = Clock::now();
+  us_socket_t* s = us_socket_context_connect(ssl, thread.context, "127.0.0.1", thread.port, nullptr, 0, sizeof(Connection*));
+  if (!s) {
+    ++thread.errors;
+    delete connection;
+    return;
+  }
+  connectionOf(s) = connection;
+}
+
+// RST instead of FIN: the client port doesn't wait in TIME_WAIT. With ssl = 0 the native handle is the descriptor,
+// a TLS socket starts with the plain one.
+us_socket_t* resetAndClose(us_socket_t* s) {
+  const auto fd = static_cast<LIBUS_SOCKET_DESCRIPTOR>(reinterpret_cast<uintptr_t>(us_socket_get_native_handle(0, s)));
+  linger noLinger{1, 0};
+  setsockopt(fd, SOL_SOCKET, SO_LINGER, reinterpret_cast<const char*>(&noLinger), sizeof(noLinger));
+  return us_socket_close(ssl, s, 0, nullptr);
+}
+
+void on_client_wakeup(us_loop_t* loop) {}
+
+us_socket_t* on_client_open(us_socket_t* s, int is_client, char* ip, int ip_length) {
+  Connection& connection = *connectionOf(s);
+  ClientThread& thread = *connection.thread;
+  if (ssl && thread.resume) thread.sessions.resume(s);  // Before the first write, which starts the handshake
+  us_socket_timeout(ssl, s, 10);                         // A lost reply ends the connection instead of the test
+  if (thread.test == Test::Throughput) connection.started = Clock::now();
+  connection.writes.write(ssl, s, *thread.request);
+  return s;
+}
+
+us_socket_t* on_client_data(us_socket_t* s, char* data, int length) {
+  Connection& connection = *connectionOf(s);
+  ClientThread& thread = *connection.thread;
+  const std::size_t payload = thread.request->size();
+  connection.received += static_cast<std::size_t>(length);
+  while (connection.received >= payload) {
+    connection.received -= payload;
+    const auto now = Clock::now();
+    if (connection.started >= thread.measureFrom && now < thread.deadline) {
+      ++thread.completed;
+      thread.latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - connection.started).count());
+      if (ssl && thread.test == Test::Handshake && TlsSessionCache::resumed(s)) ++thread.resumed;
+    }
+    if (thread.test == Test::Handshake || now >= thread.deadline) {
+      connection.done = true;
+      return thread.test == Test::Handshake ? resetAndClose(s) : us_socket_close(ssl, s, 0, nullptr);
+    }
+    connection.started = now;
+    connection.writes.write(ssl, s, *thread.request);
+  }
+  us_socket_timeout(ssl, s, 10);
+  return s;
+}
+
+us_socket_t* on_client_writable(us_socket_t* s) {
+  connectionOf(s)->writes.flush(ssl, s);
+  return s;
+}
+
+// Handshake test: the next connection replaces the closed one until the deadline
+us_socket_t* on_client_close(us_socket_t* s, int code, void* reason) {
+  Connection* connection = connectionOf(s);
+  ClientThread& thread = *connection->thread;
+  if (!connection->done) ++thread.errors;
+  delete connection;
+  if (thread.test == Test::Handshake && Clock::now() < thread.deadline) openConnection(thread);
+  return s;
+}
+
+us_socket_t* on_client_end(us_socket_t* s) {
+  return us_socket_close(ssl, s, 0, nullptr);
+}
+
+us_socket_t* on_client_timeout(us_socket_t* s) {
+  debugLog() << "No reply within 10 seconds" << std::endl;
+  return us_socket_close(ssl, s, 0, nullptr);
+}
+
+us_socket_t* on_client_connect_error(us_socket_t* s, int code) {
+  Connection* connection = connectionOf(s);
+  ClientThread& thread = *connection->thread;
+  ++thread.errors;
+  delete connection;
+  if (thread.test == Test::Handshake && Clock::now() < thread.deadline) openConnection(thread);
+  return s;
+}
+
+// The connections close themselves after the deadline: the loop runs out of sockets and us_loop_run returns
+void runClientThread(ClientThread& thread, std::size_t connections) {
+  us_loop_t* loop = us_create_loop(nullptr, on_client_wakeup, on_pre, on_post, 0);
+
+  us_socket_context_options_t options = {.ca_file_name = "server.crt"};
+  thread.context = us_create_socket_context(ssl, loop, sizeof(ClientThread*), options);
+  if (!thread.context) {
+    std::cerr << "Could not load server.crt" << std::endl;
+    thread.errors += connections;
+    us_loop_free(loop);
+    return;
+  }
+  *static_cast<ClientThread**>(us_socket_context_ext(ssl, thread.context)) = &thread;
+  if (ssl && thread.resume) thread.sessions.attach(thread.context);
+
+  us_socket_context_on_open(ssl, thread.context, on_client_open);
+  us_socket_context_on_data(ssl, thread.context, on_client_data);
+  us_socket_context_on_writable(ssl, thread.context, on_client_writable);
+  us_socket_context_on_close(ssl, thread.context, on_client_close);
+  us_socket_context_on_end(ssl, thread.context, on_client_end);
+  us_socket_context_on_timeout(ssl, thread.context, on_client_timeout);
+  us_socket_context_on_connect_error(ssl, thread.context, on_client_connect_error);
+
+  for (std::size_t i = 0; i < connections; ++i) {
+    openConnection(thread);
+  }
+
+  us_loop_run(loop);
+
+  us_socket_context_free(ssl, thread.context);
+  us_loop_free(loop);
+}
+
+TestResult runTest(Test test, bool resume, int port, const BenchConfig& config) {
+  const std::string request(config.payload, 'x');
+  const auto measureFrom = Clock::now() + config.warmUp;
+  const auto deadline = measureFrom + config.duration;
+
+  const std::size_t threadCount = std::clamp<std::size_t>(config.threads, 1, config.connections);
+  std::vector<ClientThread> states(threadCount);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < threadCount; ++i) {
+    ClientThread& state = states[i];
+    state.test = test;
+    state.resume = resume;
+    state.port = port;
+    state.request = &request;
+    state.measureFrom = measureFrom;
+    state.deadline = deadline;
+    const std::size_t share = config.connections / threadCount + (i < config.connections % threadCount ? 1 : 0);
+    threads.emplace_back([&state, share]() { runClientThread(state, share); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  TestResult result;
+  LatencyHistogram latencies;
+  uint64_t completed = 0;
+  uint64_t resumed = 0;
+  for (auto& state : states) {
+    latencies.merge(state.latencies);
+    completed += state.completed;
+    resumed += state.resumed;
+    result.errors += state.errors;
+  }
+  result.perSec = completed / std::chrono::duration<double>(config.duration).count();
+  result.megabytesPerSec = result.perSec * config.payload / (1024 * 1024);
+  result.p50us = latencies.percentile(50) / 1000.0;
+  result.p99us = latencies.percentile(99) / 1000.0;
+  result.resumedPercent = completed ? 100.0 * resumed / completed : 0;
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "uSockets echo: plaintext vs TLS vs TLS with session resumption");
+  // clang-format off
+  options.add_options()
+      ("m,modes", "Modes to compare: plain, tls, tls-resume", cxxopts::value<std::vector<std::string>>()->default_value("plain,tls,tls-resume"))
+      ("c,connections", "Concurrent connections", cxxopts::value<std::size_t>()->default_value("64"))
+      ("t,threads", "Client threads, one loop each", cxxopts::value<std::size_t>()->default_value("2"))
+      ("server-loops", "Server loops (threads) on the port", cxxopts::value<std::size_t>()->default_value("1"))
+      ("s,payload", "Request size in bytes", cxxopts::value<std::size_t>()->default_value("64"))
+      ("w,warm-up", "Warm-up per test in milliseconds", cxxopts::value<std::size_t>()->default_value("500"))
+      ("d,duration", "Measurement per test in milliseconds", cxxopts::value<std::size_t>()->default_value("3000"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  BenchConfig config;
+  config.connections = std::max<std::size_t>(1, args["connections"].as<std::size_t>());
+  config.threads = std::max<std::size_t>(1, args["threads"].as<std::size_t>());
+  config.serverLoops = std::max<std::size_t>(1, args["server-loops"].as<std::size_t>());
+  config.payload = std::max<std::size_t>(1, args["payload"].as<std::size_t>());
+  config.warmUp = std::chrono::milliseconds(args["warm-up"].as<std::size_t>());
+  config.duration = std::chrono::milliseconds(std::max<std::size_t>(1, args["duration"].as<std::size_t>()));
+
+  struct Row {
+    std::string mode;
+    TestResult handshake;
+    TestResult throughput;
+  };
+  std::vector<Row> rows;
+  try {
+    for (auto& mode : args["modes"].as<std::vector<std::string>>()) {
+      if (mode != "plain" && mode != "tls" && mode != "tls-resume") throw std::invalid_argument("Unknown mode: " + mode);
+      ssl = mode == "plain" ? 0 : 1;
+      const bool resume = mode == "tls-resume";
+
+      EchoServer server(config.serverLoops);
+      std::cout << "Running " << mode << ": handshakes..." << std::endl;
+      Row row{mode};
+      row.handshake = runTest(Test::Handshake, resume, server.port(), config);
+      std::cout << "Running " << mode << ": throughput..." << std::endl;
+      row.throughput = runTest(Test::Throughput, resume, server.port(), config);
+      rows.push_back(row);
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "\nconnections=" << config.connections << " client threads=" << config.threads << " server loops=" << config.serverLoops
+            << " payload=" << config.payload << " cores=" << std::thread::hardware_concurrency() << "\n\n";
+  std::cout << std::left << std::setw(12) << "mode" << std::setw(14) << "handshakes/s" << std::setw(10) << "resumed" << std::setw(10)
+            << "p50 us" << std::setw(10) << "p99 us" << std::setw(14) << "requests/s" << std::setw(8) << "MB/s" << std::setw(10) << "p50 us"
+            << std::setw(10) << "p99 us" << "errors" << std::endl;
+  for (auto& [mode, h, t] : rows) {
+    std::cout << std::left << std::setw(12) << mode << std::fixed << std::setprecision(0) << std::setw(14) << h.perSec << std::setw(10)
+              << (mode == "plain" ? "-" : std::to_string(static_cast<int>(h.resumedPercent)) + "%") << std::setprecision(1)
+              << std::setw(10) << h.p50us << std::setw(10) << h.p99us << std::setprecision(0) << std::setw(14) << t.perSec
+              << std::setprecision(1) << std::setw(8) << t.megabytesPerSec << std::setw(10) << t.p50us << std::setw(10) << t.p99us
+              << h.errors + t.errors << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include "../../MappedFile.h"
+#include "App.h"
+
+// Sends `body` without copying it into uWS: tryEnd writes what the socket takes, the rest goes out from onWritable
+// straight from `body`, which must outlive the response. res->end(body) would copy the unsent rest into the buffer
+// of the socket, a full copy of a large file for every slow client.
+// With TLS every byte is encrypted from `body` into the TLS record buffer of uSockets (it runs OpenSSL over its own
+// memory BIO): sendfile or kTLS can't be used under it, this is the zero copy uWS allows.
+template <bool SSL>
+void sendBody(uWS::HttpResponse<SSL>* res, std::string_view body) {
+  auto [ok, done] = res->tryEnd(body, body.size());
+  if (done) return;
+  res->onWritable([res, body](uint64_t offset) {
+       auto [ok, done] = res->tryEnd(body.substr(offset), body.size());
+       return ok;
+     })
+      ->onAborted([]() {});  // Nothing to free: `body` belongs to the cache
+}
+
+// In-memory response cache for the static files of a directory, loaded once at construction:
+// - bodies are memory mapped (MappedFile): pages are shared with the page cache, no heap copy;
+// - the header values (Content-Type, ETag, Cache-Control) are computed once, a response only writes them;
+// - ETag from the content (FNV-1a 64), `If-None-Match` answers 304 without a body;
+// - pre-gzipped variants: `file.gz` next to `file` (gzip -k file) is served to clients accepting gzip. This build has
+//   no zlib: the variants are compressed ahead of time, never per request.
+// Files changed or added later are not seen: construct the cache again. Only paths of loaded files are served, the
+// URL never reaches the filesystem.
+// USAGE EXAMPLE:
+// StaticFileCache cache("public");  // Outlives the App
+// app.get("/*", [&cache](auto* res, auto* req) { cache.serve(res, req); });
+class StaticFileCache {
+ public:
+  struct Options {
+    std::size_t maxFileSize = 256 * 1024 * 1024;  // Larger files are not served
+    std::string cacheControl = "public, max-age=60";
+    std::string index = "index.html";  // Served for "/" and "/dir/"
+  };
+
+  explicit StaticFileCache(const std::string& root) : StaticFileCache(root, Options{}) {}
+
+  // Throws std::runtime_error if `root` is not a directory, std::system_error if a file can't be mapped.
+  StaticFileCache(const std::string& root, Options options) : options_(std::move(options)) {
+    namespace fs = std::filesystem;
+    if (!fs::is_directory(root)) throw std::runtime_error("Not a directory: " + root);
+    for (auto& item : fs::recursive_directory_iterator(root)) {
+      if (!item.is_regular_file() || item.file_size() > options_.maxFileSize) continue;
+      const fs::path& path = item.path();
+      const std::string url = "/" + fs::relative(path, root).generic_string();
+      if (path.extension() == ".gz" && fs::is_regular_file(fs::path(path).replace_extension())) continue;  // A variant
+
+      Entry entry;
+      entry.contentType = contentType(url);
+      entry.plain = load(path.string(), "");
+      fs::path gzipPath = path;
+      gzipPath += ".gz";
+      if (fs::is_regular_file(gzipPath) && fs::file_size(gzipPath) <= options_.maxFileSize) {
+        entry.gzip = load(gzipPath.string(), "-gzip");
+        ++gzipCount_;
+      }
+      bytes_ += entry.plain.body.size();
+      files_.emplace(url, std::move(entry));
+    }
+  }
+
+  std::size_t fileCount() const { return files_.size(); }
+
+  std::size_t gzipCount() const { return gzipCount_; }
+
+  uint64_t bytes() const { return bytes_; }
+
+  // ETag of the plain variant, empty if the path is not cached
+  std::string_view etag(std::string_view url) const {
+    auto it = files_.find(url);
+    return it == files_.end() ? std::string_view() : std::string_view(it->second.plain.etag);
+  }
+
+  // GET handler: 200 with the body, 304 if If-None-Match has the ETag, 404 for unknown paths
+  template <bool SSL>
+  void serve(uWS::HttpResponse<SSL>* res, uWS::HttpRequest* req) const {
+    const Entry* entry = find(req->getUrl());
+    if (!entry) {
+      res->writeStatus("404 Not Found")->end("Not found");
+      return;
+    }
+    const bool gzip = entry->gzip && acceptsGzip(req->getHeader("accept-encoding"));
+    const Variant& variant = gzip ? *entry->gzip : entry->plain;
+
+    if (etagMatches(req->getHeader("if-none-match"), variant.etag)) {
+      res->writeStatus("304 Not Modified")->writeHeader("ETag", variant.etag)->writeHeader("Cache-Control", options_.cacheControl);
+      if (entry->gzip) res->writeHeader("Vary", "Accept-Encoding");
+      res->endWithoutBody();
+      return;
+    }
+
+    res->writeHeader("Content-Type", entry->contentType)->writeHeader("ETag", variant.etag)->writeHeader("Cache-Control", options_.cacheControl);
+    if (entry->gzip) res->writeHeader("Vary", "Accept-Encoding");
+    if (gzip) res->writeHeader("Content-Encoding", "gzip");
+    sendBody(res, {reinterpret_cast<const char*>(variant.body.data()), variant.body.size()});
+  }
+
+  static std::string_view contentType(std::string_view path) {
+    static const std::pair<std::string_view, std::string_view> types[] = {
+        {".html", "text/html; charset=utf-8"}, {".css", "text/css; charset=utf-8"}, {".js", "text/javascript; charset=utf-8"},
+        {".json", "application/json"},         {".txt", "text/plain; charset=utf-8"}, {".svg", "image/svg+xml"},
+        {".png", "image/png"},                 {".jpg", "image/jpeg"},                {".ico", "image/x-icon"},
+        {".wasm", "application/wasm"}};
+    for (auto& [extension, type] : types) {
+      if (path.ends_with(extension)) return type;
+    }
+    return "application/octet-stream";
+  }
+
+  // True if the If-None-Match header lists the ETag or is "*". Weak validators (W/"...") match too.
+  static bool etagMatches(std::string_view ifNoneMatch, std::string_view etag) {
+    if (ifNoneMatch.empty()) return false;
+    if (ifNoneMatch == "*") return true;
+    std::size_t position = 0;
+    while ((position = ifNoneMatch.find(etag, position)) != std::string_view::npos) {
+      const std::size_t end = position + etag.size();
+      const bool startsToken = position == 0 || ifNoneMatch[position - 1] == ' ' || ifNoneMatch[position - 1] == ',' || ifNoneMatch[position - 1] == '/';
+      const bool endsToken = end == ifNoneMatch.size() || ifNoneMatch[end] == ',' || ifNoneMatch[end] == ' ';
+      if (startsToken && endsToken) return true;
+      position = end;
+    }
+    return false;
+  }
+
+  // True if Accept-Encoding accepts gzip: listed with a q value above 0, or not listed and "*" is.
+  // "gzip;q=0", "gzip;q=0.000" refuse it, other codings ("x-gzip", "gzip2") don't count.
+  static bool acceptsGzip(std::string_view acceptEncoding) {
+    std::optional<bool> gzip;
+    std::optional<bool> any;
+    while (!acceptEncoding.empty()) {
+      const std::string_view element = nextToken(acceptEncoding, ',');
+      std::string_view parameters = element;
+      const std::string_view coding = nextToken(parameters, ';');
+      const bool accepted = qValue(parameters) > 0;
+      if (equalsIgnoreCase(coding, "gzip")) {
+        gzip = accepted;
+      } else if (coding == "*") {
+        any = accepted;
+      }
+    }
+    return gzip ? *gzip : any.value_or(false);
+  }
+
+ private:
+  struct Variant {
+    MappedFile body;
+    std::string etag;
+  };
+
+  struct Entry {
+    std::string_view contentType;
+    Variant plain;
+    std::optional<Variant> gzip;
+  };
+
+  static Variant load(const std::string& path, std::string_view suffix) {
+    Variant variant{MappedFile(path), {}};
+    uint64_t hash = 14695981039346656037ull;  // FNV-1a 64 over the content, the pages get loaded once here
+    for (std::size_t i = 0; i < variant.body.size(); ++i) {
+      hash = (hash ^ variant.body.data()[i]) * 1099511628211ull;
+    }
+    static constexpr char digits[] = "0123456789abcdef";
+    variant.etag = "\"";
+    for (int shift = 60; shift >= 0; shift -= 4) variant.etag += digits[(hash >> shift) & 0xF];
+    variant.etag.append(suffix).append("\"");
+    return variant;
+  }
+
+  // The text up to `separator` without surrounding spaces, removed from `list` with the separator
+  static std::string_view nextToken(std::string_view& list, char separator) {
+    const std::size_t end = list.find(separator);
+    std::string_view token = list.substr(0, end);
+    list.remove_prefix(end == std::string_view::npos ? list.size() : end + 1);
+    while (!token.empty() && (token.front() == ' ' || token.front() == '\t')) token.remove_prefix(1);
+    while (!token.empty() && (token.back() == ' ' || token.back() == '\t')) token.remove_suffix(1);
+    return token;
+  }
+
+  // The q parameter of an Accept-Encoding element (";q=0.5"): 1 without one, 0 if it isn't a number
+  static double qValue(std::string_view parameters) {
+    while (!parameters.empty()) {
+      const std::string_view parameter = nextToken(parameters, ';');
+      if (parameter.size() < 2 || (parameter[0] != 'q' && parameter[0] != 'Q') || parameter[1] != '=') continue;
+      const std::string_view value = parameter.substr(2);
+      double q = 0;
+      const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), q);
+      return error == std::errc() && end == value.data() + value.size() ? q : 0;
+    }
+    return 1;
+  }
+
+  static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+             return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+  }
+
+  // Heterogeneous lookup: a request URL is found without building a std::string
+  struct UrlHash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view url) const { return std::hash<std::string_view>()(url); }
+  };
+
+  // Only URLs of directories ("/", "/dir/") allocate: the index file name is appended
+  const Entry* find(std::string_view url) const {
+    auto it = files_.end();
+    if (url.empty() || url.back() == '/') {
+      it = files_.find(std::string(url) + options_.index);
+    } else {
+      it = files_.find(url);
+    }
+    return it == files_.end() ? nullptr : &it->second;
+  }
+
+  Options options_;
+  std::unordered_map<std::string, Entry, UrlHash, std::equal_to<>> files_;  // By URL path
+  std::size_t gzipCount_ = 0;
+  uint64_t bytes_ = 0;
+};
+
+// The baseline: open and read the file for every request, like a handler without a cache.
+// Rejects paths with "..", 404 for what isn't a readable regular file.
+template <bool SSL>
+void serveFromDisk(uWS::HttpResponse<SSL>* res, uWS::HttpRequest* req, const std::string& root) {
+  const std::string_view url = req->getUrl();
+  std::string path = root + std::string(url);
+  if (url.find("..") != std::string_view::npos) path.clear();
+  if (!path.empty() && path.back() == '/') path += "index.html";
+  std::error_code error;
+  std::ifstream file;
+  if (!path.empty() && std::filesystem::is_regular_file(path, error)) file.open(path, std::ios::binary);
+  if (!file.is_open()) {
+    res->writeStatus("404 Not Found")->end("Not found");
+    return;
+  }
+  const std::string body((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  res->writeHeader("Content-Type", StaticFileCache::contentType(url))->end(body);
+}
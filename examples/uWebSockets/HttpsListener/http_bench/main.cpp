@@ -0,0 +1,328 @@
+// HTTP load of the HttpsListener handlers, wrk style: keep-alive connections, one request in flight on each.
+//
+// For every --sizes file size and every --modes mode the server runs in this process (one App on a thread of its
+// own) and `connections` clients over `threads` uSockets loops request the same file as fast as the answers come:
+// - cache: StaticFileCache, the body is sent from the mapping, headers precomputed;
+// - read:  serveFromDisk, the file is opened and read into a string for every request;
+// - 304:   StaticFileCache, the requests carry If-None-Match with the ETag: revalidations, no body.
+// The files are random bytes in a temporary directory, read mode reads them from the page cache: the difference is
+// the open/read/close, the allocation and the copies per request, not the disk.
+// Requests, body bytes and request to response latency are counted from the end of the warm-up to the deadline.
+// Every answer is checked: status 200 with the size of the file (304 in 304 mode), anything else is an error.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../StaticFileCache.h"
+#include "App.h"
+#include "cxxopts.hpp"
+
+#include "../../../uSockets/common/ClientLoad.h"
+
+using Clock = std::chrono::steady_clock;
+
+int ssl = 1;  // Set once from --plain before the threads start
+
+enum class Mode { Cache, Read, NotModified };
+
+Mode modeFromName(const std::string& name) {
+  if (name == "cache") return Mode::Cache;
+  if (name == "read") return Mode::Read;
+  if (name == "304") return Mode::NotModified;
+  throw std::invalid_argument("Unknown mode: " + name);
+}
+
+struct LoadConfig {
+  int port = 3001;
+  std::size_t connections = 64;
+  std::size_t threads = 2;
+  std::chrono::milliseconds warmUp{1000};
+  std::chrono::milliseconds duration{5000};
+};
+
+struct LoadResult {
+  std::string mode;
+  std::size_t fileSize = 0;
+  std::size_t connected = 0;
+  double requestsPerSec = 0;
+  double megabytesPerSec = 0;  // Bodies only
+  double p50us = 0;
+  double p99us = 0;
+  double maxUs = 0;
+  uint64_t errors = 0;
+};
+
+// Responses of one keep-alive connection, framed by Content-Length: uWS sends a response ended at once with it, a 304
+// from endWithoutBody() has none and no body.
+class ResponseParser {
+ public:
+  static constexpr std::size_t maxHeaderBytes = 16 * 1024;
+
+  // Calls onResponse(status, bodySize) for every complete response. Throws std::runtime_error on a malformed header.
+  template <typename OnResponse>
+  void consume(std::string_view data, OnResponse&& onResponse) {
+    while (!data.empty()) {
+      if (bodyLeft_ > 0) {
+        const std::size_t taken = std::min<std::size_t>(bodyLeft_, data.size());
+        bodyLeft_ -= taken;
+        data.remove_prefix(taken);
+        if (bodyLeft_ == 0) onResponse(status_, bodySize_);
+        continue;
+      }
+      const std::size_t before = header_.size();
+      header_.append(data.substr(0, maxHeaderBytes - before));  // Only what a header can take: bodies aren't copied
+      const std::size_t end = header_.find("\r\n\r\n", before >= 3 ? before - 3 : 0);
+      if (end == std::string::npos) {
+        if (header_.size() >= maxHeaderBytes) throw std::runtime_error("Response header too large");
+        return;
+      }
+      data.remove_prefix(end + 4 - before);
+      parseHeader(std::string_view(header_).substr(0, end));
+      header_.clear();
+      bodyLeft_ = bodySize_;
+      if (bodySize_ == 0) onResponse(status_, bodySize_);
+    }
+  }
+
+ private:
+  void parseHeader(std::string_view header) {
+    if (header.size() < 12 || !header.starts_with("HTTP/1.1 ")) throw std::runtime_error("Not an HTTP/1.1 response");
+    status_ = std::stoi(std::string(header.substr(9, 3)));
+    bodySize_ = 0;
+    std::size_t position = header.find("\r\nContent-Length: ");
+    if (position == std::string_view::npos) position = header.find("\r\ncontent-length: ");
+    if (position != std::string_view::npos) bodySize_ = std::stoull(std::string(header.substr(position + 18, 20)));
+  }
+
+  std::string header_;  // Of the response being received
+  int status_ = 0;
+  std::size_t bodySize_ = 0;
+  std::size_t bodyLeft_ = 0;
+};
+
+// One client thread: the same request on every connection, one in flight, every answer checked
+struct HttpClient : ClientLoadThread {
+  struct Connection {
+    ResponseParser parser;
+    Clock::time_point sentAt;
+  };
+
+  std::string request;  // The same for every request
+  int expectedStatus = 200;
+  std::size_t expectedBodySize = 0;
+  uint64_t requests = 0;  // Inside the measurement window
+  uint64_t bodyBytes = 0;
+
+  void onOpen(Connection& connection, WriteBuffer& writes) { sendRequest(connection, writes); }
+
+  // Throws std::runtime_error on a malformed response
+  void onData(Connection& connection, std::string_view data, WriteBuffer& writes) {
+    bool answered = false;
+    connection.parser.consume(data, [&](int status, std::size_t bodySize) {
+      const auto now = Clock::now();
+      answered = true;
+      if (status != expectedStatus || bodySize != expectedBodySize) {
+        ++errors;  // Another status or size
+        return;
+      }
+      if (!measuring(now)) return;
+      ++requests;
+      bodyBytes += bodySize;
+      latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - connection.sentAt).count());
+    });
+    if (answered && !stopping) sendRequest(connection, writes);
+  }
+
+  void sendRequest(Connection& connection, WriteBuffer& writes) {
+    connection.sentAt = Clock::now();
+    writes.append(request);
+  }
+};
+
+// One App on a thread of its own, serving `root` in one mode until destroyed
+template <bool SSL>
+class BenchServer {
+ public:
+  // Throws std::runtime_error if it can't listen on the port.
+  BenchServer(int port, const std::string& root, Mode mode, const StaticFileCache& cache) {
+    thread_ = std::thread([this, port, &root, mode, &cache]() { run(port, root, mode, cache); });
+    while (state_.load() == 0) std::this_thread::yield();
+    if (state_.load() < 0) {
+      thread_.join();
+      throw std::runtime_error("Failed to listen on port " + std::to_string(port));
+    }
+  }
+
+  BenchServer(const BenchServer&) = delete;
+
+  BenchServer& operator=(const BenchServer&) = delete;
+
+  // Closes the App with its connections: the loop returns once nothing is open
+  ~BenchServer() {
+    loop_->defer([this]() { app_->close(); });
+    thread_.join();
+  }
+
+ private:
+  void run(int port, const std::string& root, Mode mode, const StaticFileCache& cache) {
+    uWS::TemplatedApp<SSL> app({.key_file_name = "server.key", .cert_file_name = "server.crt", .passphrase = "123Qwe!"});
+    loop_ = uWS::Loop::get();
+    app_ = &app;
+    bool listening = false;
+    app.get("/*", [&root, mode, &cache](auto* res, auto* req) {
+         if (mode == Mode::Read) {
+           serveFromDisk(res, req, root);
+         } else {
+           cache.serve(res, req);
+         }
+       })
+        .listen(port, [&listening](auto* listenSocket) {
+          listening = listenSocket != nullptr;
+        });
+    state_ = listening ? 1 : -1;  // Publishes loop_ and app_ to the constructor
+    if (!listening) return;
+
+    app.run();
+  }
+
+  uWS::Loop* loop_ = nullptr;
+  uWS::TemplatedApp<SSL>* app_ = nullptr;
+  std::atomic<int> state_{0};  // 0 - starting, 1 - listening, -1 - failed to listen
+  std::thread thread_;
+};
+
+template <bool SSL>
+LoadResult runMode(const LoadConfig& config, const std::string& root, const StaticFileCache& cache, const std::string& modeName, std::size_t fileSize) {
+  const Mode mode = modeFromName(modeName);
+  const std::string url = "/file-" + std::to_string(fileSize) + ".bin";
+  std::string request = "GET " + url + " HTTP/1.1\r\nHost: localhost\r\n";
+  if (mode == Mode::NotModified) request += "If-None-Match: " + std::string(cache.etag(url)) + "\r\n";
+  request += "\r\n";
+
+  BenchServer<SSL> server(config.port, root, mode, cache);
+  const auto measureFrom = Clock::now() + config.warmUp;  // Includes connection setup
+  const auto deadline = measureFrom + config.duration;
+
+  ClientLoadOptions load;
+  load.port = config.port;
+  load.ssl = ssl;
+  load.connections = config.connections;
+  load.threads = config.threads;
+  load.measureFrom = measureFrom;
+  load.deadline = deadline;
+  const auto clients = ClientLoad<HttpClient>::run(load, [&request, mode, fileSize](std::size_t /*thread*/) {
+    HttpClient client;
+    client.request = request;
+    client.expectedStatus = mode == Mode::NotModified ? 304 : 200;
+    client.expectedBodySize = mode == Mode::NotModified ? 0 : fileSize;
+    return client;
+  });
+
+  LoadResult result{.mode = modeName, .fileSize = fileSize};
+  ClientLoadThread total;
+  uint64_t requests = 0;
+  uint64_t bodyBytes = 0;
+  for (auto& client : clients) {
+    total.merge(client);
+    requests += client.requests;
+    bodyBytes += client.bodyBytes;
+  }
+  result.connected = total.connected;
+  result.errors = total.errors + total.connectErrors;
+  const double seconds = std::chrono::duration<double>(config.duration).count();
+  result.requestsPerSec = requests / seconds;
+  result.megabytesPerSec = bodyBytes / seconds / (1024 * 1024);
+  result.p50us = total.latencies.percentile(50) / 1000.0;
+  result.p99us = total.latencies.percentile(99) / 1000.0;
+  result.maxUs = total.latencies.max() / 1000.0;
+  return result;
+}
+
+// "file-<size>.bin" of random bytes for every size
+void writeFiles(const std::filesystem::path& root, const std::vector<std::size_t>& sizes) {
+  std::mt19937_64 rng(42);
+  for (auto size : sizes) {
+    std::string bytes(size, '\0');
+    for (auto& byte : bytes) byte = static_cast<char>(rng());
+    std::ofstream(root / ("file-" + std::to_string(size) + ".bin"), std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  }
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "HTTP load of the HttpsListener handlers: StaticFileCache vs a read per request");
+  // clang-format off
+  options.add_options()
+      ("p,port", "Port of the in-process server", cxxopts::value<int>()->default_value("3001"))
+      ("plain", "HTTP without TLS")
+      ("c,connections", "Keep-alive connections, one request in flight each", cxxopts::value<std::size_t>()->default_value("64"))
+      ("t,threads", "Client threads, one loop each", cxxopts::value<std::size_t>()->default_value("2"))
+      ("s,sizes", "File sizes in bytes, list", cxxopts::value<std::vector<std::size_t>>()->default_value("1024,65536,1048576"))
+      ("m,modes", "cache, read and/or 304, list", cxxopts::value<std::vector<std::string>>()->default_value("cache,read,304"))
+      ("w,warm-up", "Warm-up in milliseconds, includes connection setup", cxxopts::value<std::size_t>()->default_value("1000"))
+      ("duration", "Measurement in milliseconds", cxxopts::value<std::size_t>()->default_value("5000"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  LoadConfig config;
+  config.port = args["port"].as<int>();
+  config.connections = std::max<std::size_t>(1, args["connections"].as<std::size_t>());
+  config.threads = std::max<std::size_t>(1, args["threads"].as<std::size_t>());
+  config.warmUp = std::chrono::milliseconds(args["warm-up"].as<std::size_t>());
+  config.duration = std::chrono::milliseconds(std::max<std::size_t>(1, args["duration"].as<std::size_t>()));
+  ssl = args.count("plain") ? 0 : 1;
+  const auto sizes = args["sizes"].as<std::vector<std::size_t>>();
+  const auto modes = args["modes"].as<std::vector<std::string>>();
+
+  namespace fs = std::filesystem;
+  const fs::path root = fs::temp_directory_path() / ("uws_http_bench_" + std::to_string(std::random_device()()));
+  std::vector<LoadResult> results;
+  try {
+    for (auto& mode : modes) modeFromName(mode);  // Before any run
+    fs::create_directories(root);
+    writeFiles(root, sizes);
+    const StaticFileCache cache(root.string());
+    for (auto size : sizes) {
+      for (auto& mode : modes) {
+        std::cout << "Running " << mode << ", " << size << " bytes..." << std::endl;
+        results.push_back(ssl ? runMode<true>(config, root.string(), cache, mode, size) : runMode<false>(config, root.string(), cache, mode, size));
+      }
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    fs::remove_all(root);
+    return 1;
+  }
+  fs::remove_all(root);
+
+  std::cout << "\ntls=" << ssl << " connections=" << config.connections << " client threads=" << config.threads
+            << " cores=" << std::thread::hardware_concurrency() << "\n\n";
+  std::cout << std::left << std::setw(12) << "file bytes" << std::setw(8) << "mode" << std::setw(11) << "connected" << std::setw(13)
+            << "requests/s" << std::setw(10) << "MB/s" << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(11)
+            << "max us" << "errors" << std::endl;
+  for (auto& r : results) {
+    std::cout << std::left << std::setw(12) << r.fileSize << std::setw(8) << r.mode << std::setw(11) << r.connected << std::fixed
+              << std::setprecision(0) << std::setw(13) << r.requestsPerSec << std::setprecision(1) << std::setw(10) << r.megabytesPerSec
+              << std::setw(10) << r.p50us << std::setw(10) << r.p99us << std::setw(11) << r.maxUs << r.errors
+              << (r.connected < config.connections ? " (not all connected)" : "") << std::endl;
+  }
+  return 0;
+}
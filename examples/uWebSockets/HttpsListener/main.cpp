@@ -1,16 +1,44 @@
 // Example copied from: https://github.com/uNetworking/uWebSockets/blob/master/examples/HelloWorld.cpp
+// USAGE: uWebSockets_HttpsListener_minimalProject [root] [cache|read]
+// Without `root`: Hello world. With it: the static files of `root`, from a StaticFileCache (cache, default) or read
+// from disk for every request (read).
+
+#include <iostream>
+#include <optional>
+#include <string>
 
 #include "App.h"
+#include "StaticFileCache.h"
 
 /* Note that uWS::SSLApp({options}) is the same as uWS::App() when compiled without SSL support */
 
-int main() {
-  /* Overly simple hello world app */
+int main(int argc, char* argv[]) {
+  const std::string root = argc > 1 ? argv[1] : "";
+  const bool cached = argc <= 2 || std::string(argv[2]) != "read";
+
+  std::optional<StaticFileCache> cache;  // Outlives the App: responses stream from its mappings
+  if (!root.empty() && cached) {
+    try {
+      cache.emplace(root);
+    } catch (std::exception& e) {
+      std::cerr << "Exception: " << e.what() << std::endl;
+      return 1;
+    }
+    std::cout << "Cached " << cache->fileCount() << " files of " << root << ", " << cache->bytes() / 1024 << " KiB, "
+              << cache->gzipCount() << " with a .gz variant" << std::endl;
+  }
+
   uWS::SSLApp({.key_file_name = "server.key",
                .cert_file_name = "server.crt",
                .passphrase = "123Qwe!"})
-      .get("/*", [](auto* res, auto* /*req*/) {
-        res->end("Hello world!");
+      .get("/*", [&root, &cache](auto* res, auto* req) {
+        if (cache) {
+          cache->serve(res, req);
+        } else if (!root.empty()) {
+          serveFromDisk(res, req, root);
+        } else {
+          res->end("Hello world!"); /* Overly simple hello world app */
+        }
       })
       .listen(3000, [](auto* listen_socket) {
         if (listen_socket) {
@@ -21,4 +49,4 @@ int main() {
       .run();
 
   std::cout << "Failed to listen on port 3000" << std::endl;
-}
\ No newline at end of file
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "../LatencyHistogram.h"
+#include "App.h"
+
+// Backlog of one socket in power of two buckets: 136 bytes per socket where a LatencyHistogram takes 58 KB.
+// Bucket 0 counts backlogs below 1 KiB, bucket i those in [2^(9+i), 2^(10+i)), the last one everything above.
+class BacklogHistogram {
+ public:
+  static constexpr std::size_t bucketCount = 32;
+
+  void record(uint64_t bytes) {
+    ++counts_[std::min<std::size_t>(std::bit_width(bytes >> 10), bucketCount - 1)];
+    max_ = std::max(max_, bytes);
+  }
+
+  uint64_t count() const {
+    uint64_t total = 0;
+    for (auto count : counts_) total += count;
+    return total;
+  }
+
+  uint64_t max() const { return max_; }
+
+  // "samples=12 max=1536KiB <1KiB:2 <2KiB:3 <2048KiB:7", empty buckets are skipped
+  void print(std::ostream& out) const {
+    out << "samples=" << count() << " max=" << (max_ >> 10) << "KiB";
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+      if (counts_[i] == 0) continue;
+      out << " <" << (uint64_t{1} << i) << "KiB:" << counts_[i];
+    }
+  }
+
+ private:
+  uint32_t counts_[bucketCount] = {};
+  uint64_t max_ = 0;
+};
+
+// What happens to the messages of a WebSocket that reads slower than the server publishes.
+// uWS buffers what a socket can't take while its buffered amount is at most maxBackpressure (the send which crosses it
+// is still buffered whole). Once the buffered amount is above maxBackpressure it drops each further message and calls
+// the `dropped` handler with it: the policy takes over there, and sends what it kept from the `drain` handler once the
+// socket takes data again. The policy queue is bounded by maxQueuedBytes, so a socket holds at most
+// maxBackpressure + one message + maxQueuedBytes: one slow subscriber can't grow the server by gigabytes.
+// - DropStale:      queue the messages, drop those older than staleAfter when the socket drains.
+// - CoalesceLatest: keep only the latest message per key (coalesceKey, e.g. the topic): a slow client gets the
+//                   current values, not the history.
+// - Disconnect:     shut the socket down at its first dropped message, as closeOnBackpressureLimit does. There is
+//                   no close frame (1008 would be dropped like the message): the client sees the connection end.
+// Messages of the policy queue go out before any later publish: drain sends from the queue while uWS would take the
+// message, so it stops only with the socket above maxBackpressure, where uWS drops (and the policy queues) the next
+// publish. A socket which is never slow allocates nothing here.
+// Every dropped and drain event records the backlog of the socket (uWS buffer + policy queue) in the histogram of the
+// socket and in the histogram of all sockets. Used by one loop: one SlowConsumerPolicy per App.
+// USAGE EXAMPLE:
+// SlowConsumerPolicy policy({.policy = SlowConsumerPolicy::Policy::CoalesceLatest});
+// struct PerSocketData { SlowConsumerPolicy::Socket backlog; };
+// .maxBackpressure = policy.maxBackpressure(),
+// .closeOnBackpressureLimit = false,
+// .dropped = [&policy](auto* ws, std::string_view message, uWS::OpCode opCode) { policy.onDropped(ws, ws->getUserData()->backlog, message, opCode); },
+// .drain = [&policy](auto* ws) { policy.onDrain(ws, ws->getUserData()->backlog); },
+class SlowConsumerPolicy {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class Policy { DropStale, CoalesceLatest, Disconnect };
+
+  struct Options {
+    Policy policy = Policy::DropStale;
+    unsigned int maxBackpressure = 256 * 1024;  // The uWS limit of the WebSocketBehavior, use maxBackpressure()
+    std::size_t maxQueuedBytes = 1024 * 1024;   // Per socket, the oldest queued messages go beyond it
+    std::chrono::milliseconds staleAfter{2000};  // DropStale
+    // CoalesceLatest: messages with the same key replace each other. nullptr - one key: only the latest message
+    std::function<std::string_view(std::string_view message)> coalesceKey = nullptr;
+  };
+
+  // Totals of all sockets
+  struct Stats {
+    uint64_t queued = 0;           // Dropped by uWS, kept by the policy
+    uint64_t sent = 0;             // Sent from the policy queue
+    uint64_t coalesced = 0;        // Replaced by a later message with the same key
+    uint64_t droppedStale = 0;     // Older than staleAfter when the socket drained
+    uint64_t droppedOverflow = 0;  // Beyond maxQueuedBytes
+    uint64_t disconnected = 0;
+  };
+
+  // Policy state of one socket: a member of its PerSocketData
+  class Socket {
+   public:
+    std::size_t queuedBytes() const { return queuedBytes_; }
+
+    const BacklogHistogram& backlog() const { return backlog_; }
+
+   private:
+    friend class SlowConsumerPolicy;
+
+    struct Message {
+      std::string bytes;
+      uWS::OpCode opCode;
+      Clock::time_point queuedAt;
+    };
+
+    std::unique_ptr<std::deque<Message>> queue_;  // Created at the first dropped message
+    std::size_t queuedBytes_ = 0;
+    BacklogHistogram backlog_;
+    bool closing_ = false;
+  };
+
+  // "drop", "coalesce" or "disconnect". Throws std::invalid_argument for other names.
+  static Policy policyFromName(std::string_view name) {
+    if (name == "drop") return Policy::DropStale;
+    if (name == "coalesce") return Policy::CoalesceLatest;
+    if (name == "disconnect") return Policy::Disconnect;
+    throw std::invalid_argument("Unknown slow consumer policy: " + std::string(name));
+  }
+
+  SlowConsumerPolicy() : SlowConsumerPolicy(Options{}) {}
+
+  explicit SlowConsumerPolicy(Options options) : options_(std::move(options)) {}
+
+  unsigned int maxBackpressure() const { return options_.maxBackpressure; }
+
+  const Stats& stats() const { return stats_; }
+
+  // Backlog samples of all sockets, in bytes
+  const LatencyHistogram& backlog() const { return backlog_; }
+
+  // "queued=.. sent=.. coalesced=.. stale=.. overflow=.. disconnected=.. backlog p50=..KiB p99=..KiB max=..KiB"
+  void print(std::ostream& out) const {
+    out << "queued=" << stats_.queued << " sent=" << stats_.sent << " coalesced=" << stats_.coalesced << " stale=" << stats_.droppedStale
+        << " overflow=" << stats_.droppedOverflow << " disconnected=" << stats_.disconnected << " backlog p50=" << (backlog_.percentile(50) >> 10)
+        << "KiB p99=" << (backlog_.percentile(99) >> 10) << "KiB max=" << (backlog_.max() >> 10) << "KiB";
+  }
+
+  // From the `dropped` handler: `message` is only valid during the call, a queued message is copied
+  template <typename WebSocket>
+  void onDropped(WebSocket* ws, Socket& socket, std::string_view message, uWS::OpCode opCode) {
+    if (socket.closing_) return;
+    record(socket, ws->getBufferedAmount() + socket.queuedBytes_ + message.size());
+
+    if (options_.policy == Policy::Disconnect) {
+      socket.closing_ = true;
+      ++stats_.disconnected;
+      shutdown(ws);
+      return;
+    }
+
+    if (!socket.queue_) socket.queue_ = std::make_unique<std::deque<Socket::Message>>();
+    auto& queue = *socket.queue_;
+    if (options_.policy == Policy::CoalesceLatest) {
+      const std::string_view key = keyOf(message);
+      for (auto& queued : queue) {
+        if (queued.opCode != opCode || keyOf(queued.bytes) != key) continue;
+        socket.queuedBytes_ = socket.queuedBytes_ - queued.bytes.size() + message.size();
+        queued.bytes.assign(message);
+        queued.queuedAt = Clock::now();
+        ++stats_.coalesced;
+        trim(socket);
+        return;
+      }
+    }
+
+    queue.push_back({std::string(message), opCode, Clock::now()});
+    socket.queuedBytes_ += message.size();
+    ++stats_.queued;
+    trim(socket);
+  }
+
+  // From the `drain` handler: sends the queue while uWS takes messages, the buffered amount at most maxBackpressure
+  template <typename WebSocket>
+  void onDrain(WebSocket* ws, Socket& socket) {
+    record(socket, ws->getBufferedAmount() + socket.queuedBytes_);
+    if (!socket.queue_) return;
+    auto& queue = *socket.queue_;
+    const auto now = Clock::now();
+    while (!queue.empty() && ws->getBufferedAmount() <= options_.maxBackpressure && !socket.closing_) {
+      auto& message = queue.front();
+      if (options_.policy == Policy::DropStale && now - message.queuedAt > options_.staleAfter) {
+        ++stats_.droppedStale;
+      } else {
+        ws->send(message.bytes, message.opCode);  // Not above maxBackpressure: not dropped
+        ++stats_.sent;
+      }
+      socket.queuedBytes_ -= message.bytes.size();
+      queue.pop_front();
+    }
+  }
+
+ private:
+  std::string_view keyOf(std::string_view message) const { return options_.coalesceKey ? options_.coalesceKey(message) : std::string_view(); }
+
+  void record(Socket& socket, uint64_t bytes) {
+    socket.backlog_.record(bytes);
+    backlog_.record(bytes);
+  }
+
+  // Not close() or end(): the `dropped` handler may run from an App::publish walking the subscribers of a topic, and
+  // the close frame of end() would be dropped too. The read side is shut down, as closeOnBackpressureLimit does:
+  // uSockets sees the end of the stream and closes the socket from a later iteration of the loop.
+  template <bool SSL, bool isServer, typename UserData>
+  static void shutdown(uWS::WebSocket<SSL, isServer, UserData>* ws) {
+    us_socket_shutdown_read(SSL, reinterpret_cast<us_socket_t*>(ws));
+  }
+
+  void trim(Socket& socket) {
+    auto& queue = *socket.queue_;
+    while (socket.queuedBytes_ > options_.maxQueuedBytes && !queue.empty()) {
+      socket.queuedBytes_ -= queue.front().bytes.size();
+      queue.pop_front();
+      ++stats_.droppedOverflow;
+    }
+  }
+
+  Options options_;
+  Stats stats_;
+  LatencyHistogram backlog_;
+};
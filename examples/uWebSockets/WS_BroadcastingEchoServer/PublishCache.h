@@ -0,0 +1,73 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Messages of one publish round, built once per topic and publisher and reused for the rest of the round.
+// A round is one received message: it goes to every topic of the sender, through app->publish and ws->publish, each
+// with its own text. Building them with an std::ostringstream per publish allocated a stream and a string every time.
+// Here every text is built into a buffer which keeps its capacity from round to round: no allocation once the sizes
+// settle.
+//
+// uWS shares one copy of a published message between all subscribers of the topic, and frames it for every
+// subscriber on send: a header of 2 to 10 bytes and a copy of the payload. With permessage-deflate
+// (SHARED_COMPRESSOR) the send also compresses it per subscriber. The public API has no send of an already encoded
+// frame, so the payload is what can be cached.
+// USAGE EXAMPLE:
+// cache.begin(clientId, message);  // In the message handler, `message` must outlive the round
+// for (auto& topic : topics) app->publish(topic, cache.payload(PublishCache::Publisher::App, topic), opCode);
+// for (auto& topic : topics) ws->publish(topic, cache.payload(PublishCache::Publisher::Socket, topic), opCode);
+class PublishCache {
+ public:
+  // Who publishes: the texts say it
+  enum class Publisher { App, Socket };
+
+  // Starts a round. The payloads of the previous round become invalid.
+  void begin(long long clientId, std::string_view message) {
+    const auto result = std::to_chars(clientId_, clientId_ + sizeof(clientId_), clientId);
+    clientIdSize_ = static_cast<std::size_t>(result.ptr - clientId_);
+    message_ = message;
+    used_ = 0;
+  }
+
+  // The payload for the topic, built on the first call of the round for this publisher:
+  // "<clientId>: app->publish to topic=<topic> message=<message>" or "<clientId>:  ws->publish to topic=..."
+  std::string_view payload(Publisher publisher, std::string_view topic) {
+    for (std::size_t i = 0; i < used_; ++i) {
+      if (entries_[i].publisher == publisher && entries_[i].topic == topic) return entries_[i].payload;
+    }
+    if (used_ == entries_.size()) entries_.emplace_back();
+    Entry& entry = entries_[used_++];
+    entry.publisher = publisher;
+    entry.topic.assign(topic);
+    entry.payload.clear();
+    entry.payload.append(clientId_, clientIdSize_)
+        .append(publisher == Publisher::App ? ": app->publish to topic=" : ":  ws->publish to topic=")
+        .append(topic)
+        .append(" message=")
+        .append(message_);
+    ++built_;
+    return entry.payload;
+  }
+
+  // Payloads built since the start, one per topic, publisher and round
+  uint64_t built() const { return built_; }
+
+ private:
+  struct Entry {
+    Publisher publisher = Publisher::App;
+    std::string topic;
+    std::string payload;
+  };
+
+  std::vector<Entry> entries_;  // The first `used_` belong to the current round
+  std::size_t used_ = 0;
+  char clientId_[24] = {};
+  std::size_t clientIdSize_ = 0;
+  std::string_view message_;
+  uint64_t built_ = 0;
+};
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Topics and subscriptions of the sockets of one loop, for thousands of topics and a hundred thousand sockets.
+// - Topics are interned once: a TopicId (dense, from 0) instead of a string per socket and per publish.
+// - Every topic keeps a vector of its subscribers, publish walks contiguous ids.
+// - Every socket keeps its topics as a sparse bitmap: the topics are split in shards of 64 ids, and a socket stores
+//   one (shard, 64 bit mask) pair per shard it has topics in, sorted by shard. A socket with a few topics takes a few
+//   16 byte pairs, isSubscribed is a binary search and a bit test.
+// - publish() takes several topics and calls `deliver` once per subscriber of any of them, however many of the topics
+//   it matches: every subscriber carries the number of the last publish that reached it (no set, no hashing).
+// Not thread safe: used by one loop. `deliver` may remove subscribers (a send can close a socket, and its close
+// handler removes it): the removal waits for the end of the publish. It must not subscribe or unsubscribe.
+// Unsubscribing costs a scan of the subscribers of the topic: subscriptions change far less often than publishes.
+// USAGE EXAMPLE:
+// SubscriptionIndex<uWS::WebSocket<true, true, PerSocketData>*> index;
+// auto id = index.add(ws);                                                   // In open
+// index.subscribe(id, index.intern("prices"));
+// index.publish(topicIds, [&](auto* subscriber) { subscriber->send(payload, opCode); });
+// index.remove(id);                                                          // In close
+template <typename Subscriber>
+class SubscriptionIndex {
+ public:
+  using TopicId = uint32_t;
+  using SubscriberId = uint32_t;
+
+  static constexpr TopicId noTopic = std::numeric_limits<TopicId>::max();
+  static constexpr SubscriberId noSubscriber = std::numeric_limits<SubscriberId>::max();
+
+  // Id of the topic, created on first use. Ids are never reused: a topic stays known when it has no subscribers.
+  TopicId intern(std::string_view topic) {
+    auto it = topicIds_.find(topic);
+    if (it != topicIds_.end()) return it->second;
+    const auto id = static_cast<TopicId>(names_.size());
+    names_.emplace_back(topic);
+    topicIds_.emplace(names_.back(), id);
+    topicSubscribers_.emplace_back();
+    return id;
+  }
+
+  // noTopic if the topic was never interned
+  TopicId find(std::string_view topic) const {
+    auto it = topicIds_.find(topic);
+    return it == topicIds_.end() ? noTopic : it->second;
+  }
+
+  std::string_view name(TopicId topic) const { return names_[topic]; }
+
+  std::size_t topicCount() const { return names_.size(); }
+
+  std::size_t subscriberCount(TopicId topic) const { return topicSubscribers_[topic].size(); }
+
+  // A new subscriber without topics. Ids of removed subscribers are reused.
+  SubscriberId add(Subscriber subscriber) {
+    if (!free_.empty()) {
+      const SubscriberId id = free_.back();
+      free_.pop_back();
+      slots_[id].subscriber = subscriber;
+      return id;
+    }
+    slots_.push_back({0, subscriber});
+    shards_.emplace_back();
+    return static_cast<SubscriberId>(slots_.size() - 1);
+  }
+
+  // Unsubscribes from every topic
+  void remove(SubscriberId id) {
+    if (publishing_) {  // From `deliver`: not reached any more by this publish, erased after it
+      slots_[id].delivered = publish_;
+      pendingRemovals_.push_back(id);
+      return;
+    }
+    for (auto& shard : shards_[id]) {
+      for (uint64_t mask = shard.mask; mask; mask &= mask - 1) {
+        erase(topicSubscribers_[shard.index * 64 + std::countr_zero(mask)], id);
+      }
+    }
+    shards_[id].clear();
+    shards_[id].shrink_to_fit();
+    free_.push_back(id);
+  }
+
+  // False if it was subscribed already
+  bool subscribe(SubscriberId id, TopicId topic) {
+    auto& shards = shards_[id];
+    const uint32_t index = topic / 64;
+    const uint64_t bit = uint64_t{1} << (topic % 64);
+    auto it = std::lower_bound(shards.begin(), shards.end(), index, [](const Shard& shard, uint32_t i) { return shard.index < i; });
+    if (it == shards.end() || it->index != index) it = shards.insert(it, Shard{index, 0});
+    if (it->mask & bit) return false;
+    it->mask |= bit;
+    topicSubscribers_[topic].push_back(id);
+    return true;
+  }
+
+  // False if it wasn't subscribed
+  bool unsubscribe(SubscriberId id, TopicId topic) {
+    auto& shards = shards_[id];
+    auto it = findShard(shards, topic / 64);
+    const uint64_t bit = uint64_t{1} << (topic % 64);
+    if (it == shards.end() || !(it->mask & bit)) return false;
+    it->mask &= ~bit;
+    if (it->mask == 0) shards.erase(it);
+    erase(topicSubscribers_[topic], id);
+    return true;
+  }
+
+  bool isSubscribed(SubscriberId id, TopicId topic) const {
+    const auto& shards = shards_[id];
+    auto it = findShard(shards, topic / 64);
+    return it != shards.end() && (it->mask & (uint64_t{1} << (topic % 64)));
+  }
+
+  // Topics of the subscriber in increasing order, appended to `topics`
+  void topics(SubscriberId id, std::vector<TopicId>& topics) const {
+    for (auto& shard : shards_[id]) {
+      for (uint64_t mask = shard.mask; mask; mask &= mask - 1) {
+        topics.push_back(shard.index * 64 + std::countr_zero(mask));
+      }
+    }
+  }
+
+  // Calls deliver(subscriber) once for every subscriber of at least one of the topics, except `except`.
+  // Returns the number of deliveries.
+  template <typename Deliver>
+  std::size_t publish(std::span<const TopicId> topics, Deliver&& deliver, SubscriberId except = noSubscriber) {
+    if (++publish_ == 0) {  // Wrapped: no subscriber may look reached already
+      for (auto& slot : slots_) slot.delivered = 0;
+      publish_ = 1;
+    }
+    publishing_ = true;
+    const uint32_t publish = publish_;
+    Slot* slots = slots_.data();
+    std::size_t deliveries = 0;
+    for (TopicId topic : topics) {
+      const auto& subscribers = topicSubscribers_[topic];
+      const SubscriberId* ids = subscribers.data();
+      const std::size_t count = subscribers.size();
+      for (std::size_t i = 0; i < count; ++i) {
+        const SubscriberId id = ids[i];
+        Slot& slot = slots[id];
+        if (slot.delivered == publish || id == except) continue;
+        slot.delivered = publish;
+        std::invoke(deliver, slot.subscriber);
+        ++deliveries;
+      }
+    }
+    publishing_ = false;
+    for (SubscriberId id : pendingRemovals_) remove(id);
+    pendingRemovals_.clear();
+    return deliveries;
+  }
+
+  // Heap bytes of the index: the topic strings and their map are counted roughly
+  std::size_t memoryBytes() const {
+    std::size_t bytes = slots_.capacity() * sizeof(Slot) +
+                        shards_.capacity() * sizeof(std::vector<Shard>) + free_.capacity() * sizeof(SubscriberId) +
+                        topicSubscribers_.capacity() * sizeof(std::vector<SubscriberId>) + names_.size() * sizeof(std::string);
+    for (auto& shards : shards_) bytes += shards.capacity() * sizeof(Shard);
+    for (auto& subscribers : topicSubscribers_) bytes += subscribers.capacity() * sizeof(SubscriberId);
+    for (auto& name : names_) bytes += name.capacity() > 15 ? name.capacity() + 1 : 0;  // Beyond the small string buffer
+    bytes += topicIds_.size() * (sizeof(std::string_view) + sizeof(TopicId) + 2 * sizeof(void*)) + topicIds_.bucket_count() * sizeof(void*);
+    return bytes;
+  }
+
+ private:
+  // Hot data of a subscriber, what publish reads
+  struct Slot {
+    uint32_t delivered;  // The last publish which reached it
+    Subscriber subscriber;
+  };
+
+  struct Shard {
+    uint32_t index;  // Topics [index * 64, index * 64 + 64)
+    uint64_t mask;
+  };
+
+  template <typename Shards>
+  static auto findShard(Shards& shards, uint32_t index) {
+    auto it = std::lower_bound(shards.begin(), shards.end(), index, [](const Shard& shard, uint32_t i) { return shard.index < i; });
+    return it != shards.end() && it->index == index ? it : shards.end();
+  }
+
+  // Order of the subscribers of a topic doesn't matter: swap with the last
+  static void erase(std::vector<SubscriberId>& subscribers, SubscriberId id) {
+    auto it = std::find(subscribers.begin(), subscribers.end(), id);
+    if (it == subscribers.end()) return;
+    *it = subscribers.back();
+    subscribers.pop_back();
+  }
+
+  std::unordered_map<std::string_view, TopicId> topicIds_;  // Views of names_
+  std::deque<std::string> names_;                            // A deque: the strings never move
+  std::vector<std::vector<SubscriberId>> topicSubscribers_;  // By TopicId
+
+  std::vector<Slot> slots_;                 // By SubscriberId
+  std::vector<std::vector<Shard>> shards_;  // By SubscriberId: sparse topic bitmap, sorted by Shard::index
+  std::vector<SubscriberId> free_;
+  std::vector<SubscriberId> pendingRemovals_;  // Removed during a publish
+  bool publishing_ = false;
+  uint32_t publish_ = 0;
+};
@@ -0,0 +1,237 @@
+// Microbenchmark of the topic subscriptions of WS_BroadcastingEchoServer: topic strings vs SubscriptionIndex.
+//
+// `sockets` sockets subscribe to `per-socket` distinct topics out of `topics`, drawn with a Zipf distribution
+// (exponent `skew`, 0 - uniform): a few hot topics have most of the subscribers, as in a real feed.
+// A publish takes the topics of a random socket (the sender, as in the server) and delivers to their subscribers:
+// - strings: every socket keeps std::vector<std::string>, every topic is looked up by name in an unordered_map and
+//            delivered to separately, like one publish per topic. A socket in several of the topics gets duplicates.
+// - strings+set: the same, duplicates removed with an std::unordered_set per publish.
+// - index:   SubscriptionIndex, interned ids, one delivery per subscriber per publish.
+// A delivery copies `payload` bytes into a buffer of the socket, as uWS copies a frame into the socket buffer, and
+// counts it. A duplicate costs a delivery.
+// Reported: ns per subscription while subscribing everything, heap bytes per socket, ns per publish and per delivery,
+// duplicate deliveries.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../SubscriptionIndex.h"
+#include "cxxopts.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  double subscribeNs = 0;  // Per subscription
+  double bytesPerSocket = 0;
+  double publishNs = 0;   // Per publish
+  double deliveryNs = 0;  // Per delivery
+  double deliveries = 0;  // Per publish
+  double duplicates = 0;  // Per publish, strings only: sockets reached through several topics
+  uint64_t checksum = 0;
+};
+
+double nsSince(Clock::time_point start, std::size_t operations) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(std::max<std::size_t>(1, operations));
+}
+
+// Buffers of the sockets, what a delivery writes to
+class Outboxes {
+ public:
+  Outboxes(std::size_t sockets, std::size_t payload) : payload_(payload, 'x'), bytes_(sockets * slotsPerSocket * payload), received_(sockets, 0) {}
+
+  void deliver(uint32_t socket) {
+    const std::size_t slot = socket * slotsPerSocket + received_[socket]++ % slotsPerSocket;
+    std::memcpy(bytes_.data() + slot * payload_.size(), payload_.data(), payload_.size());
+  }
+
+  uint64_t checksum() const {
+    uint64_t sum = 0;
+    for (auto count : received_) sum += count;
+    return sum;
+  }
+
+ private:
+  static constexpr std::size_t slotsPerSocket = 4;
+
+  std::string payload_;
+  std::vector<char> bytes_;
+  std::vector<uint64_t> received_;
+};
+
+std::string topicName(uint32_t topic) {
+  return "topic-" + std::to_string(topic);
+}
+
+// Topics of every socket: distinct, Zipf distributed
+std::vector<std::vector<uint32_t>> makeSubscriptions(std::size_t sockets, std::size_t topics, std::size_t perSocket, double skew, std::mt19937_64& rng) {
+  std::vector<double> cdf(topics);
+  double sum = 0;
+  for (std::size_t i = 0; i < topics; ++i) {
+    sum += 1.0 / std::pow(static_cast<double>(i + 1), skew);
+    cdf[i] = sum;
+  }
+  std::uniform_real_distribution<double> uniform(0, sum);
+  perSocket = std::min(perSocket, topics);
+
+  std::vector<std::vector<uint32_t>> subscriptions(sockets);
+  for (auto& socketTopics : subscriptions) {
+    while (socketTopics.size() < perSocket) {
+      const auto topic = static_cast<uint32_t>(std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin());
+      if (std::find(socketTopics.begin(), socketTopics.end(), topic) == socketTopics.end()) socketTopics.push_back(std::min<uint32_t>(topic, topics - 1));
+    }
+  }
+  return subscriptions;
+}
+
+Result benchStrings(const std::vector<std::vector<uint32_t>>& subscriptions, const std::vector<uint32_t>& senders, std::size_t payload, bool dedupe) {
+  Result result;
+  const std::size_t sockets = subscriptions.size();
+  std::size_t subscriptionCount = 0;
+  for (auto& socketTopics : subscriptions) subscriptionCount += socketTopics.size();
+
+  std::vector<std::vector<std::string>> socketTopics(sockets);
+  std::unordered_map<std::string, std::vector<uint32_t>> topicSubscribers;
+  std::vector<std::vector<std::string>> requested(sockets);  // Built before the timing: a server receives the names
+  for (std::size_t s = 0; s < sockets; ++s) {
+    for (auto topic : subscriptions[s]) requested[s].push_back(topicName(topic));
+  }
+
+  auto start = Clock::now();
+  for (std::size_t s = 0; s < sockets; ++s) {
+    for (auto& name : requested[s]) {
+      socketTopics[s].push_back(name);
+      topicSubscribers[name].push_back(static_cast<uint32_t>(s));
+    }
+  }
+  result.subscribeNs = nsSince(start, subscriptionCount);
+
+  std::size_t bytes = socketTopics.capacity() * sizeof(std::vector<std::string>);
+  for (auto& topics : socketTopics) {
+    bytes += topics.capacity() * sizeof(std::string);
+    for (auto& name : topics) bytes += name.capacity() > 15 ? name.capacity() + 1 : 0;
+  }
+  for (auto& [name, subscribers] : topicSubscribers) {
+    bytes += sizeof(std::string) + sizeof(std::vector<uint32_t>) + 2 * sizeof(void*) + subscribers.capacity() * sizeof(uint32_t);
+  }
+  bytes += topicSubscribers.bucket_count() * sizeof(void*);
+  result.bytesPerSocket = static_cast<double>(bytes) / sockets;
+
+  Outboxes outboxes(sockets, payload);
+  std::unordered_set<uint32_t> reached;
+  uint64_t deliveries = 0;
+  start = Clock::now();
+  for (auto sender : senders) {
+    reached.clear();
+    for (auto& name : socketTopics[sender]) {
+      for (auto id : topicSubscribers.find(name)->second) {
+        if (dedupe && !reached.insert(id).second) continue;
+        outboxes.deliver(id);
+        ++deliveries;
+      }
+    }
+  }
+  const auto elapsed = Clock::now() - start;
+  result.publishNs = std::chrono::duration<double, std::nano>(elapsed).count() / senders.size();
+  result.deliveryNs = std::chrono::duration<double, std::nano>(elapsed).count() / std::max<uint64_t>(1, deliveries);
+  result.deliveries = static_cast<double>(deliveries) / senders.size();
+  result.checksum = outboxes.checksum();
+  return result;
+}
+
+Result benchIndex(const std::vector<std::vector<uint32_t>>& subscriptions, const std::vector<uint32_t>& senders, std::size_t payload) {
+  Result result;
+  const std::size_t sockets = subscriptions.size();
+  std::size_t subscriptionCount = 0;
+  for (auto& socketTopics : subscriptions) subscriptionCount += socketTopics.size();
+
+  std::vector<std::vector<std::string>> requested(sockets);
+  for (std::size_t s = 0; s < sockets; ++s) {
+    for (auto topic : subscriptions[s]) requested[s].push_back(topicName(topic));
+  }
+
+  SubscriptionIndex<uint32_t> index;
+  std::vector<SubscriptionIndex<uint32_t>::SubscriberId> ids(sockets);
+  auto start = Clock::now();
+  for (std::size_t s = 0; s < sockets; ++s) {
+    ids[s] = index.add(static_cast<uint32_t>(s));
+    for (auto& name : requested[s]) index.subscribe(ids[s], index.intern(name));
+  }
+  result.subscribeNs = nsSince(start, subscriptionCount);
+  result.bytesPerSocket = static_cast<double>(index.memoryBytes()) / sockets;
+
+  Outboxes outboxes(sockets, payload);
+  std::vector<SubscriptionIndex<uint32_t>::TopicId> topics;  // Reused, as in the server
+  uint64_t deliveries = 0;
+  start = Clock::now();
+  for (auto sender : senders) {
+    topics.clear();
+    index.topics(ids[sender], topics);
+    deliveries += index.publish(topics, [&outboxes](uint32_t socket) { outboxes.deliver(socket); });
+  }
+  const auto elapsed = Clock::now() - start;
+  result.publishNs = std::chrono::duration<double, std::nano>(elapsed).count() / senders.size();
+  result.deliveryNs = std::chrono::duration<double, std::nano>(elapsed).count() / std::max<uint64_t>(1, deliveries);
+  result.deliveries = static_cast<double>(deliveries) / senders.size();
+  result.checksum = outboxes.checksum();
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "Topic subscriptions: topic strings vs SubscriptionIndex");
+  // clang-format off
+  options.add_options()
+      ("n,sockets", "Sockets", cxxopts::value<std::size_t>()->default_value("100000"))
+      ("t,topics", "Topics", cxxopts::value<std::size_t>()->default_value("10000"))
+      ("k,per-socket", "Topics per socket", cxxopts::value<std::size_t>()->default_value("8"))
+      ("s,skew", "Zipf exponent of the topic popularity, 0 - uniform", cxxopts::value<double>()->default_value("1.0"))
+      ("payload", "Bytes copied per delivery", cxxopts::value<std::size_t>()->default_value("64"))
+      ("p,publishes", "Publishes, each to the topics of a random socket", cxxopts::value<std::size_t>()->default_value("2000"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  const std::size_t sockets = std::max<std::size_t>(1, args["sockets"].as<std::size_t>());
+  const std::size_t topics = std::max<std::size_t>(1, args["topics"].as<std::size_t>());
+  const std::size_t perSocket = std::max<std::size_t>(1, args["per-socket"].as<std::size_t>());
+  const double skew = std::max(0.0, args["skew"].as<double>());
+  const std::size_t publishes = std::max<std::size_t>(1, args["publishes"].as<std::size_t>());
+  const std::size_t payload = std::max<std::size_t>(1, args["payload"].as<std::size_t>());
+
+  std::mt19937_64 rng(42);
+  const auto subscriptions = makeSubscriptions(sockets, topics, perSocket, skew, rng);
+  std::vector<uint32_t> senders(publishes);
+  for (auto& sender : senders) sender = static_cast<uint32_t>(rng() % sockets);
+
+  Result strings = benchStrings(subscriptions, senders, payload, false);
+  const Result stringsSet = benchStrings(subscriptions, senders, payload, true);
+  strings.duplicates = strings.deliveries - stringsSet.deliveries;
+  const Result index = benchIndex(subscriptions, senders, payload);
+
+  std::cout << "sockets=" << sockets << " topics=" << topics << " per-socket=" << std::min(perSocket, topics) << " skew=" << skew
+            << " publishes=" << publishes << " payload=" << payload << "\n\n";
+  std::cout << std::left << std::setw(14) << "registry" << std::setw(16) << "subscribe ns" << std::setw(14) << "bytes/socket"
+            << std::setw(14) << "publish us" << std::setw(14) << "delivery ns" << std::setw(13) << "deliveries" << std::setw(13)
+            << "duplicates" << "checksum" << std::endl;
+  for (auto& [name, r] : {std::pair<std::string, Result>{"strings", strings}, {"strings+set", stringsSet}, {"index", index}}) {
+    std::cout << std::left << std::fixed << std::setprecision(1) << std::setw(14) << name << std::setw(16) << r.subscribeNs << std::setw(14)
+              << r.bytesPerSocket << std::setw(14) << r.publishNs / 1000 << std::setprecision(2) << std::setw(14) << r.deliveryNs
+              << std::setprecision(1) << std::setw(13) << r.deliveries << std::setw(13) << r.duplicates << r.checksum << std::endl;
+  }
+  return 0;
+}
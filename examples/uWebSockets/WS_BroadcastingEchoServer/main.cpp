@@ -1,29 +1,107 @@
 // Example from: https://github.com/uNetworking/uWebSockets/blob/master/examples/BroadcastingEchoServer.cpp
-
+//
+// Every received message is published to the topics of the sender, the texts built once per round by PublishCache.
+// With `quiet` nothing is printed per message; instead, every 5 seconds the CPU time per published message is printed.
+// Slow clients are handled by SlowConsumerPolicy (drop stale messages by default, coalesce keeps the latest message per
+// topic). The backlog histogram of a client which had one is printed at close.
+// Subscriptions live in a SubscriptionIndex by default: interned topic ids, and one delivery per subscriber for all
+// topics of the sender together. `topics` uses the uWS topic tree instead: app->publish and ws->publish per topic.
+// Load it with ../../uSockets/echo_bench: uSockets_echo_bench_minimalProject --port 9001 --protocol ws --tls
+//
+// USAGE: uWebSockets_WS_BroadcastingEchoServer_minimalProject [disabled|shared] [quiet|verbose] [drop|coalesce|disconnect] [index|topics]
+// shared - SHARED_COMPRESSOR (permessage-deflate), needs a build without UWS_NO_ZLIB
+
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
+#include <ctime>
 #include <random>
 #include <sstream>
+#include <string_view>
 
+#include "../SlowConsumerPolicy.h"
 #include "App.h"
+#include "PublishCache.h"
+#include "SubscriptionIndex.h"
 
 std::atomic<int> global_clientCount{0};
 struct us_listen_socket_t* global_listen_socket;
 constexpr int topicVariations = 4;
 constexpr int numberOfTopicsForClient = 2;
 
+// Publish cost over the last period. Only touched by the loop thread.
+struct PublishStats {
+  uint64_t published = 0;   // app->publish and ws->publish calls
+  uint64_t deliveries = 0;  // Subscribers the publishes went to
+  std::clock_t cpuFrom = std::clock();  // Process CPU time on POSIX
+};
+
+PublishStats global_publishStats;
+SlowConsumerPolicy* global_slowConsumerPolicy;
+
+// Coalescing key of a PublishCache payload: the topic of "<clientId>: app->publish to topic=<topic> message=<message>"
+std::string_view topicOf(std::string_view payload) {
+  const std::size_t begin = payload.find(" topic=");
+  if (begin == std::string_view::npos) return {};
+  const std::string_view rest = payload.substr(begin + 7);
+  return rest.substr(0, rest.find(' '));
+}
+
 int getRandomTopicNumber() {
   static std::random_device rd;
   static std::mt19937 gen(rd());
   return gen() % topicVariations;
 }
 
-int main() {
+// Prints the CPU time per published message and per delivery of the last period
+void printPublishStats(us_timer_t* /*timer*/) {
+  PublishStats& stats = global_publishStats;
+  const std::clock_t now = std::clock();
+  const double cpuUs = 1e6 * static_cast<double>(now - stats.cpuFrom) / CLOCKS_PER_SEC;
+  if (stats.published > 0) {
+    std::cout << "published " << stats.published << " messages, " << stats.deliveries << " deliveries, CPU per message "
+              << cpuUs / stats.published << " us, per delivery " << cpuUs / std::max<uint64_t>(1, stats.deliveries) << " us" << std::endl;
+  }
+  stats = PublishStats{};
+  stats.cpuFrom = now;
+  if (global_slowConsumerPolicy->backlog().count() > 0) {
+    std::cout << "slow consumers: ";
+    global_slowConsumerPolicy->print(std::cout);
+    std::cout << std::endl;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  const bool sharedCompressor = argc > 1 && std::string_view(argv[1]) == "shared";
+  const bool quiet = argc > 2 && std::string_view(argv[2]) == "quiet";
+#ifdef UWS_NO_ZLIB
+  if (sharedCompressor) {
+    std::cout << "This build defines UWS_NO_ZLIB: no permessage-deflate, compression stays DISABLED" << std::endl;
+  }
+  const uWS::CompressOptions compression = uWS::DISABLED;
+#else
+  const uWS::CompressOptions compression = sharedCompressor ? uWS::SHARED_COMPRESSOR : uWS::DISABLED;
+#endif
+  const bool compress = compression != uWS::DISABLED;
+  std::cout << "Compression: " << (compress ? "SHARED_COMPRESSOR" : "DISABLED") << std::endl;
+
+  const bool useIndex = !(argc > 4 && std::string_view(argv[4]) == "topics");
+  PublishCache publishCache;
+  SlowConsumerPolicy slowConsumerPolicy({.policy = SlowConsumerPolicy::policyFromName(argc > 3 ? argv[3] : "drop"), .coalesceKey = topicOf});
+  global_slowConsumerPolicy = &slowConsumerPolicy;
+
   /* ws->getUserData returns one of these */
   struct PerSocketData {
     /* Fill with user data */
-    std::vector<std::string> topics;
+    std::vector<std::string> topics;  // uWS topic tree
+    uint32_t subscriber = 0;          // SubscriptionIndex
+    std::string topicList;            // SubscriptionIndex: "1,3", part of the payload
+    SlowConsumerPolicy::Socket backlog;
   };
 
+  SubscriptionIndex<uWS::WebSocket<true, true, PerSocketData>*> subscriptionIndex;
+  std::vector<uint32_t> publishTopics;  // Reused by every publish
+
   /* Keep in mind that uWS::SSLApp({options}) is the same as uWS::App() when compiled without SSL support.
    * You may swap to using uWS:App() if you don't need SSL */
   uWS::SSLApp* app = new uWS::SSLApp({/* There are example certificates in uWebSockets.js repo */
@@ -32,16 +110,16 @@ int main() {
                                       .passphrase = "123Qwe!"});
 
   app->ws<PerSocketData>("/*", {/* Settings */
-                                .compression = uWS::DISABLED,
+                                .compression = compression,
                                 .maxPayloadLength = 16 * 1024 * 1024,
                                 .idleTimeout = 60,
-                                .maxBackpressure = 16 * 1024 * 1024,
+                                .maxBackpressure = slowConsumerPolicy.maxBackpressure(),
                                 .closeOnBackpressureLimit = false,
                                 .resetIdleTimeoutOnSend = true,
                                 .sendPingsAutomatically = false,
                                 /* Handlers */
                                 .upgrade = nullptr,
-                                .open = [](auto* ws) {
+                                .open = [&subscriptionIndex, useIndex](auto* ws) {
                                   /* Open event here, you may access ws->getUserData() which points to a PerSocketData struct */
 
                                   PerSocketData *perSocketData = (PerSocketData *) ws->getUserData();
@@ -49,48 +127,80 @@ int main() {
                                   auto clientId = (long long)(ws->getUserData());
 
                                   std::ostringstream topicsOss;
+                                  if (useIndex) perSocketData->subscriber = subscriptionIndex.add(ws);
                                   for (int i = 0; i < numberOfTopicsForClient; i++) {
                                     std::string topic = std::to_string(getRandomTopicNumber());
-                                    perSocketData->topics.push_back(topic);
-                                    ws->subscribe(topic);
+                                    if (useIndex) {
+                                      if (!subscriptionIndex.subscribe(perSocketData->subscriber, subscriptionIndex.intern(topic))) continue;
+                                      perSocketData->topicList += (perSocketData->topicList.empty() ? "" : ",") + topic;
+                                    } else {
+                                      perSocketData->topics.push_back(topic);
+                                      ws->subscribe(topic);
+                                    }
                                     topicsOss << topic << " ";
                                   }
                                   ++global_clientCount;
                                   std::cout << "client (" << clientId << ") connected and subscribed to topics:" << topicsOss.str() << ". total=" << global_clientCount.load() << std::endl;
                                   ws->send("You (" + std::to_string(clientId) + ") connected and subscribed to topics: " + topicsOss.str(), uWS::OpCode::TEXT); },
-                                .message = [&app](auto* ws, std::string_view message, uWS::OpCode opCode) {
-                                  std::cout << "recv: " << message << std::endl;
+                                .message = [&app, &publishCache, &subscriptionIndex, &publishTopics, useIndex, compress, quiet](auto* ws, std::string_view message, uWS::OpCode opCode) {
+                                  if (!quiet) std::cout << "recv: " << message << std::endl;
 
                                   PerSocketData *perSocketData = (PerSocketData *) ws->getUserData();
 
                                   auto clientId = (long long)(ws->getUserData());
 
-                                  for (auto topic : perSocketData->topics) {
-                                    std::ostringstream oss;
-                                    oss << clientId << ": app->publish to topic=" << topic << " message=" << message;
-                                    app->publish(topic, oss.str(), opCode); // CAN BE CALLED OUTSIDE OF WS HANDLER
-                                                                            // INCLUDE SENDING TO HIMSELF
+                                  publishCache.begin(clientId, message);
+                                  PublishStats& stats = global_publishStats;
+
+                                  if (useIndex) {
+                                    // One payload for all topics of the sender, sent once to every subscriber of any of them
+                                    // INCLUDE SENDING TO HIMSELF
+                                    const std::string_view payload = publishCache.payload(PublishCache::Publisher::App, perSocketData->topicList);
+                                    publishTopics.clear();
+                                    subscriptionIndex.topics(perSocketData->subscriber, publishTopics);
+                                    stats.deliveries += subscriptionIndex.publish(publishTopics, [&](auto* subscriber) {
+                                      subscriber->send(payload, opCode, compress);
+                                    });
+                                    ++stats.published;
+                                    return;
                                   }
 
-                                  for (auto topic : perSocketData->topics) {
-                                    std::ostringstream oss;
-                                    oss << clientId << ":  ws->publish to topic=" << topic << " message=" << message;
-                                    ws->publish(topic, oss.str(), opCode);  // CAN ONLY BE CALLED FROM WITHIN WS HANDLER
-                                                                            // EXCLUDE SENDING TO HIMSELF
+                                  for (auto& topic : perSocketData->topics) {
+                                    const std::string_view payload = publishCache.payload(PublishCache::Publisher::App, topic);
+                                    app->publish(topic, payload, opCode, compress); // CAN BE CALLED OUTSIDE OF WS HANDLER
+                                                                                    // INCLUDE SENDING TO HIMSELF
+                                    ++stats.published;
+                                    stats.deliveries += app->numSubscribers(topic);
+                                  }
+
+                                  for (auto& topic : perSocketData->topics) {
+                                    const std::string_view payload = publishCache.payload(PublishCache::Publisher::Socket, topic);
+                                    ws->publish(topic, payload, opCode, compress);  // CAN ONLY BE CALLED FROM WITHIN WS HANDLER
+                                                                                    // EXCLUDE SENDING TO HIMSELF
+                                    ++stats.published;
+                                    stats.deliveries += app->numSubscribers(topic) - 1;
                                   } },
-                                .drain = [](auto* /*ws*/) {
-                                  /* Check ws->getBufferedAmount() here */
-                                  // std::cout << "drain" << std::endl;
-                                },
+                                .dropped = [&slowConsumerPolicy](auto* ws, std::string_view message, uWS::OpCode opCode) {
+                                  /* uWS didn't send it: above maxBackpressure */
+                                  slowConsumerPolicy.onDropped(ws, ws->getUserData()->backlog, message, opCode); },
+                                .drain = [&slowConsumerPolicy](auto* ws) {
+                                  slowConsumerPolicy.onDrain(ws, ws->getUserData()->backlog); },
                                 .ping = [](auto* /*ws*/, std::string_view) {
                                   /* Not implemented yet */ },
                                 .pong = [](auto* /*ws*/, std::string_view) {
                                   /* Not implemented yet */ },
-                                .close = [](auto* ws, int /*code*/, std::string_view /*message*/) {
+                                .close = [&subscriptionIndex, useIndex](auto* ws, int /*code*/, std::string_view /*message*/) {
                                   /* You may access ws->getUserData() here */
+                                  if (useIndex) subscriptionIndex.remove(ws->getUserData()->subscriber);
                                   --global_clientCount;
                                   auto clientId = (long long)(ws->getUserData());
-                                  std::cout << "client (" << clientId << ") disconnected, total=" << global_clientCount.load() << std::endl; }})
+                                  std::cout << "client (" << clientId << ") disconnected, total=" << global_clientCount.load() << std::endl;
+                                  const auto& backlog = ws->getUserData()->backlog.backlog();
+                                  if (backlog.count() > 0) {
+                                    std::cout << "  backlog of the client: ";
+                                    backlog.print(std::cout);
+                                    std::cout << std::endl;
+                                  } }})
       .listen(9001, [](auto* listen_s) {
         if (listen_s) {
           std::cout << "Listening on port " << 9001 << std::endl;
@@ -98,6 +208,11 @@ int main() {
         }
       });
 
+  if (quiet) {
+    us_timer_t* statsTimer = us_create_timer((us_loop_t*)uWS::Loop::get(), 0, 0);
+    us_timer_set(statsTimer, printPublishStats, 5000, 5000);
+  }
+
   app->run();
 
   delete app;
@@ -1,19 +1,30 @@
 // Example from: https://github.com/uNetworking/uWebSockets/blob/master/examples/Broadcast.cpp
+//
+// A client slower than the broadcast is handled by SlowConsumerPolicy: coalesce by default, the latest timestamp is
+// all a slow client needs. Every 10 seconds the policy counters are printed, and at close the backlog histogram of
+// every socket which had one.
+//
+// USAGE: uWebSockets_Broadcast_minimalProject [coalesce|drop|disconnect]
 
 /* We simply call the root header file "App.h", giving you uWS::App and uWS::SSLApp */
 #include <time.h>
 
 #include <iostream>
 
+#include "../SlowConsumerPolicy.h"
 #include "App.h"
 
 /* This is a simple WebSocket echo server example.
  * You may compile it with "WITH_OPENSSL=1 make" or with "make" */
 
 uWS::SSLApp* globalApp;
+SlowConsumerPolicy* globalSlowConsumerPolicy;
 int globalSocketCount = 0;
 
-int main() {
+int main(int argc, char* argv[]) {
+  SlowConsumerPolicy slowConsumerPolicy({.policy = SlowConsumerPolicy::policyFromName(argc > 1 ? argv[1] : "coalesce")});
+  globalSlowConsumerPolicy = &slowConsumerPolicy;
+
   std::cout << "Broadcast WebSocket server\n"
                "How to use:\n"
                "  1. Start server (this file)\n"
@@ -24,6 +35,7 @@ int main() {
   /* ws->getUserData returns one of these */
   struct PerSocketData {
     /* Fill with user data */
+    SlowConsumerPolicy::Socket backlog;
   };
 
   /* Keep in mind that uWS::SSLApp({options}) is the same as uWS::App() when compiled without SSL support.
@@ -39,7 +51,7 @@ int main() {
                                                   .compression = uWS::SHARED_COMPRESSOR,
                                                   .maxPayloadLength = 16 * 1024 * 1024,
                                                   .idleTimeout = 16,
-                                                  .maxBackpressure = 1 * 1024 * 1024,
+                                                  .maxBackpressure = slowConsumerPolicy.maxBackpressure(),
                                                   .closeOnBackpressureLimit = false,
                                                   .resetIdleTimeoutOnSend = false,
                                                   .sendPingsAutomatically = true,
@@ -53,16 +65,25 @@ int main() {
                                                   .message = [](auto* /*ws*/, std::string_view /*message*/, uWS::OpCode /*opCode*/) {
 
                                                   },
-                                                  .drain = [](auto* /*ws*/) {
-                                                    /* Check ws->getBufferedAmount() here */ },
+                                                  .dropped = [&slowConsumerPolicy](auto* ws, std::string_view message, uWS::OpCode opCode) {
+                                                    /* uWS didn't send it: above maxBackpressure */
+                                                    slowConsumerPolicy.onDropped(ws, ws->getUserData()->backlog, message, opCode); },
+                                                  .drain = [&slowConsumerPolicy](auto* ws) {
+                                                    slowConsumerPolicy.onDrain(ws, ws->getUserData()->backlog); },
                                                   .ping = [](auto* /*ws*/, std::string_view) {
                                                     /* Not implemented yet */ },
                                                   .pong = [](auto* /*ws*/, std::string_view) {
                                                     /* Not implemented yet */ },
-                                                  .close = [](auto* /*ws*/, int /*code*/, std::string_view /*message*/) {
+                                                  .close = [](auto* ws, int /*code*/, std::string_view /*message*/) {
                                                     /* You may access ws->getUserData() here */
                                                     globalSocketCount--;
-                                                    std::cout << "client disconnected. globalSocketCount=" << globalSocketCount << std::endl; }})
+                                                    std::cout << "client disconnected. globalSocketCount=" << globalSocketCount << std::endl;
+                                                    const auto& backlog = ws->getUserData()->backlog.backlog();
+                                                    if (backlog.count() > 0) {
+                                                      std::cout << "  backlog of the client: ";
+                                                      backlog.print(std::cout);
+                                                      std::cout << std::endl;
+                                                    } }})
                         .listen(9001, [](auto* listen_socket) {
                           if (listen_socket) {
                             std::cout << "Listening on port " << 9001 << std::endl;
@@ -88,5 +109,12 @@ int main() {
 
     globalApp->publish("broadcast", std::string_view((char*)&millis, sizeof(millis)), uWS::OpCode::BINARY, false); }, delay, delay);
 
+  struct us_timer_t* statsTimer = us_create_timer(loop, 0, 0);
+  us_timer_set(statsTimer, [](struct us_timer_t* /*t*/) {
+    if (globalSlowConsumerPolicy->backlog().count() == 0) return;
+    std::cout << "Slow consumers: ";
+    globalSlowConsumerPolicy->print(std::cout);
+    std::cout << std::endl; }, 10000, 10000);
+
   app.run();
 }
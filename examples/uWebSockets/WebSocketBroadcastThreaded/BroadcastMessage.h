@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Binary message of the threaded broadcast, little endian like the machines it runs on:
+//   int64  unix time in milliseconds   (what client.html of WebSocketBroadcast shows)
+//   int64  steady clock nanoseconds     (publish time: subscribers on the same host get the latency)
+//   uint64 sequence number              (a gap is a message the server dropped for this subscriber)
+//   padding up to the requested size
+// std::chrono::steady_clock is CLOCK_MONOTONIC on Linux: the same clock in every process of the host.
+struct BroadcastMessage {
+  static constexpr std::size_t headerSize = 24;
+
+  uint64_t sequence = 0;
+  int64_t publishedNs = 0;
+
+  // A message published now
+  static std::string make(uint64_t sequence, std::size_t size) {
+    std::string bytes(size < headerSize ? headerSize : size, '\0');
+    const int64_t unixMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    const int64_t steadyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    std::memcpy(bytes.data(), &unixMs, 8);
+    std::memcpy(bytes.data() + 8, &steadyNs, 8);
+    std::memcpy(bytes.data() + 16, &sequence, 8);
+    return bytes;
+  }
+
+  // False if the bytes are too short to be a message
+  static bool parse(std::string_view bytes, BroadcastMessage& message) {
+    if (bytes.size() < headerSize) return false;
+    std::memcpy(&message.publishedNs, bytes.data() + 8, 8);
+    std::memcpy(&message.sequence, bytes.data() + 16, 8);
+    return true;
+  }
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../../PerThreadCounters.h"
+#include "App.h"
+
+// WebSocket broadcast over one uWS App per thread. Every App listens on the same port: uSockets sets SO_REUSEPORT,
+// so the kernel spreads the subscribers over the threads. Every connection subscribes to `topic`.
+//
+// An App, its topic tree and its sockets belong to the loop of its thread, Loop::defer is the only thread safe entry.
+// publish() therefore builds the message once, shares it between the loops and defers one App::publish to every
+// loop: each thread frames and sends it to its own subscribers, no locks on the send path.
+// The Apps run until stop() (or the destructor) closes them.
+// USAGE EXAMPLE:
+// BroadcastServer<false> server({.threads = 4, .port = 9001});
+// server.publish(BroadcastMessage::make(sequence, 64));  // From any thread
+template <bool SSL>
+class BroadcastServer {
+ public:
+  struct Options {
+    std::size_t threads = 0;  // 0 - hardware concurrency
+    int port = 9001;
+    std::string topic = "broadcast";
+    unsigned int maxBackpressure = 1 * 1024 * 1024;  // Per socket, a publish to a socket above it is dropped
+    uWS::SocketContextOptions tls = {.key_file_name = "server.key", .cert_file_name = "server.crt", .passphrase = "123Qwe!"};
+  };
+
+  // Counters of one thread. Written by its loop only, read by any thread.
+  struct alignas(cacheLineSize) Stats {
+    std::atomic<int64_t> subscribers{0};
+    std::atomic<uint64_t> published{0};  // App::publish calls run by the loop
+    std::atomic<uint64_t> dropped{0};    // Messages not sent to a socket above maxBackpressure
+  };
+
+  BroadcastServer() : BroadcastServer(Options{}) {}
+
+  // Throws std::runtime_error if a thread can't listen on the port.
+  explicit BroadcastServer(Options options) : options_(std::move(options)) {
+    if (options_.threads == 0) options_.threads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 0; i < options_.threads; ++i) {
+      threads_.push_back(std::make_unique<AppThread>());
+    }
+    for (auto& thread : threads_) {
+      thread->thread = std::thread([this, &thread = *thread]() { run(thread); });
+    }
+    for (auto& thread : threads_) {
+      while (thread->state.load() == 0) std::this_thread::yield();
+    }
+    for (auto& thread : threads_) {
+      if (thread->state.load() < 0) {
+        stop();
+        throw std::runtime_error("Failed to listen on port " + std::to_string(options_.port));
+      }
+    }
+  }
+
+  BroadcastServer(const BroadcastServer&) = delete;
+
+  BroadcastServer& operator=(const BroadcastServer&) = delete;
+
+  ~BroadcastServer() { stop(); }
+
+  std::size_t threadCount() const { return threads_.size(); }
+
+  const Stats& stats(std::size_t thread) const { return threads_[thread]->stats; }
+
+  // Thread safe, not after stop(). The message is copied once and shared by all loops.
+  void publish(std::string message, uWS::OpCode opCode = uWS::OpCode::BINARY) {
+    auto shared = std::make_shared<const std::string>(std::move(message));
+    for (auto& thread : threads_) {
+      thread->loop->defer([&thread = *thread, shared, opCode, this]() {
+        if (!thread.app) return;  // Closed
+        thread.app->publish(options_.topic, *shared, opCode, false);
+        add(thread.stats.published, uint64_t{1});
+      });
+    }
+  }
+
+  // Thread safe, a second call does nothing. Closes every App with its connections and joins the threads: the loops
+  // return once nothing is open.
+  void stop() {
+    std::lock_guard lock(stopMutex_);
+    for (auto& thread : threads_) {
+      if (thread->state.load() == 1 && thread->loop) {
+        thread->loop->defer([&thread = *thread]() {
+          if (thread.app) thread.app->close();
+          thread.app = nullptr;
+        });
+      }
+    }
+    for (auto& thread : threads_) {
+      if (thread->thread.joinable()) thread->thread.join();
+      // uWS frees the Loop of a thread when the thread exits (thread_local LoopCleaner): never defer to it again
+      thread->loop = nullptr;
+      if (thread->state.load() == 1) thread->state = 2;
+    }
+  }
+
+ private:
+  struct PerSocketData {};
+
+  struct AppThread {
+    Stats stats;
+    uWS::Loop* loop = nullptr;              // nullptr once the thread is joined: the Loop is freed with the thread
+    uWS::TemplatedApp<SSL>* app = nullptr;  // Only touched by the loop once it runs, nullptr once closed
+    std::atomic<int> state{0};              // 0 - starting, 1 - listening, 2 - stopped, -1 - failed to listen
+    std::thread thread;
+  };
+
+  void run(AppThread& thread) {
+    Stats& stats = thread.stats;
+    uWS::TemplatedApp<SSL> app(options_.tls);
+    thread.loop = uWS::Loop::get();  // Of this thread, created with the App
+    thread.app = &app;
+    bool listening = false;
+    app.template ws<PerSocketData>("/*", {/* Settings */
+                                          // UWS_NO_ZLIB: this build has no permessage-deflate
+                                          .compression = uWS::DISABLED,
+                                          .maxPayloadLength = 16 * 1024,
+                                          .idleTimeout = 60,
+                                          .maxBackpressure = options_.maxBackpressure,
+                                          .closeOnBackpressureLimit = false,
+                                          .resetIdleTimeoutOnSend = true,
+                                          .sendPingsAutomatically = true,
+                                          /* Handlers */
+                                          .upgrade = nullptr,
+                                          .open = [this, &stats](auto* ws) {
+                                            ws->subscribe(options_.topic);
+                                            add(stats.subscribers, int64_t{1}); },
+                                          .dropped = [&stats](auto* /*ws*/, std::string_view /*message*/, uWS::OpCode /*opCode*/) {
+                                            add(stats.dropped, uint64_t{1}); },
+                                          .close = [&stats](auto* /*ws*/, int /*code*/, std::string_view /*message*/) {
+                                            add(stats.subscribers, int64_t{-1}); }})
+        .listen(options_.port, [&listening](auto* listenSocket) {
+          listening = listenSocket != nullptr;
+        });
+    thread.state = listening ? 1 : -1;  // Publishes loop and app to the other threads
+    if (!listening) return;
+
+    app.run();
+  }
+
+  Options options_;
+  std::vector<std::unique_ptr<AppThread>> threads_;
+  std::mutex stopMutex_;
+};
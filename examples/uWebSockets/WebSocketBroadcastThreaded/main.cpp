@@ -0,0 +1,77 @@
+// Threaded version of WebSocketBroadcast: one uWS App per thread on port 9001, the main thread publishes to all.
+//
+// The main thread is not a uWS loop: BroadcastServer::publish defers the publish to the loop of every App. Every
+// `intervalMs` a BroadcastMessage goes out (unix millis first: client.html of WebSocketBroadcast shows it), and every
+// 4 seconds the subscribers, publishes and drops of every thread are printed.
+// Load it with subscribers/ (uWebSockets_BroadcastThreaded_subscribers_minimalProject), see README.md.
+//
+// USAGE: uWebSockets_BroadcastThreaded_minimalProject [threads] [intervalMs] [payloadBytes] [tls]
+// threads 0 - one per hardware thread (default), intervalMs 300, payloadBytes 24, tls 1 (wss://, server.crt/server.key)
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BroadcastMessage.h"
+#include "BroadcastServer.h"
+
+template <bool SSL>
+void run(std::size_t threads, std::chrono::milliseconds interval, std::size_t payload) {
+  BroadcastServer<SSL> server({.threads = threads, .port = 9001});
+  std::cout << "Listening on port 9001 with " << server.threadCount() << " threads (" << (SSL ? "wss" : "ws") << ")" << std::endl;
+
+  constexpr auto statsPeriod = std::chrono::seconds(4);
+  auto nextPublish = std::chrono::steady_clock::now();
+  auto nextStats = nextPublish + statsPeriod;
+  std::vector<uint64_t> lastPublished(server.threadCount(), 0);
+  for (uint64_t sequence = 0;; ++sequence) {
+    server.publish(BroadcastMessage::make(sequence, payload));
+    nextPublish += interval;
+    std::this_thread::sleep_until(nextPublish);
+
+    if (std::chrono::steady_clock::now() < nextStats) continue;
+    nextStats += statsPeriod;
+    int64_t subscribers = 0;
+    std::string perThread;
+    for (std::size_t i = 0; i < server.threadCount(); ++i) {
+      const auto& stats = server.stats(i);
+      subscribers += stats.subscribers.load(std::memory_order_relaxed);
+      perThread += " " + std::to_string(stats.subscribers.load(std::memory_order_relaxed));
+      const uint64_t published = stats.published.load(std::memory_order_relaxed);
+      if (published - lastPublished[i] == 0) perThread += "(stalled)";  // The loop didn't run a publish in 4 seconds
+      lastPublished[i] = published;
+    }
+    uint64_t dropped = 0;
+    for (std::size_t i = 0; i < server.threadCount(); ++i) dropped += server.stats(i).dropped.load(std::memory_order_relaxed);
+    std::cout << "Subscribers: " << subscribers << " (per thread:" << perThread << "), published: " << sequence + 1
+              << ", dropped: " << dropped << std::endl;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  std::size_t threads = argc > 1 ? std::stoul(argv[1]) : 0;
+  const auto interval = std::chrono::milliseconds(argc > 2 ? std::stoul(argv[2]) : 300);
+  const std::size_t payload = argc > 3 ? std::stoul(argv[3]) : BroadcastMessage::headerSize;
+  const bool tls = argc > 4 ? std::stoi(argv[4]) != 0 : true;
+
+  std::cout << "Threaded broadcast WebSocket server\n"
+               "How to use:\n"
+               "  1. Start server (this file)\n"
+               "  2. Open https://localhost:9001 to accept self-signed certificate\n"
+               "  3. Start ../WebSocketBroadcast/client.html in browser or the subscribers load tool\n"
+            << std::endl;
+
+  try {
+    if (tls) {
+      run<true>(threads, interval, payload);
+    } else {
+      run<false>(threads, interval, payload);
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+}
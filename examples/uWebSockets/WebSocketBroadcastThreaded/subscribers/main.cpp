@@ -0,0 +1,263 @@
+// Subscriber load tool of the threaded broadcast: many WebSocket subscribers over uSockets client loops.
+//
+// `threads` client threads run one uSockets loop each and share `connections` subscribers. Every received
+// BroadcastMessage is checked against the previous sequence number of its connection: a gap is a message the server
+// dropped for this subscriber (above maxBackpressure). Delivered messages and their publish to receive latency
+// (steady clock of the publisher to steady clock here: only meaningful on the same host) are counted from the end of
+// the warm-up to the deadline; the warm-up includes the connection setup.
+//
+// With --server-threads the server runs in this process: one BroadcastServer per listed thread count, one run each,
+// and a publisher thread publishing every --interval-us. Without it the subscribers connect to a running
+// uWebSockets_BroadcastThreaded_minimalProject, see README.md.
+// One source address has ~28k ephemeral ports to one server address: beyond that, spread the connections over several
+// --source-hosts (127.0.0.2, 127.0.0.3, ... all reach 127.0.0.1).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "cxxopts.hpp"
+
+#include "../../../uSockets/common/ClientLoad.h"
+#include "../../../uSockets/common/EchoProtocol.h"
+#include "../BroadcastMessage.h"
+#include "../BroadcastServer.h"
+
+using Clock = std::chrono::steady_clock;
+
+int ssl = 0;  // Set once from --tls before the threads start
+
+struct LoadConfig {
+  std::string host = "127.0.0.1";
+  int port = 9001;
+  std::vector<std::string> sourceHosts;  // Round robin per connection, empty - chosen by the kernel
+  std::size_t connections = 1000;
+  std::size_t threads = 2;
+  std::chrono::milliseconds warmUp{2000};
+  std::chrono::milliseconds duration{5000};
+};
+
+struct LoadResult {
+  std::size_t serverThreads = 0;  // 0 - external server
+  std::size_t connected = 0;
+  uint64_t published = 0;  // In-process server: messages published in the measurement window
+  double deliveredPerSec = 0;
+  uint64_t delivered = 0;
+  uint64_t missed = 0;  // Sequence gaps: dropped by the server for a slow subscriber
+  double p50us = 0;
+  double p99us = 0;
+  double p999us = 0;
+  double maxUs = 0;
+  uint64_t errors = 0;
+  uint64_t connectErrors = 0;
+};
+
+// One client thread: subscribers checking the sequence numbers of the broadcast
+struct SubscriberClient : ClientLoadThread {
+  struct Connection {
+    EchoProtocol::Connection parser;
+    std::string control;  // Answers to pings, from the parser
+    std::optional<uint64_t> lastSequence;
+  };
+
+  const LoadConfig* config = nullptr;
+  const EchoProtocol* protocol = nullptr;
+  uint64_t delivered = 0;  // Inside the measurement window
+  uint64_t missed = 0;
+
+  void onOpen(Connection& connection, WriteBuffer& writes) { writes.append(protocol->handshake(config->host, config->port)); }
+
+  void onData(Connection& connection, std::string_view data, WriteBuffer& writes) {
+    const auto now = Clock::now();
+    bool upgradedNow = false;
+    protocol->consume(data, connection.parser, connection.control, upgradedNow,
+                      [this, &connection, now](std::string_view payload) { onMessage(connection, payload, now); });
+    writes.append(connection.control);
+    connection.control.clear();
+  }
+
+  void onMessage(Connection& connection, std::string_view payload, Clock::time_point now) {
+    BroadcastMessage message;
+    if (!BroadcastMessage::parse(payload, message)) {
+      ++errors;
+      return;
+    }
+    const bool measured = measuring(now);
+    if (connection.lastSequence && message.sequence > *connection.lastSequence + 1 && measured) {
+      missed += message.sequence - *connection.lastSequence - 1;
+    }
+    connection.lastSequence = message.sequence;
+    if (!measured) return;
+    ++delivered;
+    const int64_t latencyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count() - message.publishedNs;
+    if (latencyNs >= 0) latencies.record(latencyNs);  // Negative: published on another host
+  }
+};
+
+LoadResult runClients(const LoadConfig& config, Clock::time_point measureFrom, Clock::time_point deadline) {
+  const EchoProtocol protocol(EchoProtocol::Kind::WebSocket, 1);  // Only the handshake and the frame parsing
+  ClientLoadOptions load;
+  load.host = config.host;
+  load.port = config.port;
+  load.ssl = ssl;
+  load.sourceHosts = config.sourceHosts;
+  load.connections = config.connections;
+  load.threads = config.threads;
+  load.measureFrom = measureFrom;
+  load.deadline = deadline;
+  const auto clients = ClientLoad<SubscriberClient>::run(load, [&config, &protocol](std::size_t /*thread*/) {
+    SubscriberClient client;
+    client.config = &config;
+    client.protocol = &protocol;
+    return client;
+  });
+
+  LoadResult result;
+  ClientLoadThread total;
+  for (auto& client : clients) {
+    total.merge(client);
+    result.delivered += client.delivered;
+    result.missed += client.missed;
+  }
+  result.connected = total.connected;
+  result.errors = total.errors;
+  result.connectErrors = total.connectErrors;
+  result.deliveredPerSec = result.delivered / std::chrono::duration<double>(config.duration).count();
+  result.p50us = total.latencies.percentile(50) / 1000.0;
+  result.p99us = total.latencies.percentile(99) / 1000.0;
+  result.p999us = total.latencies.percentile(99.9) / 1000.0;
+  result.maxUs = total.latencies.max() / 1000.0;
+  return result;
+}
+
+// One run against a BroadcastServer of this process, published to by a thread of its own
+template <bool SSL>
+LoadResult runInProcess(const LoadConfig& config, std::size_t serverThreads, std::chrono::microseconds interval, std::size_t payload) {
+  BroadcastServer<SSL> server({.threads = serverThreads, .port = config.port});
+  const auto measureFrom = Clock::now() + config.warmUp;  // Includes connection setup
+  const auto deadline = measureFrom + config.duration;
+
+  std::atomic<bool> publishing{true};
+  uint64_t published = 0;
+  std::thread publisher([&]() {
+    auto next = Clock::now();
+    for (uint64_t sequence = 0; publishing.load(std::memory_order_relaxed); ++sequence) {
+      const auto now = Clock::now();
+      server.publish(BroadcastMessage::make(sequence, payload));
+      if (now >= measureFrom && now < deadline) ++published;
+      next += interval;
+      std::this_thread::sleep_until(next);
+    }
+  });
+
+  LoadResult result = runClients(config, measureFrom, deadline);
+  publishing = false;
+  publisher.join();
+  result.serverThreads = server.threadCount();
+  result.published = published;
+  return result;
+}
+
+// Lets one process open `connections` sockets (plus the server side when it runs here)
+void raiseOpenFileLimit(std::size_t connections) {
+#ifndef _WIN32
+  rlimit limit{};
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return;
+  const rlim_t wanted = std::min<rlim_t>(limit.rlim_max, connections * 2 + 1024);
+  if (limit.rlim_cur >= wanted) return;
+  limit.rlim_cur = wanted;
+  setrlimit(RLIMIT_NOFILE, &limit);
+  if (wanted < connections * 2 + 1024) {
+    std::cout << "Open file limit " << wanted << " is low for " << connections << " connections: raise ulimit -n" << std::endl;
+  }
+#endif
+}
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(argv[0], "Subscriber load for the threaded broadcast: delivery rate, latency and drops");
+  // clang-format off
+  options.add_options()
+      ("host", "Server address", cxxopts::value<std::string>()->default_value("127.0.0.1"))
+      ("p,port", "Server port", cxxopts::value<int>()->default_value("9001"))
+      ("tls", "Connect with TLS (wss), an in-process server uses server.crt / server.key")
+      ("c,connections", "Subscribers", cxxopts::value<std::size_t>()->default_value("1000"))
+      ("t,threads", "Client threads, one loop each", cxxopts::value<std::size_t>()->default_value("2"))
+      ("source-hosts", "Local addresses to connect from, round robin, list", cxxopts::value<std::vector<std::string>>())
+      ("server-threads", "Run the server in this process with these thread counts, list. None - external server", cxxopts::value<std::vector<std::size_t>>())
+      ("interval-us", "In-process server: publish interval in microseconds", cxxopts::value<std::size_t>()->default_value("10000"))
+      ("s,payload", "In-process server: message size in bytes", cxxopts::value<std::size_t>()->default_value("64"))
+      ("w,warm-up", "Warm-up in milliseconds, includes connection setup", cxxopts::value<std::size_t>()->default_value("2000"))
+      ("duration", "Measurement in milliseconds", cxxopts::value<std::size_t>()->default_value("5000"))
+      ("h,help", "Print usage");
+  // clang-format on
+
+  auto args = options.parse(argc, argv);
+  if (args.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+
+  LoadConfig config;
+  config.host = args["host"].as<std::string>();
+  config.port = args["port"].as<int>();
+  if (args.count("source-hosts")) config.sourceHosts = args["source-hosts"].as<std::vector<std::string>>();
+  config.connections = std::max<std::size_t>(1, args["connections"].as<std::size_t>());
+  config.threads = std::max<std::size_t>(1, args["threads"].as<std::size_t>());
+  config.warmUp = std::chrono::milliseconds(args["warm-up"].as<std::size_t>());
+  config.duration = std::chrono::milliseconds(std::max<std::size_t>(1, args["duration"].as<std::size_t>()));
+  ssl = args.count("tls") ? 1 : 0;
+  const auto interval = std::chrono::microseconds(std::max<std::size_t>(1, args["interval-us"].as<std::size_t>()));
+  const std::size_t payload = args["payload"].as<std::size_t>();
+  std::vector<std::size_t> serverThreads;
+  if (args.count("server-threads")) {
+    for (auto count : args["server-threads"].as<std::vector<std::size_t>>()) {
+      if (count > 0) serverThreads.push_back(count);
+    }
+  }
+  raiseOpenFileLimit(config.connections);
+
+  std::vector<LoadResult> results;
+  try {
+    if (serverThreads.empty()) {
+      std::cout << "Subscribing " << config.connections << " connections to " << config.host << ":" << config.port << "..." << std::endl;
+      const auto measureFrom = Clock::now() + config.warmUp;
+      results.push_back(runClients(config, measureFrom, measureFrom + config.duration));
+    }
+    for (auto count : serverThreads) {
+      std::cout << "Running " << count << " server threads, " << config.connections << " subscribers..." << std::endl;
+      results.push_back(ssl ? runInProcess<true>(config, count, interval, payload) : runInProcess<false>(config, count, interval, payload));
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << "\n" << config.host << ":" << config.port << " tls=" << ssl << " subscribers=" << config.connections
+            << " client threads=" << config.threads << " cores=" << std::thread::hardware_concurrency() << "\n\n";
+  std::cout << std::left << std::setw(16) << "server threads" << std::setw(11) << "connected" << std::setw(11) << "published"
+            << std::setw(15) << "delivered/s" << std::setw(10) << "missed" << std::setw(10) << "p50 us" << std::setw(10) << "p99 us"
+            << std::setw(12) << "p99.9 us" << std::setw(11) << "max us" << "errors" << std::endl;
+  for (auto& r : results) {
+    std::cout << std::left << std::setw(16) << (r.serverThreads ? std::to_string(r.serverThreads) : "external") << std::setw(11) << r.connected
+              << std::setw(11) << (r.serverThreads ? std::to_string(r.published) : "-") << std::fixed << std::setprecision(0) << std::setw(15)
+              << r.deliveredPerSec << std::setw(10) << r.missed << std::setprecision(1) << std::setw(10) << r.p50us << std::setw(10) << r.p99us
+              << std::setw(12) << r.p999us << std::setw(11) << r.maxUs << r.errors + r.connectErrors
+              << (r.connected < config.connections ? " (not all connected)" : "") << std::endl;
+  }
+  std::cout << "\nExpected deliveries: published x connected. Missed: sequence gaps, messages the server dropped for a slow subscriber."
+            << std::endl;
+  return 0;
+}